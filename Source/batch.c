@@ -0,0 +1,357 @@
+/*
+ * DataType - device-aware batch scheduling
+ *
+ * Copyright (c) 2025 amigazen project
+ * Licensed under BSD 2-Clause License
+ */
+
+#include "datatype.h"
+
+/*
+ * With ORDER_DISK a batch is sorted before anything is read. Files are
+ * grouped by the filesystem that handles them. Within a volume they are
+ * ordered by directory, and directories by the lowest disk key of their
+ * files, so each head sweeps once. Files up to the load cutoff are then
+ * read ahead with asynchronous ACTION_READ packets: up to BATCH_READAHEAD
+ * per volume, each handler working through its own queue in order. All
+ * volumes are busy at once, and a file is handled as soon as its read
+ * completes. The handler runs in this process, so reports never
+ * interleave and datatypes.library is only used from one task.
+ */
+
+/* Compare the directory parts of two names, ignoring case */
+static LONG CompareDirParts(struct BatchFile *a, struct BatchFile *b)
+{
+    ULONG len = (a->bf_DirLen < b->bf_DirLen) ? a->bf_DirLen : b->bf_DirLen;
+    LONG diff;
+
+    diff = Strnicmp(a->bf_Name, b->bf_Name, (LONG)len);
+    if (diff != 0) {
+        return diff;
+    }
+
+    return (LONG)a->bf_DirLen - (LONG)b->bf_DirLen;
+}
+
+/* Sort order used to find each directory's lowest key */
+static int CompareByDirectory(const void *pa, const void *pb)
+{
+    struct BatchFile *a = *(struct BatchFile **)pa;
+    struct BatchFile *b = *(struct BatchFile **)pb;
+    LONG diff;
+
+    if (a->bf_Volume != b->bf_Volume) {
+        return (a->bf_Volume < b->bf_Volume) ? -1 : 1;
+    }
+    diff = CompareDirParts(a, b);
+    if (diff != 0) {
+        return (diff < 0) ? -1 : 1;
+    }
+    if (a->bf_Key != b->bf_Key) {
+        return (a->bf_Key < b->bf_Key) ? -1 : 1;
+    }
+    return 0;
+}
+
+/* Final order: volume, directory position on disk, file position on disk */
+static int CompareByDiskKey(const void *pa, const void *pb)
+{
+    struct BatchFile *a = *(struct BatchFile **)pa;
+    struct BatchFile *b = *(struct BatchFile **)pb;
+
+    if (a->bf_Volume != b->bf_Volume) {
+        return (a->bf_Volume < b->bf_Volume) ? -1 : 1;
+    }
+    if (a->bf_DirKey != b->bf_DirKey) {
+        return (a->bf_DirKey < b->bf_DirKey) ? -1 : 1;
+    }
+    return CompareByDirectory(pa, pb);
+}
+
+/* Find out which volume and where on it each file lives, then sort */
+/* Returns the number of volumes; order[] receives the files in batch order */
+static ULONG PlanBatch(struct BatchFile *files, struct BatchFile **order, ULONG count)
+{
+    struct OSFileInfo info;
+    struct MsgPort **handlers;
+    ULONG volumeCount = 0;
+    ULONG i;
+    ULONG v;
+    ULONG first;
+
+    handlers = (struct MsgPort **)OSAllocMem(sizeof(struct MsgPort *) * (count + 1));
+
+    for (i = 0; i < count; i++) {
+        struct BatchFile *bf = &files[i];
+        BPTR lock;
+
+        order[i] = bf;
+        bf->bf_DirLen = (ULONG)(PathPart(bf->bf_Name) - bf->bf_Name);
+
+        lock = OSLock(bf->bf_Name);
+        if (lock) {
+            bf->bf_Handler = ((struct FileLock *)BADDR(lock))->fl_Task;
+            if (OSExamineLock(lock, &info) && info.ofi_Type < 0) {
+                bf->bf_Key = info.ofi_Key;
+                bf->bf_Size = info.ofi_Size;
+            }
+            OSUnLock(lock);
+        }
+
+        /* Volumes are numbered in the order the batch first names them */
+        bf->bf_Volume = volumeCount;
+        if (handlers) {
+            for (v = 0; v < volumeCount; v++) {
+                if (handlers[v] == bf->bf_Handler) {
+                    bf->bf_Volume = v;
+                    break;
+                }
+            }
+            if (v == volumeCount) {
+                handlers[volumeCount++] = bf->bf_Handler;
+            }
+        } else {
+            bf->bf_Volume = 0;
+            volumeCount = 1;
+        }
+    }
+
+    OSFreeMem(handlers);
+
+    /* Group by directory to give each directory the lowest key of its files */
+    qsort(order, count, sizeof(struct BatchFile *), CompareByDirectory);
+    for (first = 0; first < count; first = i) {
+        for (i = first + 1; i < count; i++) {
+            if (order[i]->bf_Volume != order[first]->bf_Volume ||
+                CompareDirParts(order[i], order[first]) != 0) {
+                break;
+            }
+        }
+        for (v = first; v < i; v++) {
+            order[v]->bf_DirKey = order[first]->bf_Key;
+        }
+    }
+
+    qsort(order, count, sizeof(struct BatchFile *), CompareByDiskKey);
+
+    return volumeCount;
+}
+
+/* Queue an asynchronous read of a whole file to its filesystem */
+/* A file that cannot be read ahead is simply marked ready */
+static BOOL StartReadAhead(struct DTContext *ctx, struct BatchFile *bf, struct MsgPort *replyPort)
+{
+    struct FileHandle *fh;
+
+    bf->bf_State = BATCH_READY;
+
+    if (!bf->bf_Handler || bf->bf_Size == 0 || bf->bf_Size > ctx->dc_LoadCutoff) {
+        return FALSE;
+    }
+
+    bf->bf_File = OSOpen(bf->bf_Name);
+    if (!bf->bf_File) {
+        return FALSE;
+    }
+
+    fh = (struct FileHandle *)BADDR(bf->bf_File);
+    bf->bf_Buffer = (UBYTE *)OSAllocMem(bf->bf_Size + 1);
+    if (!fh->fh_Type || !bf->bf_Buffer) {
+        OSFreeMem(bf->bf_Buffer);
+        bf->bf_Buffer = NULL;
+        OSClose(bf->bf_File);
+        bf->bf_File = NULL;
+        return FALSE;
+    }
+
+    bf->bf_Packet.sp_Msg.mn_Node.ln_Name = (char *)&bf->bf_Packet.sp_Pkt;
+    bf->bf_Packet.sp_Pkt.dp_Link = &bf->bf_Packet.sp_Msg;
+    bf->bf_Packet.sp_Pkt.dp_Type = ACTION_READ;
+    bf->bf_Packet.sp_Pkt.dp_Arg1 = fh->fh_Arg1;
+    bf->bf_Packet.sp_Pkt.dp_Arg2 = (LONG)bf->bf_Buffer;
+    bf->bf_Packet.sp_Pkt.dp_Arg3 = (LONG)bf->bf_Size;
+    SendPkt(&bf->bf_Packet.sp_Pkt, fh->fh_Type, replyPort);
+
+    bf->bf_State = BATCH_READING;
+    return TRUE;
+}
+
+/* Collect a finished read; a short read drops the buffer */
+static VOID FinishReadAhead(struct BatchFile *bf)
+{
+    if (bf->bf_Packet.sp_Pkt.dp_Res1 != (LONG)bf->bf_Size) {
+        OSFreeMem(bf->bf_Buffer);
+        bf->bf_Buffer = NULL;
+    }
+    OSClose(bf->bf_File);
+    bf->bf_File = NULL;
+    bf->bf_State = BATCH_READY;
+}
+
+/* Run every file of a batch through a handler, in the given order */
+/* Returns the highest handler result, or RETURN_WARN if stopped by CTRL-C */
+LONG RunBatch(struct DTContext *ctx, STRPTR *names, ULONG count, UWORD order,
+              LONG (*handler)(struct DTContext *ctx, STRPTR fileName, APTR userData), APTR userData)
+{
+    struct BatchFile *files = NULL;
+    struct BatchFile **sorted = NULL;
+    struct BatchVolume *volumes = NULL;
+    struct MsgPort *replyPort = NULL;
+    struct Message *msg;
+    ULONG volumeCount;
+    ULONG remaining;
+    ULONG inFlight = 0;
+    ULONG lastVolume = 0;
+    LONG result = RETURN_OK;
+    LONG fileResult;
+    BOOL stopped = FALSE;
+    ULONG i;
+    ULONG v;
+
+    if (!ctx || !names || !handler) {
+        SetIoErr(ERROR_REQUIRED_ARG_MISSING);
+        return RETURN_FAIL;
+    }
+
+    /* A single file, ORDER=ARGS, or no memory for a plan: argument order */
+    if (order == ORDER_DISK && count > 1) {
+        files = (struct BatchFile *)OSAllocMem(sizeof(struct BatchFile) * count);
+        sorted = (struct BatchFile **)OSAllocMem(sizeof(struct BatchFile *) * count);
+        volumes = (struct BatchVolume *)OSAllocMem(sizeof(struct BatchVolume) * count);
+        replyPort = CreateMsgPort();
+    }
+
+    if (!files || !sorted || !volumes || !replyPort) {
+        OSFreeMem(files);
+        OSFreeMem(sorted);
+        OSFreeMem(volumes);
+        if (replyPort) {
+            DeleteMsgPort(replyPort);
+        }
+
+        for (i = 0; i < count; i++) {
+            if (SetSignal(0L, SIGBREAKF_CTRL_C) & SIGBREAKF_CTRL_C) {
+                PrintFault(ERROR_BREAK, "DataType");
+                return (result < RETURN_WARN) ? RETURN_WARN : result;
+            }
+            fileResult = handler(ctx, names[i], userData);
+            if (fileResult > result) {
+                result = fileResult;
+            }
+        }
+        return result;
+    }
+
+    for (i = 0; i < count; i++) {
+        files[i].bf_Name = names[i];
+    }
+    volumeCount = PlanBatch(files, sorted, count);
+
+    /* Each volume works through its own run of the sorted files */
+    for (i = 0; i < count; i++) {
+        v = sorted[i]->bf_Volume;
+        if (volumes[v].bv_Count == 0) {
+            volumes[v].bv_First = i;
+            volumes[v].bv_NextRead = i;
+            volumes[v].bv_NextFile = i;
+        }
+        volumes[v].bv_Count++;
+    }
+
+    remaining = count;
+    while (remaining > 0 && !stopped) {
+        struct BatchFile *bf = NULL;
+
+        /* Keep every volume's queue topped up */
+        for (v = 0; v < volumeCount; v++) {
+            struct BatchVolume *bv = &volumes[v];
+
+            while (bv->bv_InFlight < BATCH_READAHEAD &&
+                   bv->bv_NextRead < bv->bv_First + bv->bv_Count) {
+                if (StartReadAhead(ctx, sorted[bv->bv_NextRead], replyPort)) {
+                    bv->bv_InFlight++;
+                    inFlight++;
+                }
+                bv->bv_NextRead++;
+            }
+        }
+
+        /* Take the next ready file, turn and turn about between volumes */
+        for (i = 1; i <= volumeCount; i++) {
+            struct BatchVolume *bv;
+
+            v = (lastVolume + i) % volumeCount;
+            bv = &volumes[v];
+            if (bv->bv_NextFile < bv->bv_NextRead &&
+                sorted[bv->bv_NextFile]->bf_State == BATCH_READY) {
+                bf = sorted[bv->bv_NextFile];
+                bv->bv_NextFile++;
+                lastVolume = v;
+                break;
+            }
+        }
+
+        if (!bf && inFlight == 0) {
+            /* Nothing ready and nothing coming; cannot happen with a sound plan */
+            break;
+        } else if (!bf) {
+            if (Wait((1L << replyPort->mp_SigBit) | SIGBREAKF_CTRL_C) & SIGBREAKF_CTRL_C) {
+                stopped = TRUE;
+            }
+        } else if (SetSignal(0L, SIGBREAKF_CTRL_C) & SIGBREAKF_CTRL_C) {
+            stopped = TRUE;
+        } else {
+            /* OpenFileQuery() adopts the buffer; free it if the handler did not */
+            ctx->dc_ReadAhead = bf->bf_Buffer;
+            ctx->dc_ReadAheadSize = bf->bf_Size;
+            ctx->dc_ReadAheadName = bf->bf_Name;
+            bf->bf_Buffer = NULL;
+
+            fileResult = handler(ctx, bf->bf_Name, userData);
+            if (fileResult > result) {
+                result = fileResult;
+            }
+
+            OSFreeMem(ctx->dc_ReadAhead);
+            ctx->dc_ReadAhead = NULL;
+            ctx->dc_ReadAheadName = NULL;
+            bf->bf_State = BATCH_DONE;
+            remaining--;
+        }
+
+        while ((msg = GetMsg(replyPort)) != NULL) {
+            struct BatchFile *done = (struct BatchFile *)((struct DosPacket *)msg->mn_Node.ln_Name)->dp_Link;
+
+            FinishReadAhead(done);
+            volumes[done->bf_Volume].bv_InFlight--;
+            inFlight--;
+        }
+    }
+
+    if (stopped) {
+        PrintFault(ERROR_BREAK, "DataType");
+        if (result < RETURN_WARN) {
+            result = RETURN_WARN;
+        }
+    }
+
+    /* Packets cannot be recalled; wait for every read still queued */
+    while (inFlight > 0) {
+        WaitPort(replyPort);
+        while ((msg = GetMsg(replyPort)) != NULL) {
+            FinishReadAhead((struct BatchFile *)((struct DosPacket *)msg->mn_Node.ln_Name)->dp_Link);
+            inFlight--;
+        }
+    }
+
+    for (i = 0; i < count; i++) {
+        OSFreeMem(files[i].bf_Buffer);
+    }
+
+    DeleteMsgPort(replyPort);
+    OSFreeMem(volumes);
+    OSFreeMem(sorted);
+    OSFreeMem(files);
+
+    return result;
+}
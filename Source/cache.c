@@ -0,0 +1,106 @@
+/*
+ * DataType - lookup caches
+ *
+ * Copyright (c) 2025 amigazen project
+ * Licensed under BSD 2-Clause License
+ */
+
+#include "datatype.h"
+
+/*
+ * Results that only depend on the installed descriptors and DefIcons
+ * preferences are remembered for the life of the context: DTYP paths
+ * and DTTL tools per BaseName, DefIcons default tools per type and
+ * write capabilities per BaseName. A batch of files, and above all a
+ * SERVER, then pays for each lookup once. Negative results are cached
+ * too (ce_Data is NULL). ValidateCache() drops everything when the
+ * DEVS:Datatypes directory has changed, remembered unidentifiable files
+ * included.
+ */
+
+/* Find a cached result */
+struct CacheEntry *FindCacheEntry(struct DTContext *ctx, ULONG kind, STRPTR key)
+{
+    struct CacheEntry *ce;
+
+    if (!ctx || !key) {
+        return NULL;
+    }
+
+    for (ce = (struct CacheEntry *)ctx->dc_Cache.mlh_Head;
+         ce->ce_Node.mln_Succ;
+         ce = (struct CacheEntry *)ce->ce_Node.mln_Succ) {
+        if (ce->ce_Kind == kind && Stricmp(ce->ce_Key, key) == 0) {
+            return ce;
+        }
+    }
+
+    return NULL;
+}
+
+/* Remember a result; data is copied and may be NULL for a negative result */
+struct CacheEntry *AddCacheEntry(struct DTContext *ctx, ULONG kind, STRPTR key, ULONG value, STRPTR data)
+{
+    struct CacheEntry *ce;
+    ULONG keyLen;
+    ULONG dataLen;
+
+    if (!ctx || !key) {
+        return NULL;
+    }
+
+    keyLen = strlen(key) + 1;
+    dataLen = data ? strlen(data) + 1 : 0;
+
+    /* Key and data live in the same allocation as the entry */
+    ce = (struct CacheEntry *)OSAllocMem(sizeof(struct CacheEntry) + keyLen + dataLen);
+    if (!ce) {
+        return NULL;
+    }
+
+    ce->ce_Kind = kind;
+    ce->ce_Value = value;
+    ce->ce_Key = (STRPTR)(ce + 1);
+    CopyMem(key, ce->ce_Key, keyLen);
+    if (data) {
+        ce->ce_Data = ce->ce_Key + keyLen;
+        CopyMem(data, ce->ce_Data, dataLen);
+    } else {
+        ce->ce_Data = NULL;
+    }
+
+    AddHead((struct List *)&ctx->dc_Cache, (struct Node *)&ce->ce_Node);
+
+    return ce;
+}
+
+/* Drop every cached result */
+VOID FreeCache(struct DTContext *ctx)
+{
+    struct CacheEntry *ce;
+
+    if (!ctx) {
+        return;
+    }
+
+    while ((ce = (struct CacheEntry *)RemHead((struct List *)&ctx->dc_Cache)) != NULL) {
+        OSFreeMem(ce);
+    }
+}
+
+/* Drop the caches if DEVS:Datatypes has changed since they were filled */
+VOID ValidateCache(struct DTContext *ctx)
+{
+    struct OSFileInfo info;
+
+    if (!ctx || !OSExamine((STRPTR)"DEVS:Datatypes", &info)) {
+        return;
+    }
+
+    if (CompareDates(&info.ofi_Date, &ctx->dc_CacheStamp) != 0) {
+        FreeCache(ctx);
+        FreeCandidates(ctx);
+        ForgetUnknownFiles(ctx);
+        ctx->dc_CacheStamp = info.ofi_Date;
+    }
+}
@@ -0,0 +1,725 @@
+/*
+ * DataType - searchable type catalogues
+ *
+ * Copyright (c) 2025 amigazen project
+ * Licensed under BSD 2-Clause License
+ */
+
+#include "datatype.h"
+
+/*
+ * A CATALOG file holds what a run found out about each identified file,
+ * for FIND= to search later without identifying anything. After a
+ * CatalogHeader come the records, one per file in path order, each the
+ * offset of its path and its value for every CATKEY_ key. Then, for each
+ * key, every record's value and number sorted by value: any range of a
+ * key is found by binary search, reading one CatalogKey per step. A
+ * BaseName is stored as its rank among the BaseNames in the file, so it
+ * sorts like a number; the names follow the key arrays, and the paths
+ * come last.
+ *
+ * FIND looks up the range of each term and goes through the narrowest,
+ * reading each record to check the others. Searching reads only the
+ * header, the BaseNames and what the search touches, however large the
+ * catalogue, so a million files cost twenty-odd reads per term. A range
+ * wider than 1/CATALOG_SCAN_RATIO of the records is cheaper to read in
+ * order, and is.
+ */
+
+/* Field names FIND= understands, by CATKEY_ */
+static STRPTR keyNames[CATKEY_COUNT] = {
+    (STRPTR)"group", (STRPTR)"basename", (STRPTR)"size", (STRPTR)"width", (STRPTR)"height",
+    (STRPTR)"depth", (STRPTR)"frames", (STRPTR)"rate", (STRPTR)"length"
+};
+
+/* Order of key entries: by value, then record */
+static int CompareKeys(const void *a, const void *b)
+{
+    const struct CatalogKey *ka = (const struct CatalogKey *)a;
+    const struct CatalogKey *kb = (const struct CatalogKey *)b;
+
+    if (ka->ck_Value != kb->ck_Value) {
+        return (ka->ck_Value < kb->ck_Value) ? -1 : 1;
+    }
+    if (ka->ck_Record != kb->ck_Record) {
+        return (ka->ck_Record < kb->ck_Record) ? -1 : 1;
+    }
+    return 0;
+}
+
+/* Rank of a BaseName among count sorted names; count if it is not there */
+static ULONG FindBaseName(STRPTR *names, ULONG count, STRPTR name, ULONG *insert)
+{
+    ULONG low = 0;
+    ULONG high = count;
+
+    while (low < high) {
+        ULONG middle = (low + high) / 2;
+        LONG order = Stricmp(names[middle], name);
+
+        if (order == 0) {
+            return middle;
+        }
+        if (order < 0) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+
+    if (insert) {
+        *insert = low;
+    }
+    return count;
+}
+
+/* A record's values for an index entry */
+static VOID EntryValues(struct IndexEntry *ie, ULONG rank, ULONG *values)
+{
+    values[CATKEY_GROUP] = ie->ie_GroupID;
+    values[CATKEY_BASENAME] = rank;
+    values[CATKEY_SIZE] = ie->ie_Size;
+    values[CATKEY_WIDTH] = ie->ie_Width;
+    values[CATKEY_HEIGHT] = ie->ie_Height;
+    values[CATKEY_DEPTH] = ie->ie_Depth;
+    values[CATKEY_FRAMES] = ie->ie_Frames;
+    values[CATKEY_RATE] = ie->ie_SamplesPerSec;
+    values[CATKEY_LENGTH] = ie->ie_SampleLength;
+}
+
+/* Write a catalogue of the identified files among entries, which must */
+/* be sorted by path. The file is replaced whole, so a FIND running at */
+/* the time sees the old one or the new one. */
+BOOL WriteCatalog(STRPTR name, struct IndexEntry *entries, ULONG count)
+{
+    UBYTE tempName[TEMP_NAME_SIZE];
+    struct CatalogHeader ch;
+    struct CatalogRecord cr;
+    struct CatalogKey *keys = NULL;
+    STRPTR *names = NULL;
+    ULONG *ranks = NULL;
+    ULONG nameCount = 0;
+    ULONG nameMax = 0;
+    ULONG records = 0;
+    ULONG offset;
+    ULONG values[CATKEY_COUNT];
+    ULONG i;
+    ULONG r;
+    UWORD key;
+    BPTR fh;
+    BOOL ok = FALSE;
+    LONG error = 0;
+
+    if (!name || (!entries && count > 0)) {
+        SetIoErr(ERROR_REQUIRED_ARG_MISSING);
+        return FALSE;
+    }
+
+    /* The BaseNames in order, and each file's rank among them */
+    ranks = (ULONG *)OSAllocMem(sizeof(ULONG) * (count + 1));
+    if (!ranks) {
+        SetIoErr(ERROR_NO_FREE_STORE);
+        return FALSE;
+    }
+    memset(&ch, 0, sizeof(ch));
+    for (i = 0; i < count; i++) {
+        ULONG insert = 0;
+
+        if (entries[i].ie_GroupID == 0) {
+            continue;
+        }
+        records++;
+        if (FindBaseName(names, nameCount, (STRPTR)entries[i].ie_BaseName, &insert) < nameCount) {
+            continue;
+        }
+        if (nameCount == nameMax) {
+            ULONG max = nameMax ? nameMax * 2 : 32;
+            STRPTR *table = (STRPTR *)OSAllocMem(sizeof(STRPTR) * max);
+
+            if (!table) {
+                error = ERROR_NO_FREE_STORE;
+                goto done;
+            }
+            if (names) {
+                CopyMem(names, table, sizeof(STRPTR) * nameCount);
+                OSFreeMem(names);
+            }
+            names = table;
+            nameMax = max;
+        }
+        memmove(&names[insert + 1], &names[insert], sizeof(STRPTR) * (nameCount - insert));
+        names[insert] = (STRPTR)entries[i].ie_BaseName;
+        nameCount++;
+        ch.ch_BaseNameSize += strlen((char *)entries[i].ie_BaseName) + 1;
+    }
+    for (i = 0; i < count; i++) {
+        if (entries[i].ie_GroupID != 0) {
+            ranks[i] = FindBaseName(names, nameCount, (STRPTR)entries[i].ie_BaseName, NULL);
+        }
+    }
+
+    keys = (struct CatalogKey *)OSAllocMem(sizeof(struct CatalogKey) * (records + 1));
+    if (!keys) {
+        error = ERROR_NO_FREE_STORE;
+        goto done;
+    }
+
+    ch.ch_Magic = CATALOG_MAGIC;
+    ch.ch_Version = CATALOG_VERSION;
+    ch.ch_Count = records;
+    ch.ch_Records = sizeof(struct CatalogHeader);
+    ch.ch_Keys = ch.ch_Records + records * sizeof(struct CatalogRecord);
+    ch.ch_BaseNames = ch.ch_Keys + CATKEY_COUNT * records * sizeof(struct CatalogKey);
+    ch.ch_BaseNameCount = nameCount;
+    ch.ch_Strings = ch.ch_BaseNames + ch.ch_BaseNameSize;
+
+    fh = OSCreateTemp(name, tempName, sizeof(tempName), CATALOG_BUFFER_SIZE);
+    if (!fh) {
+        error = IoErr();
+        goto done;
+    }
+
+    ok = (BOOL)(FWrite(fh, (STRPTR)&ch, sizeof(ch), 1) == 1);
+
+    /* Records, in the entries' path order */
+    offset = 0;
+    for (i = 0; ok && i < count; i++) {
+        if (entries[i].ie_GroupID == 0) {
+            continue;
+        }
+        cr.cr_Path = offset;
+        cr.cr_PathLength = strlen(entries[i].ie_Path);
+        EntryValues(&entries[i], ranks[i], cr.cr_Values);
+        ok = (BOOL)(FWrite(fh, (STRPTR)&cr, sizeof(cr), 1) == 1);
+        offset += cr.cr_PathLength + 1;
+    }
+
+    /* A sorted key array for each key */
+    for (key = 0; ok && key < CATKEY_COUNT; key++) {
+        r = 0;
+        for (i = 0; i < count; i++) {
+            if (entries[i].ie_GroupID == 0) {
+                continue;
+            }
+            EntryValues(&entries[i], ranks[i], values);
+            keys[r].ck_Value = values[key];
+            keys[r].ck_Record = r;
+            r++;
+        }
+        qsort(keys, records, sizeof(struct CatalogKey), CompareKeys);
+        if (records > 0) {
+            ok = (BOOL)(FWrite(fh, (STRPTR)keys, sizeof(struct CatalogKey), records) == (LONG)records);
+        }
+    }
+
+    for (i = 0; ok && i < nameCount; i++) {
+        ok = (BOOL)(FWrite(fh, names[i], strlen(names[i]) + 1, 1) == 1);
+    }
+    for (i = 0; ok && i < count; i++) {
+        if (entries[i].ie_GroupID != 0) {
+            ok = (BOOL)(FWrite(fh, entries[i].ie_Path, strlen(entries[i].ie_Path) + 1, 1) == 1);
+        }
+    }
+
+    if (!ok) {
+        error = IoErr() ? IoErr() : ERROR_DISK_FULL;
+    }
+
+    /* Closing writes out what is still buffered, which can fail too */
+    if (!OSClose(fh) && ok) {
+        ok = FALSE;
+        error = IoErr() ? IoErr() : ERROR_DISK_FULL;
+    }
+
+    if (ok) {
+        ok = OSCommitTemp((STRPTR)tempName, name);
+        error = ok ? 0 : IoErr();
+    } else {
+        OSDelete((STRPTR)tempName);
+    }
+
+done:
+    OSFreeMem(keys);
+    OSFreeMem(names);
+    OSFreeMem(ranks);
+    SetIoErr(error);
+
+    return ok;
+}
+
+/* Parse a FIND= query: terms such as "group=picture width>640", */
+/* separated by spaces or commas, that must all hold */
+BOOL ParseCatalogQuery(STRPTR text, struct CatalogQuery *query)
+{
+    struct CatalogTerm *ct;
+    UBYTE *p = (UBYTE *)text;
+    UBYTE *start;
+    UBYTE value[32];
+    ULONG length;
+    UBYTE op;
+    BOOL orEqual;
+    LONG number;
+    UWORD key;
+
+    if (!text || !query) {
+        SetIoErr(ERROR_REQUIRED_ARG_MISSING);
+        return FALSE;
+    }
+    memset(query, 0, sizeof(struct CatalogQuery));
+    SetIoErr(ERROR_BAD_TEMPLATE);
+
+    for (;;) {
+        while (*p == ' ' || *p == ',') {
+            p++;
+        }
+        if (!*p) {
+            break;
+        }
+        if (query->cq_TermCount == CATALOG_MAX_TERMS) {
+            return FALSE;
+        }
+        ct = &query->cq_Terms[query->cq_TermCount];
+
+        /* Field */
+        for (start = p; (*p >= 'a' && *p <= 'z') || (*p >= 'A' && *p <= 'Z'); p++) {
+        }
+        length = p - start;
+        for (key = 0; key < CATKEY_COUNT; key++) {
+            if (length > 0 && Strnicmp(keyNames[key], (STRPTR)start, (LONG)length) == 0 &&
+                keyNames[key][length] == '\0') {
+                break;
+            }
+        }
+        if (key == CATKEY_COUNT) {
+            return FALSE;
+        }
+        ct->ct_Key = key;
+
+        /* Relation */
+        op = *p;
+        if (op != '=' && op != '<' && op != '>') {
+            return FALSE;
+        }
+        p++;
+        orEqual = (BOOL)(op == '=');
+        if (op != '=' && *p == '=') {
+            orEqual = TRUE;
+            p++;
+        }
+
+        /* Value */
+        for (start = p; *p && *p != ' ' && *p != ','; p++) {
+        }
+        length = p - start;
+        if (length == 0 || length >= sizeof(value)) {
+            return FALSE;
+        }
+        CopyMem(start, value, length);
+        value[length] = '\0';
+
+        if (key == CATKEY_GROUP || key == CATKEY_BASENAME) {
+            if (op != '=') {
+                return FALSE;
+            }
+            if (key == CATKEY_BASENAME) {
+                Strncpy(ct->ct_BaseName, (STRPTR)value, sizeof(ct->ct_BaseName));
+            } else {
+                /* Group IDs are the first four letters of the group: */
+                /* "picture" is 'pict', "sound" 'soun' */
+                if (length < 4) {
+                    return FALSE;
+                }
+                ct->ct_Low = MAKE_ID(ToLower(value[0]), ToLower(value[1]), ToLower(value[2]), ToLower(value[3]));
+                ct->ct_High = ct->ct_Low;
+            }
+        } else {
+            if (StrToLong((STRPTR)value, &number) != (LONG)length || number < 0) {
+                return FALSE;
+            }
+            ct->ct_Low = 0;
+            ct->ct_High = 0xFFFFFFFF;
+            if (op == '=') {
+                ct->ct_Low = (ULONG)number;
+                ct->ct_High = (ULONG)number;
+            } else if (op == '>') {
+                ct->ct_Low = orEqual ? (ULONG)number : (ULONG)number + 1;
+            } else if (orEqual) {
+                ct->ct_High = (ULONG)number;
+            } else if (number > 0) {
+                ct->ct_High = (ULONG)number - 1;
+            } else {
+                /* Nothing is below 0 */
+                ct->ct_Low = 1;
+                ct->ct_High = 0;
+            }
+
+            /* A file without the field has 0 there, and never matches */
+            if (key != CATKEY_SIZE && ct->ct_Low == 0) {
+                ct->ct_Low = 1;
+            }
+        }
+
+        query->cq_TermCount++;
+    }
+
+    if (query->cq_TermCount == 0) {
+        return FALSE;
+    }
+
+    SetIoErr(0);
+    return TRUE;
+}
+
+/* Read length bytes at an offset of the catalogue */
+static BOOL ReadCatalogAt(struct CatalogFile *cf, ULONG offset, APTR buffer, ULONG length)
+{
+    cf->cf_Reads++;
+    if (!OSSeek(cf->cf_File, (LONG)offset) || OSRead(cf->cf_File, buffer, (LONG)length) != (LONG)length) {
+        if (!IoErr()) {
+            SetIoErr(ERROR_OBJECT_WRONG_TYPE);
+        }
+        return FALSE;
+    }
+    return TRUE;
+}
+
+/* Position in a key array of the first value not below value, or with */
+/* after, of the first above it */
+static BOOL FindKeyBound(struct CatalogFile *cf, UWORD key, ULONG value, BOOL after, ULONG *bound)
+{
+    struct CatalogKey ck;
+    ULONG base = cf->cf_Header.ch_Keys + key * cf->cf_Header.ch_Count * sizeof(struct CatalogKey);
+    ULONG low = 0;
+    ULONG high = cf->cf_Header.ch_Count;
+
+    while (low < high) {
+        ULONG middle = (low + high) / 2;
+
+        if (!ReadCatalogAt(cf, base + middle * sizeof(struct CatalogKey), &ck, sizeof(ck))) {
+            return FALSE;
+        }
+        if (ck.ck_Value < value || (after && ck.ck_Value == value)) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+
+    *bound = low;
+    return TRUE;
+}
+
+/* Whether a record meets every term */
+static BOOL RecordMatches(struct CatalogRecord *cr, struct CatalogTerm *terms, ULONG count)
+{
+    ULONG i;
+
+    for (i = 0; i < count; i++) {
+        ULONG value = cr->cr_Values[terms[i].ct_Key];
+
+        if (value < terms[i].ct_Low || value > terms[i].ct_High) {
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+/* Open a catalogue written by WriteCatalog() for searching */
+struct CatalogFile *OpenCatalog(STRPTR name)
+{
+    struct CatalogFile *cf;
+    struct CatalogHeader *ch;
+    UBYTE *p;
+    UBYTE *end;
+    ULONG i;
+
+    if (!name) {
+        SetIoErr(ERROR_REQUIRED_ARG_MISSING);
+        return NULL;
+    }
+
+    cf = (struct CatalogFile *)OSAllocMem(sizeof(struct CatalogFile));
+    if (!cf) {
+        SetIoErr(ERROR_NO_FREE_STORE);
+        return NULL;
+    }
+
+    cf->cf_File = OSOpen(name);
+    if (!cf->cf_File) {
+        LONG error = IoErr();
+
+        OSFreeMem(cf);
+        SetIoErr(error);
+        return NULL;
+    }
+
+    ch = &cf->cf_Header;
+    SetIoErr(0);
+    if (!ReadCatalogAt(cf, 0, ch, sizeof(struct CatalogHeader)) ||
+        ch->ch_Magic != CATALOG_MAGIC || ch->ch_Version != CATALOG_VERSION) {
+        CloseCatalog(cf);
+        SetIoErr(ERROR_OBJECT_WRONG_TYPE);
+        return NULL;
+    }
+
+    /* The BaseNames are few, and are looked up by name, so they are loaded */
+    cf->cf_BaseNames = (UBYTE *)OSAllocMem(ch->ch_BaseNameSize + 1);
+    cf->cf_BaseNameTable = (STRPTR *)OSAllocMem(sizeof(STRPTR) * (ch->ch_BaseNameCount + 1));
+    if (!cf->cf_BaseNames || !cf->cf_BaseNameTable) {
+        CloseCatalog(cf);
+        SetIoErr(ERROR_NO_FREE_STORE);
+        return NULL;
+    }
+    if (ch->ch_BaseNameSize > 0 &&
+        !ReadCatalogAt(cf, ch->ch_BaseNames, cf->cf_BaseNames, ch->ch_BaseNameSize)) {
+        LONG error = IoErr();
+
+        CloseCatalog(cf);
+        SetIoErr(error);
+        return NULL;
+    }
+
+    p = cf->cf_BaseNames;
+    end = p + ch->ch_BaseNameSize;
+    for (i = 0; i < ch->ch_BaseNameCount; i++) {
+        if (p >= end) {
+            CloseCatalog(cf);
+            SetIoErr(ERROR_OBJECT_WRONG_TYPE);
+            return NULL;
+        }
+        cf->cf_BaseNameTable[i] = (STRPTR)p;
+        while (p < end && *p) {
+            p++;
+        }
+        p++;
+    }
+
+    cf->cf_Reads = 0;
+
+    return cf;
+}
+
+/* Call handler for each record that meets every term of the query, */
+/* until it returns FALSE. Returns FALSE if the catalogue cannot be read. */
+BOOL SearchCatalog(struct CatalogFile *cf, struct CatalogQuery *query,
+                   BOOL (*handler)(struct CatalogFile *cf, struct CatalogRecord *cr, APTR userData),
+                   APTR userData, ULONG *matches)
+{
+    struct CatalogTerm terms[CATALOG_MAX_TERMS];
+    struct CatalogHeader *ch;
+    struct CatalogRecord *records = NULL;
+    struct CatalogKey *keys = NULL;
+    struct CatalogRecord cr;
+    ULONG termCount;
+    ULONG best = 0;
+    ULONG bestFirst = 0;
+    ULONG bestEnd = 0;
+    ULONG first;
+    ULONG end;
+    ULONG i;
+    ULONG j;
+    ULONG n;
+    BOOL ok = TRUE;
+    BOOL going = TRUE;
+
+    if (!cf || !query || !handler || !matches) {
+        SetIoErr(ERROR_REQUIRED_ARG_MISSING);
+        return FALSE;
+    }
+    ch = &cf->cf_Header;
+    *matches = 0;
+    cf->cf_Candidates = 0;
+
+    /* BaseNames become their ranks in this file */
+    termCount = query->cq_TermCount;
+    CopyMem(query->cq_Terms, terms, sizeof(struct CatalogTerm) * termCount);
+    for (i = 0; i < termCount; i++) {
+        if (terms[i].ct_Key == CATKEY_BASENAME) {
+            terms[i].ct_Low = FindBaseName(cf->cf_BaseNameTable, ch->ch_BaseNameCount,
+                                           (STRPTR)terms[i].ct_BaseName, NULL);
+            terms[i].ct_High = terms[i].ct_Low;
+            if (terms[i].ct_Low == ch->ch_BaseNameCount) {
+                return TRUE;
+            }
+        }
+    }
+
+    /* The term with the fewest records to look at */
+    for (i = 0; i < termCount; i++) {
+        if (terms[i].ct_Low > terms[i].ct_High) {
+            return TRUE;
+        }
+        if (!FindKeyBound(cf, terms[i].ct_Key, terms[i].ct_Low, FALSE, &first)) {
+            return FALSE;
+        }
+        if (terms[i].ct_High == 0xFFFFFFFF) {
+            end = ch->ch_Count;
+        } else if (!FindKeyBound(cf, terms[i].ct_Key, terms[i].ct_High, TRUE, &end)) {
+            return FALSE;
+        }
+        if (end == first) {
+            return TRUE;
+        }
+        if (i == 0 || end - first < bestEnd - bestFirst) {
+            best = i;
+            bestFirst = first;
+            bestEnd = end;
+        }
+    }
+
+    if (bestEnd - bestFirst > ch->ch_Count / CATALOG_SCAN_RATIO) {
+        /* So many that reading every record in order is cheaper */
+        records = (struct CatalogRecord *)OSAllocMem(sizeof(struct CatalogRecord) * CATALOG_READ_COUNT);
+        if (!records) {
+            SetIoErr(ERROR_NO_FREE_STORE);
+            return FALSE;
+        }
+        for (i = 0; going && i < ch->ch_Count; i += n) {
+            n = ch->ch_Count - i;
+            if (n > CATALOG_READ_COUNT) {
+                n = CATALOG_READ_COUNT;
+            }
+            if (!ReadCatalogAt(cf, ch->ch_Records + i * sizeof(struct CatalogRecord),
+                               records, n * sizeof(struct CatalogRecord))) {
+                ok = FALSE;
+                break;
+            }
+            cf->cf_Candidates += n;
+            for (j = 0; going && j < n; j++) {
+                if (RecordMatches(&records[j], terms, termCount)) {
+                    (*matches)++;
+                    going = handler(cf, &records[j], userData);
+                }
+            }
+        }
+        OSFreeMem(records);
+        return ok;
+    }
+
+    /* Otherwise the records the best term's range names, one by one */
+    keys = (struct CatalogKey *)OSAllocMem(sizeof(struct CatalogKey) * CATALOG_READ_COUNT);
+    if (!keys) {
+        SetIoErr(ERROR_NO_FREE_STORE);
+        return FALSE;
+    }
+    for (i = bestFirst; going && i < bestEnd; i += n) {
+        n = bestEnd - i;
+        if (n > CATALOG_READ_COUNT) {
+            n = CATALOG_READ_COUNT;
+        }
+        if (!ReadCatalogAt(cf, ch->ch_Keys + (terms[best].ct_Key * ch->ch_Count + i) * sizeof(struct CatalogKey),
+                           keys, n * sizeof(struct CatalogKey))) {
+            ok = FALSE;
+            break;
+        }
+        for (j = 0; going && j < n; j++) {
+            if (keys[j].ck_Record >= ch->ch_Count ||
+                !ReadCatalogAt(cf, ch->ch_Records + keys[j].ck_Record * sizeof(struct CatalogRecord),
+                               &cr, sizeof(cr))) {
+                ok = FALSE;
+                going = FALSE;
+                break;
+            }
+            cf->cf_Candidates++;
+            if (RecordMatches(&cr, terms, termCount)) {
+                (*matches)++;
+                going = handler(cf, &cr, userData);
+            }
+        }
+    }
+    OSFreeMem(keys);
+
+    return ok;
+}
+
+/* Read a record's path */
+BOOL ReadCatalogPath(struct CatalogFile *cf, struct CatalogRecord *cr, STRPTR buffer, ULONG size)
+{
+    ULONG length;
+
+    if (!cf || !cr || !buffer || size == 0) {
+        SetIoErr(ERROR_REQUIRED_ARG_MISSING);
+        return FALSE;
+    }
+
+    length = (cr->cr_PathLength < size) ? cr->cr_PathLength : size - 1;
+    if (!ReadCatalogAt(cf, cf->cf_Header.ch_Strings + cr->cr_Path, buffer, length)) {
+        return FALSE;
+    }
+    buffer[length] = '\0';
+
+    return TRUE;
+}
+
+/* Close a catalogue */
+VOID CloseCatalog(struct CatalogFile *cf)
+{
+    if (!cf) {
+        return;
+    }
+
+    OSClose(cf->cf_File);
+    OSFreeMem(cf->cf_BaseNameTable);
+    OSFreeMem(cf->cf_BaseNames);
+    OSFreeMem(cf);
+}
+
+/* Print the path of a file FIND found */
+static BOOL PrintFound(struct CatalogFile *cf, struct CatalogRecord *cr, APTR userData)
+{
+    UBYTE path[WALK_PATH_SIZE];
+
+    if (SetSignal(0L, SIGBREAKF_CTRL_C) & SIGBREAKF_CTRL_C) {
+        *(BOOL *)userData = TRUE;
+        return FALSE;
+    }
+
+    if (ReadCatalogPath(cf, cr, (STRPTR)path, sizeof(path))) {
+        Printf("%s\n", path);
+    }
+
+    return TRUE;
+}
+
+/* FIND: print the files of a catalogue that meet a query, one per line */
+/* Returns RETURN_WARN if there are none, as Search does */
+LONG RunFind(STRPTR catalogName, STRPTR query)
+{
+    struct CatalogQuery cq;
+    struct CatalogFile *cf;
+    ULONG matches = 0;
+    BOOL broken = FALSE;
+    LONG result = RETURN_OK;
+    UWORD key;
+
+    if (!ParseCatalogQuery(query, &cq)) {
+        Printf("Error: Cannot understand FIND=%s\n", query);
+        Printf("Terms are <field><relation><value>, all of which must hold; fields:");
+        for (key = 0; key < CATKEY_COUNT; key++) {
+            Printf(" %s", keyNames[key]);
+        }
+        Printf("\nRelations: = < > <= >= (group and basename take = only)\n");
+        return RETURN_FAIL;
+    }
+
+    cf = OpenCatalog(catalogName);
+    if (!cf) {
+        PrintFault(IoErr(), catalogName);
+        return RETURN_FAIL;
+    }
+
+    if (!SearchCatalog(cf, &cq, PrintFound, &broken, &matches)) {
+        PrintFault(IoErr(), catalogName);
+        result = RETURN_FAIL;
+    } else if (broken) {
+        PrintFault(ERROR_BREAK, "DataType");
+        result = RETURN_WARN;
+    } else if (matches == 0) {
+        result = RETURN_WARN;
+    }
+
+    CloseCatalog(cf);
+
+    return result;
+}
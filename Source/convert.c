@@ -0,0 +1,1248 @@
+/*
+ * DataType - file conversion
+ *
+ * Copyright (c) 2025 amigazen project
+ * Licensed under BSD 2-Clause License
+ */
+
+#include "datatype.h"
+
+/* Convert file to IFF format using datatypes.library */
+BOOL ConvertToIFF(struct FileQuery *fq, STRPTR outputFile)
+{
+    Object *dtObject = NULL;
+    LONG errorCode = 0;
+    BOOL result = FALSE;
+    STRPTR errorString = NULL;
+    struct EClockVal clock;
+    
+    if (!fq || !outputFile) {
+        SetIoErr(ERROR_REQUIRED_ARG_MISSING);
+        return FALSE;
+    }
+    
+    /* Reuse the object decoded for the report, or decode it now */
+    dtObject = GetFileObject(fq);
+    if (!dtObject) {
+        return FALSE;
+    }
+    
+    /* Clear selection before writing */
+    {
+        struct dtGeneral clearMsg;
+        clearMsg.MethodID = DTM_CLEARSELECTED;
+        clearMsg.dtg_GInfo = NULL;
+        DoDTMethodA(dtObject, NULL, NULL, (Msg)&clearMsg);
+    }
+    
+    /* Planar pictures are packed by our own ILBM writer; anything it */
+    /* cannot read is left to the class */
+    SetIoErr(0);
+    BeginPhase(&clock);
+    if (fq->fq_DataType && fq->fq_DataType->dtn_Header->dth_GroupID == GID_PICTURE) {
+        result = WritePictureILBM(dtObject, outputFile);
+        if (result) {
+            EndPhase(PHASE_CONVERT, &clock);
+            return TRUE;
+        }
+        if (IoErr() != ERROR_NOT_IMPLEMENTED) {
+            EndPhase(PHASE_CONVERT, &clock);
+            return FALSE;
+        }
+        SetIoErr(0);
+    }
+
+    /* So are mono sounds, by the streaming 8SVX and AIFF writers, which */
+    /* also apply RATE= and BITS= */
+    if (fq->fq_DataType && fq->fq_DataType->dtn_Header->dth_GroupID == GID_SOUND) {
+        struct DTContext *ctx = fq->fq_Context;
+
+        result = WriteSoundIFF(dtObject, outputFile,
+                               ctx ? ctx->dc_SampleRate : 0, ctx ? ctx->dc_SampleBits : 0,
+                               ctx ? ctx->dc_Compress : FALSE);
+        if (result) {
+            EndPhase(PHASE_CONVERT, &clock);
+            return TRUE;
+        }
+        if (IoErr() != ERROR_NOT_IMPLEMENTED) {
+            EndPhase(PHASE_CONVERT, &clock);
+            return FALSE;
+        }
+        SetIoErr(0);
+    }
+
+    /* Anything else is written by the class's DTM_WRITE */
+    result = WriteDTObject(dtObject, outputFile, DTWM_IFF);
+    EndPhase(PHASE_CONVERT, &clock);
+    if (!result) {
+        /* Failure - get error code and error string */
+        errorCode = IoErr();
+        if (errorCode != 0) {
+            errorString = GetDTString(errorCode);
+            if (errorString && *errorString != '\0') {
+                /* Error string is available - it will be printed by caller */
+                SetIoErr(errorCode);
+            } else {
+                /* No error string, use the error code */
+                SetIoErr(errorCode);
+            }
+        } else {
+            /* No error code set, use generic error */
+            SetIoErr(ERROR_WRITE_PROTECTED);
+        }
+        result = FALSE;
+    } else {
+        /* Success */
+        result = TRUE;
+    }
+    
+    /* The object belongs to the FileQuery and is disposed with it */
+    return result;
+}
+
+/* Copy the next comma-separated item of a list into item */
+/* Returns where the following item starts, or NULL at the end */
+static STRPTR NextListItem(STRPTR list, UBYTE *item, ULONG size)
+{
+    ULONG len;
+
+    if (!list || !*list) {
+        return NULL;
+    }
+
+    for (len = 0; list[len] && list[len] != ','; len++) {
+    }
+    Strncpy(item, list, (len < size) ? len + 1 : size);
+
+    list += len;
+    if (*list == ',') {
+        list++;
+    }
+
+    return list;
+}
+
+/* Write one decoded file to several targets, TARGET=a,b FORMAT=ilbm,png */
+/* A target without a format, or with format IFF, is converted to IFF. */
+/* The object is decoded once; each target costs only its encode. */
+/* Returns TRUE if every target was written */
+BOOL ConvertTargets(struct FileQuery *fq, STRPTR targets, STRPTR formats, BOOL force)
+{
+    UBYTE target[256];
+    UBYTE format[32];
+    STRPTR nextTarget = targets;
+    STRPTR nextFormat = formats;
+    ULONG groupID;
+    ULONG written = 0;
+    ULONG failed = 0;
+    BOOL timed;
+
+    if (!fq || !targets || !fq->fq_DataType) {
+        SetIoErr(ERROR_REQUIRED_ARG_MISSING);
+        return FALSE;
+    }
+    groupID = fq->fq_DataType->dtn_Header->dth_GroupID;
+
+    /* Decode before the first target, so its time is not charged to it */
+    if (!GetFileObject(fq)) {
+        return FALSE;
+    }
+
+    timed = OpenTimer();
+
+    while ((nextTarget = NextListItem(nextTarget, target, sizeof(target))) != NULL) {
+        struct DataType *destDtn = NULL;
+        struct EClockVal start;
+        BOOL ok;
+
+        format[0] = '\0';
+        nextFormat = NextListItem(nextFormat, format, sizeof(format));
+
+        if (target[0] == '\0') {
+            continue;
+        }
+        if (SetSignal(0L, SIGBREAKF_CTRL_C) & SIGBREAKF_CTRL_C) {
+            SetIoErr(ERROR_BREAK);
+            failed++;
+            break;
+        }
+        if (!CheckOutputFileExists((STRPTR)target, force)) {
+            failed++;
+            continue;
+        }
+
+        if (format[0] && Stricmp((STRPTR)format, (STRPTR)"iff") != 0) {
+            destDtn = FindFormatByBaseName(groupID, (STRPTR)format);
+            if (!destDtn) {
+                Printf("\nError: No %s datatype in this group for %s\n", (STRPTR)format, (STRPTR)target);
+                failed++;
+                continue;
+            }
+        }
+
+        ReadTimer(&start);
+        if (destDtn) {
+            ok = ConvertToFormat(fq, destDtn, (STRPTR)target);
+        } else {
+            ok = ConvertToIFF(fq, (STRPTR)target);
+        }
+
+        if (ok) {
+            written++;
+            Printf("\nWrote %s as %s", (STRPTR)target,
+                   destDtn ? destDtn->dtn_Header->dth_Name : (STRPTR)"IFF");
+            if (timed) {
+                Printf(" in %lu ms", ElapsedMicros(&start) / 1000);
+            }
+            Printf("\n");
+        } else {
+            LONG errorCode = IoErr();
+
+            failed++;
+            Printf("\nError: Failed to write %s\n", (STRPTR)target);
+            if (errorCode != 0) {
+                PrintFault(errorCode, "DataType");
+            }
+        }
+
+        if (destDtn) {
+            ReleaseDataType(destDtn);
+        }
+    }
+
+    if (timed) {
+        CloseTimer();
+    }
+
+    if (written + failed > 1) {
+        Printf("\n%lu of %lu targets written from one decode\n", written, written + failed);
+    }
+
+    return (BOOL)(failed == 0 && written > 0);
+}
+
+/* Write every frame of an animation as a numbered ILBM, <base>.0001 on */
+/* Frames are loaded and released one at a time, so only about one frame */
+/* is held however long the animation is */
+BOOL ExplodeAnimation(struct FileQuery *fq, STRPTR outputBase, BOOL force, struct ExplodeResult *er)
+{
+    struct BitMapHeader bmh;
+    struct ColorRegister *colors = NULL;
+    struct ColorRegister *frameColors;
+    ULONG *rgb;
+    Object *dtObject;
+    UBYTE name[256];
+    ULONG width = 0;
+    ULONG height = 0;
+    ULONG depth = 0;
+    ULONG frames = 0;
+    ULONG numColors = 0;
+    ULONG modeID = INVALID_ID;
+    ULONG frame;
+    ULONG c;
+    LONG error;
+    BOOL timed;
+    BOOL result = TRUE;
+    struct EClockVal clock;
+    struct EClockVal start;
+
+    if (!fq || !outputBase || !er) {
+        SetIoErr(ERROR_REQUIRED_ARG_MISSING);
+        return FALSE;
+    }
+    memset(er, 0, sizeof(struct ExplodeResult));
+
+    dtObject = GetFileObject(fq);
+    if (!dtObject) {
+        return FALSE;
+    }
+
+    GetDTAttrs(dtObject,
+               ADTA_Width, (ULONG)&width,
+               ADTA_Height, (ULONG)&height,
+               ADTA_Depth, (ULONG)&depth,
+               ADTA_Frames, (ULONG)&frames,
+               ADTA_ModeID, (ULONG)&modeID,
+               ADTA_ColorRegisters, (ULONG)&colors,
+               ADTA_NumColors, (ULONG)&numColors,
+               TAG_DONE);
+    if (frames == 0 || width == 0 || height == 0 || depth == 0) {
+        SetIoErr(ERROR_OBJECT_WRONG_TYPE);
+        return FALSE;
+    }
+    if (numColors > 256) {
+        numColors = 256;
+    }
+
+    memset(&bmh, 0, sizeof(bmh));
+    bmh.bmh_Width = (UWORD)width;
+    bmh.bmh_Height = (UWORD)height;
+    bmh.bmh_Depth = (UBYTE)depth;
+    bmh.bmh_XAspect = 1;
+    bmh.bmh_YAspect = 1;
+    bmh.bmh_PageWidth = (WORD)width;
+    bmh.bmh_PageHeight = (WORD)height;
+
+    /* Frames with a palette of their own are written with it */
+    frameColors = (struct ColorRegister *)OSAllocMem(sizeof(struct ColorRegister) * 256 + sizeof(ULONG) * 3 * 256);
+    if (!frameColors) {
+        SetIoErr(ERROR_NO_FREE_STORE);
+        return FALSE;
+    }
+    rgb = (ULONG *)(frameColors + 256);
+
+    timed = OpenTimer();
+    ReadTimer(&start);
+    BeginPhase(&clock);
+
+    for (frame = 0; frame < frames && result; frame++) {
+        struct adtFrame alf;
+        struct ColorRegister *palette = colors;
+
+        if (SetSignal(0L, SIGBREAKF_CTRL_C) & SIGBREAKF_CTRL_C) {
+            SetIoErr(ERROR_BREAK);
+            result = FALSE;
+            break;
+        }
+
+        SNPrintf(name, sizeof(name), "%s.%04lu", outputBase, frame + 1);
+        if (!CheckOutputFileExists((STRPTR)name, force)) {
+            result = FALSE;
+            break;
+        }
+
+        memset(&alf, 0, sizeof(alf));
+        alf.MethodID = ADTM_LOADFRAME;
+        alf.alf_TimeStamp = frame;
+        alf.alf_Frame = frame;
+        if (!DoDTMethodA(dtObject, NULL, NULL, (Msg)&alf) || !alf.alf_BitMap) {
+            if (IoErr() == 0) {
+                SetIoErr(ERROR_OBJECT_NOT_FOUND);
+            }
+            result = FALSE;
+            break;
+        }
+
+        if (alf.alf_CMap && numColors > 0) {
+            GetRGB32(alf.alf_CMap, 0, numColors, rgb);
+            for (c = 0; c < numColors; c++) {
+                frameColors[c].red = (UBYTE)(rgb[c * 3] >> 24);
+                frameColors[c].green = (UBYTE)(rgb[c * 3 + 1] >> 24);
+                frameColors[c].blue = (UBYTE)(rgb[c * 3 + 2] >> 24);
+            }
+            palette = frameColors;
+        }
+
+        if (WriteILBM((STRPTR)name, &bmh, alf.alf_BitMap, palette, numColors, modeID)) {
+            er->er_Frames++;
+        } else {
+            result = FALSE;
+        }
+
+        /* Hand the frame back before loading the next one */
+        error = IoErr();
+        alf.MethodID = ADTM_UNLOADFRAME;
+        DoDTMethodA(dtObject, NULL, NULL, (Msg)&alf);
+        SetIoErr(error);
+    }
+
+    EndPhase(PHASE_CONVERT, &clock);
+    er->er_Micros = ElapsedMicros(&start);
+    if (timed) {
+        CloseTimer();
+    }
+
+    OSFreeMem(frameColors);
+
+    return result;
+}
+
+/* List available formats for conversion in the same group */
+/* Returns the count of available formats */
+ULONG ListAvailableFormats(struct DataType *sourceDtn, ULONG groupID)
+{
+    struct DataType *dtn = NULL;
+    struct DataType *prevdtn = NULL;
+    ULONG count = 0;
+    STRPTR sourceBaseName = NULL;
+    
+    if (!sourceDtn) {
+        return 0;
+    }
+    
+    sourceBaseName = sourceDtn->dtn_Header->dth_BaseName;
+    
+    Printf("\nAvailable formats for conversion:\n");
+    Printf("===================================\n");
+    
+    /* Enumerate all datatypes in the same group */
+    {
+        struct TagItem tags[4];
+        tags[0].ti_Tag = DTA_DataType;
+        tags[0].ti_Data = (ULONG)prevdtn;
+        tags[1].ti_Tag = DTA_GroupID;
+        tags[1].ti_Data = (ULONG)groupID;
+        tags[2].ti_Tag = TAG_DONE;
+        
+        while ((dtn = ObtainDataTypeA(DTST_RAM, NULL, tags)) != NULL) {
+        /* Skip system datatypes and invalid ones */
+        if (dtn->dtn_Header->dth_GroupID == GID_SYSTEM || 
+            dtn->dtn_Header->dth_GroupID == 0) {
+            ReleaseDataType(prevdtn);
+            prevdtn = dtn;
+            continue;
+        }
+        
+        count++;
+        
+        /* Print format info */
+        {
+            STRPTR name = dtn->dtn_Header->dth_Name ? dtn->dtn_Header->dth_Name : (STRPTR)"Unknown";
+            STRPTR baseName = dtn->dtn_Header->dth_BaseName ? dtn->dtn_Header->dth_BaseName : (STRPTR)"unknown";
+            BOOL isCurrent = (sourceBaseName && Stricmp(sourceBaseName, baseName) == 0);
+            
+            Printf("  %2lu. %s (%s)", count, name, baseName);
+            if (isCurrent) {
+                Printf(" [current]");
+            }
+            Printf("\n");
+        }
+        
+            /* Release previous and keep current */
+            if (prevdtn) {
+                ReleaseDataType(prevdtn);
+            }
+            prevdtn = dtn;
+            
+            /* Update tags for next iteration */
+            tags[0].ti_Data = (ULONG)prevdtn;
+        }
+    }
+    
+    /* Release last datatype */
+    if (prevdtn) {
+        ReleaseDataType(prevdtn);
+    }
+    
+    return count;
+}
+
+/* Select format from list by prompting user */
+struct DataType *SelectFormatFromList(ULONG groupID, LONG *selectedIndex)
+{
+    struct DataType *dtn = NULL;
+    struct DataType *prevdtn = NULL;
+    struct DataType *resultDtn = NULL;
+    ULONG count = 0;
+    LONG selection = 0;
+    UBYTE inputBuffer[32];
+    LONG inputLen = 0;
+    LONG charsConverted = 0;
+    
+    Printf("\nSelect format number (or 0 to cancel): ");
+    
+    /* Read user input */
+    inputLen = Read(Input(), inputBuffer, sizeof(inputBuffer) - 1);
+    if (inputLen > 0) {
+        inputBuffer[inputLen] = '\0';
+        /* Remove newline if present */
+        if (inputBuffer[inputLen - 1] == '\n') {
+            inputBuffer[inputLen - 1] = '\0';
+            inputLen--;
+        }
+        /* Convert string to long using StrToLong */
+        charsConverted = StrToLong((STRPTR)inputBuffer, &selection);
+        if (charsConverted < 0) {
+            /* No digits found - treat as 0 (cancel) */
+            selection = 0;
+        }
+    }
+    
+    if (selection <= 0) {
+        return NULL;
+    }
+    
+    /* Find the selected datatype */
+    {
+        struct TagItem tags[4];
+        tags[0].ti_Tag = DTA_DataType;
+        tags[0].ti_Data = (ULONG)prevdtn;
+        tags[1].ti_Tag = DTA_GroupID;
+        tags[1].ti_Data = (ULONG)groupID;
+        tags[2].ti_Tag = TAG_DONE;
+        
+        while ((dtn = ObtainDataTypeA(DTST_RAM, NULL, tags)) != NULL) {
+        count++;
+        
+        /* Skip system datatypes and invalid ones */
+        if (dtn->dtn_Header->dth_GroupID == GID_SYSTEM || 
+            dtn->dtn_Header->dth_GroupID == 0) {
+            ReleaseDataType(prevdtn);
+            prevdtn = dtn;
+            continue;
+        }
+        
+        if (count == selection) {
+            /* Found the selected format - keep it and release others */
+            resultDtn = dtn;
+            if (selectedIndex) {
+                *selectedIndex = selection;
+            }
+            /* Release previous but keep current */
+            if (prevdtn) {
+                ReleaseDataType(prevdtn);
+            }
+            prevdtn = NULL; /* Don't release resultDtn */
+            break;
+        }
+        
+            /* Release previous and keep current */
+            if (prevdtn) {
+                ReleaseDataType(prevdtn);
+            }
+            prevdtn = dtn;
+            
+            /* Update tags for next iteration */
+            tags[0].ti_Data = (ULONG)prevdtn;
+        }
+    }
+    
+    /* Release any remaining datatypes */
+    if (prevdtn && prevdtn != resultDtn) {
+        ReleaseDataType(prevdtn);
+    }
+    
+    return resultDtn;
+}
+
+/* Find the datatype with the given BaseName in a group */
+/* Returns an obtained DataType that the caller releases, or NULL */
+struct DataType *FindFormatByBaseName(ULONG groupID, STRPTR baseName)
+{
+    struct DataType *dtn = NULL;
+    struct DataType *prevdtn = NULL;
+    struct TagItem tags[3];
+    
+    if (!baseName) {
+        return NULL;
+    }
+    
+    tags[0].ti_Tag = DTA_DataType;
+    tags[0].ti_Data = (ULONG)prevdtn;
+    tags[1].ti_Tag = DTA_GroupID;
+    tags[1].ti_Data = (ULONG)groupID;
+    tags[2].ti_Tag = TAG_DONE;
+    
+    while ((dtn = ObtainDataTypeA(DTST_RAM, NULL, tags)) != NULL) {
+        if (prevdtn) {
+            ReleaseDataType(prevdtn);
+        }
+        prevdtn = dtn;
+        
+        if (dtn->dtn_Header->dth_BaseName &&
+            Stricmp(dtn->dtn_Header->dth_BaseName, baseName) == 0) {
+            return dtn;
+        }
+        
+        tags[0].ti_Data = (ULONG)prevdtn;
+    }
+    
+    if (prevdtn) {
+        ReleaseDataType(prevdtn);
+    }
+    
+    return NULL;
+}
+
+/* DTM_WRITE an object to a temporary file beside outputFile, its name */
+/* left in tempName (TEMP_NAME_SIZE bytes) for the caller to commit */
+/* On failure nothing is left behind and IoErr() says why */
+static BOOL WriteDTObjectTemp(Object *dtObject, STRPTR outputFile, ULONG mode, UBYTE *tempName)
+{
+    struct dtWrite dtw;
+    BPTR fh;
+    ULONG written;
+    LONG error;
+
+    if (!dtObject || !outputFile) {
+        SetIoErr(ERROR_REQUIRED_ARG_MISSING);
+        return FALSE;
+    }
+
+    fh = OSCreateTemp(outputFile, tempName, TEMP_NAME_SIZE, DTWRITE_BUFFER_SIZE);
+    if (!fh) {
+        return FALSE;
+    }
+
+    dtw.MethodID = DTM_WRITE;
+    dtw.dtw_GInfo = NULL;
+    dtw.dtw_FileHandle = fh;
+    dtw.dtw_Mode = mode;
+    dtw.dtw_AttrList = NULL;
+
+    SetIoErr(0);
+    written = DoDTMethodA(dtObject, NULL, NULL, (Msg)&dtw);
+    error = IoErr();
+
+    /* Closing writes out what is still buffered, which can fail too */
+    if (!OSClose(fh) && written) {
+        written = 0;
+        error = IoErr() ? IoErr() : ERROR_DISK_FULL;
+    }
+
+    if (!written) {
+        OSDelete((STRPTR)tempName);
+        SetIoErr(error);
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+/* Make an object of destDtn's class holding a copy of a picture, so the */
+/* class's own DTM_WRITE can save it. The object is made in V43 mode and */
+/* given its BitMapHeader first; the pixels then go in a row at a time */
+/* through PDTM_WRITEPIXELARRAY, as LUT8 from the planes with the palette */
+/* for up to 8 bitplanes, as ARGB read back from the source beyond that */
+static Object *CopyPicture(Object *srcObject, struct DataType *destDtn)
+{
+    struct BitMapHeader *bmh = NULL;
+    struct BitMapHeader *destBmh = NULL;
+    struct BitMap *bm = NULL;
+    struct ColorRegister *colors = NULL;
+    struct ColorRegister *destColors = NULL;
+    struct pdtBlitPixelArray bpa;
+    ULONG *cregs = NULL;
+    ULONG numColors = 0;
+    ULONG modeID = INVALID_ID;
+    ULONG rowBytes;
+    Object *destObject;
+    UBYTE *row;
+    BOOL planar;
+    ULONG x;
+    ULONG y;
+    UWORD plane;
+
+    if (GetDTAttrs(srcObject,
+                   PDTA_BitMapHeader, (ULONG)&bmh,
+                   PDTA_BitMap, (ULONG)&bm,
+                   PDTA_ColorRegisters, (ULONG)&colors,
+                   PDTA_NumColors, (ULONG)&numColors,
+                   PDTA_ModeID, (ULONG)&modeID,
+                   TAG_DONE) < 2 || !bmh || bmh->bmh_Width == 0 || bmh->bmh_Height == 0) {
+        SetIoErr(ERROR_OBJECT_WRONG_TYPE);
+        return NULL;
+    }
+
+    /* Planes are read directly, as WriteILBM() does, so only from */
+    /* standard bitmaps; deeper pictures are read back from the class */
+    planar = (BOOL)(bmh->bmh_Depth > 0 && bmh->bmh_Depth <= 8);
+    rowBytes = ((bmh->bmh_Width + 15) >> 4) << 1;
+    if (planar && (!bm || !(GetBitMapAttr(bm, BMA_FLAGS) & BMF_STANDARD) ||
+                   bm->Depth < bmh->bmh_Depth || bm->Rows < bmh->bmh_Height || bm->BytesPerRow < rowBytes)) {
+        SetIoErr(ERROR_NOT_IMPLEMENTED);
+        return NULL;
+    }
+    if (numColors > 256) {
+        numColors = 256;
+    }
+
+    row = (UBYTE *)OSAllocMem((ULONG)bmh->bmh_Width * (planar ? 1 : 4));
+    if (!row) {
+        SetIoErr(ERROR_NO_FREE_STORE);
+        return NULL;
+    }
+
+    destObject = NewDTObject(NULL,
+                             DTA_SourceType, DTST_RAM,
+                             DTA_DataType, (ULONG)destDtn,
+                             DTA_GroupID, GID_PICTURE,
+                             PDTA_DestMode, PMODE_V43,
+                             TAG_DONE);
+    if (!destObject) {
+        OSFreeMem(row);
+        if (IoErr() == 0) {
+            SetIoErr(ERROR_OBJECT_WRONG_TYPE);
+        }
+        return NULL;
+    }
+
+    /* The class sizes its pixel buffer from the header, so it goes first */
+    /* No mask plane is copied, so do not claim one */
+    GetDTAttrs(destObject, PDTA_BitMapHeader, (ULONG)&destBmh, TAG_DONE);
+    if (!destBmh) {
+        DisposeDTObject(destObject);
+        OSFreeMem(row);
+        SetIoErr(ERROR_OBJECT_WRONG_TYPE);
+        return NULL;
+    }
+    *destBmh = *bmh;
+    if (destBmh->bmh_Masking == mskHasMask) {
+        destBmh->bmh_Masking = mskNone;
+    }
+
+    if (planar) {
+        SetDTAttrs(destObject, NULL, NULL,
+                   PDTA_NumColors, numColors,
+                   PDTA_ModeID, modeID,
+                   TAG_DONE);
+        GetDTAttrs(destObject,
+                   PDTA_ColorRegisters, (ULONG)&destColors,
+                   PDTA_CRegs, (ULONG)&cregs,
+                   TAG_DONE);
+        for (x = 0; colors && x < numColors; x++) {
+            if (destColors) {
+                destColors[x] = colors[x];
+            }
+            if (cregs) {
+                cregs[x * 3] = (ULONG)colors[x].red * 0x01010101;
+                cregs[x * 3 + 1] = (ULONG)colors[x].green * 0x01010101;
+                cregs[x * 3 + 2] = (ULONG)colors[x].blue * 0x01010101;
+            }
+        }
+    }
+
+    bpa.pbpa_PixelData = row;
+    bpa.pbpa_PixelFormat = planar ? PBPAFMT_LUT8 : PBPAFMT_ARGB;
+    bpa.pbpa_PixelArrayMod = (ULONG)bmh->bmh_Width * (planar ? 1 : 4);
+    bpa.pbpa_Left = 0;
+    bpa.pbpa_Width = bmh->bmh_Width;
+    bpa.pbpa_Height = 1;
+    for (y = 0; y < bmh->bmh_Height; y++) {
+        bpa.pbpa_Top = y;
+        if (planar) {
+            /* One byte per pixel, gathered from a bit of each plane */
+            memset(row, 0, bmh->bmh_Width);
+            for (plane = 0; plane < bmh->bmh_Depth; plane++) {
+                UBYTE *bits = (UBYTE *)bm->Planes[plane] + y * bm->BytesPerRow;
+
+                for (x = 0; x < bmh->bmh_Width; x++) {
+                    if (bits[x >> 3] & (0x80 >> (x & 7))) {
+                        row[x] |= (UBYTE)(1 << plane);
+                    }
+                }
+            }
+        } else {
+            bpa.MethodID = PDTM_READPIXELARRAY;
+            if (!DoDTMethodA(srcObject, NULL, NULL, (Msg)&bpa)) {
+                break;
+            }
+        }
+        bpa.MethodID = PDTM_WRITEPIXELARRAY;
+        if (!DoDTMethodA(destObject, NULL, NULL, (Msg)&bpa)) {
+            break;
+        }
+    }
+    OSFreeMem(row);
+
+    if (y < bmh->bmh_Height) {
+        DisposeDTObject(destObject);
+        SetIoErr(ERROR_OBJECT_WRONG_TYPE);
+        return NULL;
+    }
+
+    return destObject;
+}
+
+/* Make an object of destDtn's class holding a copy of a sound */
+/* 8 and 16-bit samples, mono or interleaved stereo, are copied whole with */
+/* their type; any other size fails with ERROR_NOT_IMPLEMENTED, as in sample.c */
+static Object *CopySound(Object *srcObject, struct DataType *destDtn)
+{
+    BYTE *sample = NULL;
+    BYTE *copy;
+    ULONG length = 0;
+    ULONG period = 0;
+    ULONG volume = 64;
+    ULONG cycles = 1;
+    ULONG bits = 8;
+    ULONG sampleType = SDTST_M8S;
+    ULONG bytes;
+    Object *destObject;
+
+    GetDTAttrs(srcObject,
+               SDTA_Sample, (ULONG)&sample,
+               SDTA_SampleLength, (ULONG)&length,
+               SDTA_Period, (ULONG)&period,
+               SDTA_Volume, (ULONG)&volume,
+               SDTA_Cycles, (ULONG)&cycles,
+               TAG_DONE);
+    GetDTAttrs(srcObject, SDTA_BitsPerSample, (ULONG)&bits, TAG_DONE);
+    GetDTAttrs(srcObject, SDTA_SampleType, (ULONG)&sampleType, TAG_DONE);
+    if (!sample || length == 0) {
+        SetIoErr(ERROR_OBJECT_WRONG_TYPE);
+        return NULL;
+    }
+
+    /* SDTA_SampleLength counts sample frames, not bytes */
+    switch (sampleType) {
+        case SDTST_M8S:
+            bytes = 1;
+            break;
+        case SDTST_S8S:
+        case SDTST_M16S:
+            bytes = 2;
+            break;
+        case SDTST_S16S:
+            bytes = 4;
+            break;
+        default:
+            bytes = 0;
+            break;
+    }
+    if (bytes == 0 || bits != ((sampleType == SDTST_M16S || sampleType == SDTST_S16S) ? 16 : 8) ||
+        length > 0xFFFFFFFFUL / bytes) {
+        SetIoErr(ERROR_NOT_IMPLEMENTED);
+        return NULL;
+    }
+
+    /* sound.datatype frees SDTA_Sample with FreeVec() when disposed */
+    copy = (BYTE *)AllocVec(length * bytes, MEMF_PUBLIC);
+    if (!copy) {
+        SetIoErr(ERROR_NO_FREE_STORE);
+        return NULL;
+    }
+    CopyMem(sample, copy, length * bytes);
+
+    destObject = NewDTObject(NULL,
+                             DTA_SourceType, DTST_RAM,
+                             DTA_DataType, (ULONG)destDtn,
+                             DTA_GroupID, GID_SOUND,
+                             SDTA_SampleType, sampleType,
+                             SDTA_BitsPerSample, bits,
+                             SDTA_Sample, (ULONG)copy,
+                             SDTA_SampleLength, length,
+                             SDTA_Period, period,
+                             SDTA_Volume, volume,
+                             SDTA_Cycles, cycles,
+                             TAG_DONE);
+    if (!destObject) {
+        FreeVec(copy);
+        if (IoErr() == 0) {
+            SetIoErr(ERROR_OBJECT_WRONG_TYPE);
+        }
+    }
+    return destObject;
+}
+
+/* Make an object of destDtn's class holding a copy of a picture or sound */
+static Object *CopyToClass(Object *srcObject, ULONG groupID, struct DataType *destDtn)
+{
+    if (groupID == GID_PICTURE) {
+        return CopyPicture(srcObject, destDtn);
+    }
+    if (groupID == GID_SOUND) {
+        return CopySound(srcObject, destDtn);
+    }
+    SetIoErr(ERROR_OBJECT_WRONG_TYPE);
+    return NULL;
+}
+
+/* Write an object of another class as destDtn's format */
+/* A class without a writer of its own leaves DTM_WRITE to its superclass, */
+/* which saves IFF whatever the class; so the temporary file is identified */
+/* before it replaces outputFile, and anything identified as some other */
+/* format is refused with ERROR_OBJECT_WRONG_TYPE */
+static BOOL WriteAsFormat(Object *destObject, struct DataType *destDtn, STRPTR outputFile)
+{
+    UBYTE tempName[TEMP_NAME_SIZE];
+    struct DataType *dtn;
+    STRPTR baseName = destDtn->dtn_Header->dth_BaseName;
+    BOOL same = TRUE;
+    BPTR lock;
+
+    if (!WriteDTObjectTemp(destObject, outputFile, DTWM_RAW, tempName)) {
+        if (IoErr() == 0 || IoErr() == ERROR_NOT_IMPLEMENTED) {
+            SetIoErr(ERROR_OBJECT_WRONG_TYPE);
+        }
+        return FALSE;
+    }
+
+    /* A format the registry cannot recognise by content is taken on trust */
+    lock = OSLock((STRPTR)tempName);
+    if (lock) {
+        dtn = ObtainDataTypeA(DTST_FILE, (APTR)lock, NULL);
+        if (dtn) {
+            if (dtn->dtn_Header->dth_GroupID != GID_SYSTEM && dtn->dtn_Header->dth_BaseName &&
+                baseName && Stricmp(dtn->dtn_Header->dth_BaseName, baseName) != 0) {
+                same = FALSE;
+            }
+            ReleaseDataType(dtn);
+        }
+        OSUnLock(lock);
+    }
+
+    if (!same) {
+        OSDelete((STRPTR)tempName);
+        SetIoErr(ERROR_OBJECT_WRONG_TYPE);
+        return FALSE;
+    }
+
+    return OSCommitTemp((STRPTR)tempName, outputFile);
+}
+
+/* Convert file to specified format */
+/* The source's own class writes its own format. ILBM, 8SVX and AIFF have */
+/* writers here. Anything else is copied into an object of the target's */
+/* class, whose DTM_WRITE saves it; a target that class cannot write is */
+/* refused with ERROR_OBJECT_WRONG_TYPE rather than written in another format */
+BOOL ConvertToFormat(struct FileQuery *fq, struct DataType *destDtn, STRPTR outputFile)
+{
+    Object *srcObject = NULL;
+    Object *destObject = NULL;
+    STRPTR baseName;
+    STRPTR srcBaseName;
+    ULONG groupID;
+    LONG errorCode = 0;
+    BOOL result = FALSE;
+    struct EClockVal clock;
+    
+    if (!fq || !destDtn || !outputFile || !fq->fq_DataType) {
+        SetIoErr(ERROR_REQUIRED_ARG_MISSING);
+        return FALSE;
+    }
+    
+    /* Reuse the object decoded for the report, or decode it now */
+    /* The target is always in the source group, so no group filter is needed */
+    srcObject = GetFileObject(fq);
+    if (!srcObject) {
+        return FALSE;
+    }
+    groupID = fq->fq_DataType->dtn_Header->dth_GroupID;
+    baseName = destDtn->dtn_Header->dth_BaseName;
+    srcBaseName = fq->fq_DataType->dtn_Header->dth_BaseName;
+    if (!baseName) {
+        SetIoErr(ERROR_OBJECT_WRONG_TYPE);
+        return FALSE;
+    }
+    
+    /* RATE= and BITS= need the native writers, so only 8SVX and AIFF */
+    /* targets can take them */
+    if (groupID == GID_SOUND &&
+        (Stricmp(baseName, (STRPTR)"8svx") == 0 || Stricmp(baseName, (STRPTR)"aiff") == 0)) {
+        struct DTContext *ctx = fq->fq_Context;
+        ULONG bits = ctx ? ctx->dc_SampleBits : 0;
+        BOOL svx = (BOOL)(Stricmp(baseName, (STRPTR)"8svx") == 0);
+
+        if (svx && bits != 16) {
+            bits = 8;
+        } else if (!svx && bits != 8) {
+            bits = 16;
+        }
+
+        SetIoErr(0);
+        BeginPhase(&clock);
+        result = WriteSoundIFF(srcObject, outputFile, ctx ? ctx->dc_SampleRate : 0, bits,
+                               ctx ? ctx->dc_Compress : FALSE);
+        EndPhase(PHASE_CONVERT, &clock);
+        if (result || IoErr() != ERROR_NOT_IMPLEMENTED) {
+            return result;
+        }
+        /* Stereo is left to the class, which cannot resample */
+        if (ctx && (ctx->dc_SampleRate || ctx->dc_SampleBits)) {
+            return FALSE;
+        }
+        if (svx) {
+            return ConvertToIFF(fq, outputFile);
+        }
+    } else if (fq->fq_Context && (fq->fq_Context->dc_SampleRate || fq->fq_Context->dc_SampleBits) &&
+               groupID == GID_SOUND) {
+        Printf("Error: RATE and BITS can only be written as 8SVX (8 bits) or AIFF (16 bits)\n");
+        SetIoErr(ERROR_NOT_IMPLEMENTED);
+        return FALSE;
+    }
+
+    if (groupID == GID_PICTURE && Stricmp(baseName, (STRPTR)"ilbm") == 0) {
+        return ConvertToIFF(fq, outputFile);
+    }
+
+    BeginPhase(&clock);
+    SetIoErr(0);
+    if (srcBaseName && Stricmp(srcBaseName, baseName) == 0) {
+        /* The source's class writes its own format */
+        result = WriteDTObject(srcObject, outputFile, DTWM_RAW);
+    } else {
+        destObject = CopyToClass(srcObject, groupID, destDtn);
+        if (destObject) {
+            result = WriteAsFormat(destObject, destDtn, outputFile);
+            errorCode = IoErr();
+            DisposeDTObject(destObject);
+            SetIoErr(errorCode);
+        }
+    }
+    EndPhase(PHASE_CONVERT, &clock);
+
+    if (!result) {
+        errorCode = IoErr();
+        if (errorCode == 0) {
+            errorCode = ERROR_OBJECT_WRONG_TYPE;
+        }
+        SetIoErr(errorCode);
+    }
+    
+    return result;
+}
+
+/* Whether CONVERT AUTO should try writing a format of the source's group */
+/* Formats with a writer here always are; for the rest the class must */
+/* have a DTM_WRITE of its own, as found by GetWriteCapabilities(), whose */
+/* cache keeps the probe to once per class */
+static BOOL IsAutoFormat(struct FileQuery *fq, Object *srcObject, struct DataType *dtn, struct DTRecord *record)
+{
+    struct DTContext *ctx = fq->fq_Context;
+    STRPTR baseName = dtn->dtn_Header->dth_BaseName;
+    STRPTR srcBaseName = fq->fq_DataType->dtn_Header->dth_BaseName;
+    ULONG groupID = fq->fq_DataType->dtn_Header->dth_GroupID;
+    struct CacheEntry *ce;
+    Object *probe;
+
+    if (!baseName) {
+        return FALSE;
+    }
+    /* ILBM and 8SVX are the IFF encodings, tried first */
+    if ((groupID == GID_PICTURE && Stricmp(baseName, (STRPTR)"ilbm") == 0) ||
+        (groupID == GID_SOUND && Stricmp(baseName, (STRPTR)"8svx") == 0)) {
+        return FALSE;
+    }
+    if (groupID == GID_SOUND && Stricmp(baseName, (STRPTR)"aiff") == 0) {
+        return TRUE;
+    }
+
+    ce = FindCacheEntry(ctx, CACHE_WRITECAPS, baseName);
+    if (!ce) {
+        if (srcBaseName && Stricmp(srcBaseName, baseName) == 0) {
+            GetWriteCapabilities(ctx, srcObject, dtn, record);
+        } else {
+            /* A copy can fail for this source alone, so that is not cached */
+            probe = CopyToClass(srcObject, groupID, dtn);
+            if (!probe) {
+                return FALSE;
+            }
+            GetWriteCapabilities(ctx, probe, dtn, record);
+            DisposeDTObject(probe);
+        }
+        ce = FindCacheEntry(ctx, CACHE_WRITECAPS, baseName);
+    }
+
+    return (BOOL)(ce && (ce->ce_Value & WRITECAP_RAW));
+}
+
+/* Encode the decoded object every way this program can write its group, */
+/* keep the smallest file as outputFile and report the sizes compared. */
+/* The IFF encodings come first, then each format of the group whose */
+/* class can write it. Each goes to a short-named temporary file next to */
+/* outputFile, deleted at once unless it is the smallest so far, so the */
+/* one kept is renamed into place rather than written again. MAXTIME= */
+/* stops trying further encodings once that many ms have gone on encoding. */
+BOOL ConvertAuto(struct FileQuery *fq, STRPTR outputFile, BOOL force)
+{
+    struct DTContext *ctx;
+    struct OSFileInfo info;
+    struct EClockVal start;
+    struct DTRecord *record;
+    struct DataType *dtn = NULL;
+    struct DataType *prevdtn = NULL;
+    struct TagItem tags[3];
+    UBYTE temp[TEMP_NAME_SIZE];
+    UBYTE bestTemp[TEMP_NAME_SIZE];
+    UBYTE label[40];
+    UBYTE bestLabel[40];
+    Object *dtObject;
+    ULONG groupID;
+    ULONG maxMillis;
+    ULONG size;
+    ULONG bestSize = 0;
+    ULONG largest = 0;
+    BOOL haveBest = FALSE;
+    LONG kind;
+    BOOL compress;
+    BOOL timed;
+
+    if (!fq || !outputFile || !fq->fq_DataType) {
+        SetIoErr(ERROR_REQUIRED_ARG_MISSING);
+        return FALSE;
+    }
+    ctx = fq->fq_Context;
+    groupID = fq->fq_DataType->dtn_Header->dth_GroupID;
+    maxMillis = ctx ? ctx->dc_AutoMillis : 0;
+    compress = ctx ? ctx->dc_Compress : FALSE;
+
+    if (!CheckOutputFileExists(outputFile, force)) {
+        return FALSE;
+    }
+
+    /* The cap is on encoding; decoding happens once, before it */
+    dtObject = GetFileObject(fq);
+    if (!dtObject) {
+        return FALSE;
+    }
+
+    record = (struct DTRecord *)OSAllocMem(sizeof(struct DTRecord));
+    if (!record) {
+        SetIoErr(ERROR_NO_FREE_STORE);
+        return FALSE;
+    }
+
+    tags[0].ti_Tag = DTA_DataType;
+    tags[0].ti_Data = (ULONG)prevdtn;
+    tags[1].ti_Tag = DTA_GroupID;
+    tags[1].ti_Data = groupID;
+    tags[2].ti_Tag = TAG_DONE;
+
+    timed = OpenTimer();
+    ReadTimer(&start);
+
+    Printf("\nEncodings compared:\n");
+
+    for (kind = 0; ; kind++) {
+        ULONG micros;
+        BOOL ok = FALSE;
+
+        dtn = NULL;
+        if (kind >= AUTO_COUNT) {
+            /* Then the group's other formats, one datatype at a time */
+            dtn = ObtainDataTypeA(DTST_RAM, NULL, tags);
+            if (prevdtn) {
+                ReleaseDataType(prevdtn);
+            }
+            prevdtn = dtn;
+            tags[0].ti_Data = (ULONG)prevdtn;
+            if (!dtn) {
+                break;
+            }
+            if (!IsAutoFormat(fq, dtObject, dtn, record)) {
+                continue;
+            }
+        } else if (kind == AUTO_IFF_DELTA && (groupID != GID_SOUND || !compress)) {
+            /* Delta coding loses detail, so it is only tried when asked for */
+            continue;
+        }
+
+        if (SetSignal(0L, SIGBREAKF_CTRL_C) & SIGBREAKF_CTRL_C) {
+            SetIoErr(ERROR_BREAK);
+            break;
+        }
+        if (maxMillis && timed && haveBest && ElapsedMicros(&start) / 1000 >= maxMillis) {
+            Printf("  (MAXTIME=%lu reached, remaining encodings skipped)\n", maxMillis);
+            break;
+        }
+
+        if (dtn) {
+            SNPrintf(label, sizeof(label), "%s", dtn->dtn_Header->dth_BaseName);
+        } else {
+            SNPrintf(label, sizeof(label), (kind == AUTO_IFF) ? "IFF" : "IFF, delta-coded");
+        }
+
+        /* The writers make their own temporary file and rename it to this */
+        if (!OSTempName(outputFile, temp, sizeof(temp))) {
+            break;
+        }
+
+        micros = timed ? ElapsedMicros(&start) : 0;
+        SetIoErr(0);
+        if (dtn) {
+            ok = ConvertToFormat(fq, dtn, (STRPTR)temp);
+        } else {
+            if (ctx) {
+                ctx->dc_Compress = (BOOL)(kind == AUTO_IFF_DELTA);
+            }
+            ok = ConvertToIFF(fq, (STRPTR)temp);
+            if (ctx) {
+                ctx->dc_Compress = compress;
+            }
+        }
+        micros = timed ? ElapsedMicros(&start) - micros : 0;
+
+        if (!ok || !OSExamine((STRPTR)temp, &info)) {
+            Printf("  %-20s not written\n", (STRPTR)label);
+            OSDelete((STRPTR)temp);
+            continue;
+        }
+
+        /* Only the smallest so far is kept on disk */
+        size = info.ofi_Size;
+        if (size > largest) {
+            largest = size;
+        }
+        if (!haveBest || size < bestSize) {
+            if (haveBest) {
+                OSDelete((STRPTR)bestTemp);
+            }
+            Strncpy(bestTemp, temp, sizeof(bestTemp));
+            Strncpy(bestLabel, label, sizeof(bestLabel));
+            bestSize = size;
+            haveBest = TRUE;
+        } else {
+            OSDelete((STRPTR)temp);
+        }
+        Printf("  %-20s %9lu bytes %6lu ms\n", (STRPTR)label, size, micros / 1000);
+    }
+
+    if (prevdtn) {
+        ReleaseDataType(prevdtn);
+    }
+    if (timed) {
+        CloseTimer();
+    }
+    OSFreeMem(record);
+
+    if (!haveBest) {
+        if (IoErr() == 0) {
+            SetIoErr(ERROR_NOT_IMPLEMENTED);
+        }
+        return FALSE;
+    }
+
+    if (!OSCommitTemp((STRPTR)bestTemp, outputFile)) {
+        return FALSE;
+    }
+
+    Printf("Kept %s: %lu bytes", (STRPTR)bestLabel, bestSize);
+    if (largest > bestSize) {
+        Printf(", %lu bytes smaller than the largest", largest - bestSize);
+    }
+    Printf("\n");
+
+    return TRUE;
+}
+
+/* Write an object with its class's DTM_WRITE, in place of SaveDTObjectA() */
+/* The output goes through a DTWRITE_BUFFER_SIZE DOS buffer to a temporary */
+/* file beside outputFile, renamed over it only once DTM_WRITE succeeds, */
+/* so a failed conversion leaves neither a partial file nor a lost one */
+BOOL WriteDTObject(Object *dtObject, STRPTR outputFile, ULONG mode)
+{
+    UBYTE tempName[TEMP_NAME_SIZE];
+
+    if (!WriteDTObjectTemp(dtObject, outputFile, mode, tempName)) {
+        return FALSE;
+    }
+
+    return OSCommitTemp((STRPTR)tempName, outputFile);
+}
+
+/* Check if output file exists and handle FORCE flag */
+BOOL CheckOutputFileExists(STRPTR outputFile, BOOL force)
+{
+    struct OSFileInfo fileInfo;
+    BOOL exists = FALSE;
+    
+    if (!outputFile) {
+        return TRUE; /* No output file specified, nothing to check */
+    }
+    
+    /* Examine the file to see if it exists and is a file (not a directory) */
+    if (OSExamine(outputFile, &fileInfo) && fileInfo.ofi_Type == ST_FILE) {
+        exists = TRUE;
+    }
+    
+    if (exists && !force) {
+        /* File exists and FORCE not specified - error */
+        Printf("\nError: Output file already exists: %s\n", outputFile);
+        Printf("Use FORCE switch to overwrite existing file\n");
+        SetIoErr(ERROR_OBJECT_EXISTS);
+        return FALSE;
+    }
+    
+    return TRUE;
+}
@@ -0,0 +1,941 @@
+/*
+ * DataType - shared declarations
+ *
+ * Copyright (c) 2025 amigazen project
+ * Licensed under BSD 2-Clause License
+ */
+
+#ifndef DATATYPE_H
+#define DATATYPE_H
+
+#include <exec/types.h>
+#include <exec/execbase.h>
+#include <dos/dos.h>
+#include <dos/dosextens.h>
+#include <dos/notify.h>
+#include <intuition/intuition.h>
+#include <intuition/intuitionbase.h>
+#include <workbench/icon.h>
+#include <datatypes/datatypes.h>
+#include <datatypes/datatypesclass.h>
+#include <datatypes/animationclass.h>
+#include <datatypes/pictureclass.h>
+#include <datatypes/soundclass.h>
+#include <datatypes/textclass.h>
+#include <utility/tagitem.h>
+#include <devices/timer.h>
+
+/* These pragmas are currently missing from NDK3.2R4 */
+#pragma libcall DataTypesBase FindToolNodeA f6 9802
+#pragma tagcall DataTypesBase FindToolNode f6 9802
+#pragma libcall DataTypesBase LaunchToolA fc A9803
+#pragma tagcall DataTypesBase LaunchTool fc A9803
+
+/* Function prototypes for pragma functions */
+struct ToolNode *FindToolNodeA(struct List *, struct TagItem *);
+ULONG LaunchToolA(struct Tool *, STRPTR, struct TagItem *);
+
+/* Tool type constants */
+#ifndef TW_INFO
+#define TW_INFO      1
+#define TW_BROWSE    2
+#define TW_EDIT      3
+#define TW_PRINT     4
+#define TW_MAIL      5
+#endif
+
+/* Tool launch type constants */
+#ifndef TF_SHELL
+#define TF_SHELL     0x0001
+#define TF_WORKBENCH 0x0002
+#define TF_RX        0x0003
+#endif
+
+/* Tool attribute tags */
+#ifndef TOOLA_Dummy
+#define TOOLA_Dummy      (TAG_USER)
+#define TOOLA_Program    (TOOLA_Dummy + 1)
+#define TOOLA_Which      (TOOLA_Dummy + 2)
+#define TOOLA_LaunchType (TOOLA_Dummy + 3)
+#endif
+
+/* Macro to test if a datatype method is supported */
+#ifndef IsDTMethodSupported
+#define IsDTMethodSupported( o, id ) \
+    ((BOOL)FindMethod(GetDTMethods( (o) ), (id) ))
+#endif
+#include <proto/exec.h>
+#include <proto/dos.h>
+#include <proto/intuition.h>
+#include <proto/icon.h>
+#include <proto/datatypes.h>
+#include <proto/utility.h>
+#include <proto/graphics.h>
+#include <string.h>
+#include <stdlib.h>
+
+/* Library base pointers */
+extern struct ExecBase *SysBase;
+extern struct DosLibrary *DOSBase;
+extern struct IntuitionBase *IntuitionBase;
+extern struct Library *IconBase;
+extern struct Library *DataTypesBase;
+extern struct Library *UtilityBase;
+extern struct GfxBase *GfxBase;
+
+/* IFF chunk IDs */
+#ifndef MAKE_ID
+#define MAKE_ID(a,b,c,d) ((ULONG) (a)<<24 | (ULONG) (b)<<16 | (ULONG) (c)<<8 | (ULONG) (d))
+#endif
+
+#define ID_DTYP MAKE_ID('D','T','Y','P')
+#define ID_DTHD MAKE_ID('D','T','H','D')
+#define ID_DTTL MAKE_ID('D','T','T','L')
+#define ID_FORM MAKE_ID('F','O','R','M')
+
+/* Chunks of the formats written natively; see iffwrite.c */
+#ifndef ID_ILBM
+#define ID_ILBM MAKE_ID('I','L','B','M')
+#endif
+#ifndef ID_BMHD
+#define ID_BMHD MAKE_ID('B','M','H','D')
+#endif
+#ifndef ID_CMAP
+#define ID_CMAP MAKE_ID('C','M','A','P')
+#endif
+#ifndef ID_CAMG
+#define ID_CAMG MAKE_ID('C','A','M','G')
+#endif
+#ifndef ID_BODY
+#define ID_BODY MAKE_ID('B','O','D','Y')
+#endif
+#ifndef ID_8SVX
+#define ID_8SVX MAKE_ID('8','S','V','X')
+#endif
+#ifndef ID_VHDR
+#define ID_VHDR MAKE_ID('V','H','D','R')
+#endif
+#ifndef ID_AIFF
+#define ID_AIFF MAKE_ID('A','I','F','F')
+#endif
+#ifndef ID_COMM
+#define ID_COMM MAKE_ID('C','O','M','M')
+#endif
+#ifndef ID_SSND
+#define ID_SSND MAKE_ID('S','S','N','D')
+#endif
+
+/* Chunks only read, to estimate a decode; see estimate.c */
+#ifndef ID_ANIM
+#define ID_ANIM MAKE_ID('A','N','I','M')
+#endif
+#ifndef ID_ANHD
+#define ID_ANHD MAKE_ID('A','N','H','D')
+#endif
+
+/* 8SVX sCompression values */
+#ifndef CMP_NONE
+#define CMP_NONE     0
+#endif
+#ifndef CMP_FIBDELTA
+#define CMP_FIBDELTA 1
+#endif
+
+/* Largest DTYP descriptor that is loaded into memory */
+#define DTYP_MAX_SIZE  65536
+
+/* Size of the struct Tool header at the start of a DTTL chunk */
+#define DTTL_TOOL_SIZE 8
+
+/* Buffer size icon.library needs for ICONGETA_IdentifyBuffer */
+#define DEFICONS_TYPE_SIZE 256
+
+/* Kinds of cached lookup results; see cache.c */
+#define CACHE_DTYPPATH  0   /* BaseName -> DTYP descriptor path */
+#define CACHE_TOOL      1   /* "BaseName/which" -> program, value is which << 16 | flags */
+#define CACHE_DEFTOOL   2   /* DefIcons type -> default tool */
+#define CACHE_WRITECAPS 3   /* BaseName -> WRITECAP_ flags */
+
+#define WRITECAP_IFF 0x0001
+#define WRITECAP_RAW 0x0002
+
+/* One cached result; ce_Data is NULL for a cached miss */
+struct CacheEntry {
+    struct MinNode ce_Node;
+    ULONG ce_Kind;
+    ULONG ce_Value;
+    STRPTR ce_Key;
+    STRPTR ce_Data;
+};
+
+/* Learned descriptor order, kept between runs; see learn.c */
+#define HITS_DIR         "ENVARC:DataType"
+#define HITS_FILE        "ENVARC:DataType/hits"
+#define HITS_MAX_SIZE    16384
+#define HITS_PENDING     16     /* Hits counted before the candidates are built */
+#define HITS_LEARN_AFTER 8      /* Files identified before PreIdentify() starts */
+#define HITS_SAVE_EVERY  64     /* Hits saved even though the order held */
+
+/* An installed descriptor, ordered by how often it has identified files */
+struct Candidate {
+    struct DataType *cd_DataType;   /* Held until FreeCandidates() */
+    ULONG cd_Hits;
+    ULONG cd_Rank;                  /* Position in the library's own order */
+    STRPTR cd_Pattern;              /* Parsed name pattern, or NULL for any name */
+    BOOL cd_Usable;                 /* Can be decided from its mask alone */
+};
+
+/* A hit noted before the candidates were needed, by BaseName */
+struct PendingHit {
+    UBYTE ph_BaseName[32];
+    ULONG ph_Hits;
+};
+
+/* Files no descriptor identified, kept between runs; see unknown.c */
+#define UNKNOWN_FILE      "ENVARC:DataType/unknown"
+#define UNKNOWN_MAX_SIZE  1048576
+#define UNKNOWN_PATH_SIZE 512
+
+/* A file ObtainDataTypeA() could not identify, as it was then */
+struct UnknownFile {
+    ULONG uf_Hash;                  /* Of the file part of uf_Path, any case */
+    ULONG uf_Size;
+    struct DateStamp uf_Date;
+    STRPTR uf_Path;                 /* Full path from NameFromLock() */
+    BOOL uf_Allocated;              /* uf_Path is its own allocation, not in the loaded file */
+};
+
+/* Longest extension FAST maps to a descriptor, with its terminator */
+#define EXTENSION_SIZE 16
+
+/* Bytes of a file not loaded that FAST reads to check a mask against */
+#define FAST_HEADER_SIZE 256
+
+/* An extension a descriptor's pattern or BaseName names; see learn.c */
+struct ExtensionEntry {
+    UBYTE ee_Extension[EXTENSION_SIZE];
+    struct DataType *ee_DataType;   /* Owned by the candidate list */
+    ULONG ee_Rank;                  /* Registry order, for extensions several share */
+};
+
+/* Which way a file was identified */
+#define IDBY_NONE      0
+#define IDBY_EXTENSION 1            /* FAST: the extension's descriptor, checked by mask */
+#define IDBY_LEARNED   2            /* Learned descriptor order, by mask */
+#define IDBY_LIBRARY   3            /* ObtainDataTypeA() */
+#define IDBY_UNKNOWN   4            /* Remembered as unidentifiable, not tried */
+#define IDBY_COUNT     5
+
+/* Public port of a DataType SERVER */
+#define SERVER_PORT_NAME "DATATYPE"
+
+/* Request sent by a CLIENT; the server replies when the query is done */
+struct ServerMsg {
+    struct Message sm_Message;
+    STRPTR sm_Args;                 /* Argument line, newline terminated */
+    BPTR sm_CurrentDir;             /* Client's current directory */
+    BPTR sm_Input;                  /* Client's input and output streams */
+    BPTR sm_Output;
+    LONG sm_Result;                 /* Return code of the query */
+    LONG sm_Error;                  /* IoErr() after the query */
+};
+
+/* In-memory IFF FORM being read */
+struct IFFView {
+    UBYTE *iv_Buffer;
+    ULONG iv_Type;               /* FORM type, e.g. ID_DTYP */
+    ULONG iv_Pos;                /* Offset of the next chunk header */
+    ULONG iv_End;                /* End of the FORM within the buffer */
+};
+
+/* One chunk, pointing into the IFFView buffer */
+struct IFFChunk {
+    ULONG ic_ID;
+    ULONG ic_Size;
+    UBYTE *ic_Data;
+};
+
+/* Buffer through which an IFFWriter streams its FORM */
+#define IFFWRITE_BUFFER_SIZE 16384
+
+/* Longest temporary file name from OSCreateTemp() */
+#define TEMP_NAME_SIZE 264
+
+/* DOS buffer for class DTM_WRITE output, which comes in small writes */
+#define DTWRITE_BUFFER_SIZE 32768
+
+/* Largest ByteRun1 output for size input bytes */
+#define PACKED_SIZE(size) ((size) + ((size) + 127) / 128 + 1)
+
+/* A FORM being written; see iffwrite.c */
+struct IFFWriter {
+    BPTR iw_File;
+    STRPTR iw_Name;
+    UBYTE *iw_TempName;             /* Written here, renamed to iw_Name at the end */
+    UBYTE *iw_Buffer;
+    ULONG iw_Used;                  /* Bytes in iw_Buffer */
+    ULONG iw_Flushed;               /* Bytes already in the file */
+    ULONG iw_ChunkStart;            /* Offset of the open chunk's header */
+    LONG iw_Error;                  /* First error, or 0 */
+};
+
+/* Samples an SVXWriter encodes and writes at a time */
+#define SVX_BLOCK_SIZE 4096
+
+/* An 8SVX being written; see iffwrite.c */
+struct SVXWriter {
+    struct IFFWriter sw_IFF;
+    BOOL sw_Compress;               /* Fibonacci-delta BODY */
+    ULONG sw_Samples;               /* Samples written so far */
+    ULONG sw_CountOffset;           /* Offset of VHDR oneShotHiSamples */
+    LONG sw_Value;                  /* Value the decoder will have reached */
+    UBYTE *sw_Block;                /* Compressed bytes not yet written */
+    ULONG sw_BlockUsed;
+    UBYTE sw_Nibble;                /* High nibble waiting for its partner */
+    BOOL sw_HaveNibble;
+    UBYTE sw_Codes[511];            /* Nearest code for each difference + 255 */
+};
+
+/* A 16-bit AIFF being written; see iffwrite.c */
+struct AIFFWriter {
+    struct IFFWriter aw_IFF;
+    ULONG aw_Frames;                /* Samples written so far */
+    ULONG aw_CountOffset;           /* Offset of COMM numSampleFrames */
+};
+
+/* Samples RATE=/BITS= conversion holds at a time */
+#define SAMPLE_BLOCK_SIZE 4096
+
+/* Resampling and dither state carried between blocks; see sample.c */
+struct SampleConverter {
+    ULONG sc_Step;                  /* Input samples per output sample, 16.16 */
+    ULONG sc_Pos;                   /* Next output's position past sc_Prev, 16.16 */
+    LONG sc_Prev;                   /* Last input sample seen */
+    BOOL sc_Primed;                 /* sc_Prev holds a sample */
+    ULONG sc_Seed;                  /* Dither noise state */
+};
+
+/* Query phases timed by the STATS switch */
+#define PHASE_OBTAIN     0   /* ObtainDataTypeA() identification */
+#define PHASE_DECODE     1   /* NewDTObject() decode */
+#define PHASE_WRITEPROBE 2   /* SaveDTObjectA() write capability probes */
+#define PHASE_DEFICONS   3   /* DefIcons identification and default tool */
+#define PHASE_DTYPSCAN   4   /* DEVS:Datatypes scan and DTYP parsing */
+#define PHASE_CONVERT    5   /* SaveDTObjectA() conversion output */
+#define PHASE_COUNT      6
+
+/* Phase bit for a set of phases */
+#define PHASEF(phase) (1UL << (phase))
+
+/* Timing and I/O counters for one queried file */
+struct QueryStats {
+    struct EClockVal qs_Start;
+    ULONG qs_TotalMicros;
+    ULONG qs_PhaseMicros[PHASE_COUNT];
+    ULONG qs_PhaseCalls[PHASE_COUNT];
+    ULONG qs_Locks;
+    ULONG qs_Opens;
+    ULONG qs_Reads;
+    ULONG qs_Bytes;
+    ULONG qs_Allocs;
+    ULONG qs_Tested;                /* Descriptors tested to identify the file */
+    ULONG qs_RegistryRank;          /* Those the library alone would have tested */
+    UWORD qs_IdentifiedBy;          /* IDBY_ */
+};
+
+extern struct QueryStats *CurrentStats;
+
+/* Add to a counter of the file being queried (no-op unless STATS is on) */
+#define STAT_ADD(field, n) do { if (CurrentStats) { CurrentStats->field += (n); } } while (0)
+
+/* File information returned by the OS layer */
+struct OSFileInfo {
+    LONG ofi_Type;               /* < 0 for files, >= 0 for directories */
+    ULONG ofi_Size;
+    LONG ofi_Key;                /* On-disk key where the filesystem has one */
+    struct DateStamp ofi_Date;
+};
+
+/* ExAll() buffer of a directory being read; large, so one call gets many entries */
+#define OSDIR_BUFFER_SIZE 16384
+
+/* OSOpenDir() flags */
+#define OSDIRF_NOINFO 0x0001        /* Leave out #?.info entries */
+
+/* Directory being read through the OS layer */
+struct OSDir {
+    BPTR od_Lock;
+    struct ExAllControl *od_Control;
+    struct ExAllData *od_Buffer;
+    struct ExAllData *od_Next;      /* Next unread entry in od_Buffer */
+    BOOL od_More;                   /* ExAll() has more to give */
+    struct Hook od_Hook;            /* Match hook; see dtos.c */
+    ULONG od_Flags;                 /* OSDIRF_ flags */
+    STRPTR *od_Exclude;             /* NULL-terminated names to leave out, or NULL */
+};
+
+/* One directory entry; ode_Name is valid until the next call */
+struct OSDirEntry {
+    STRPTR ode_Name;
+    LONG ode_Type;
+    ULONG ode_Size;
+    struct DateStamp ode_Date;
+};
+
+/* Limits of a tree walk; deeper directories and longer paths are skipped */
+#define WALK_MAX_DEPTH 16
+#define WALK_PATH_SIZE 512
+
+/* Directory tree being walked depth first; see dtos.c */
+struct OSWalk {
+    struct OSDir *ow_Dir[WALK_MAX_DEPTH];   /* Open directory at each level */
+    UWORD ow_PathLen[WALK_MAX_DEPTH];       /* Length of ow_Path at each level */
+    UWORD ow_Depth;                         /* Levels open */
+    ULONG ow_Flags;                         /* OSDIRF_ flags for every level */
+    STRPTR *ow_Exclude;
+    ULONG ow_Skipped;                       /* Directories not entered */
+    UBYTE ow_Path[WALK_PATH_SIZE];
+};
+
+/* One entry of a tree walk; owe_Path is valid until the next call */
+struct OSWalkEntry {
+    STRPTR owe_Path;
+    STRPTR owe_Name;
+    LONG owe_Type;
+    ULONG owe_Size;
+    struct DateStamp owe_Date;
+    UWORD owe_Depth;                /* 0 for entries of the root */
+};
+
+/* Default size up to which a queried file is read into memory */
+#define DEFAULT_LOAD_CUTOFF 262144
+
+/* Bytes of a file not loaded that are read to estimate its decode */
+#define ESTIMATE_HEADER_SIZE 1024
+
+/* Free memory left over when a decode is admitted */
+#define ESTIMATE_RESERVE 65536
+
+/* Decoded size per file byte, when no header tells */
+#define ESTIMATE_RATIO_PICTURE 12
+#define ESTIMATE_RATIO_SOUND   4
+#define ESTIMATE_RATIO_OTHER   3
+
+/* Where a FootprintEstimate came from */
+#define ESTIMATE_NONE     0
+#define ESTIMATE_HEADER   1         /* BMHD, ANHD, VHDR, COMM or IHDR */
+#define ESTIMATE_FILESIZE 2         /* File size times the group's ratio */
+
+/* Memory a decode is expected to take; see estimate.c */
+struct FootprintEstimate {
+    ULONG fe_Total;                 /* Bytes in all */
+    ULONG fe_Largest;               /* The largest single allocation */
+    ULONG fe_Width;                 /* From the header, or 0 */
+    ULONG fe_Height;
+    ULONG fe_Depth;
+    ULONG fe_SampleLength;
+    ULONG fe_SamplesPerSec;
+    UWORD fe_Source;                /* ESTIMATE_ */
+};
+
+/* One file being queried; see source.c */
+struct FileQuery {
+    STRPTR fq_Name;
+    BPTR fq_Lock;
+    struct OSFileInfo fq_Info;
+    struct DataType *fq_DataType;   /* Set by ObtainFileDataType() */
+    UBYTE *fq_Buffer;               /* Whole file, or NULL if not loaded */
+    ULONG fq_BufferSize;
+    Object *fq_Object;              /* Set by GetFileObject() */
+    LONG fq_ObjectError;            /* IoErr() of a failed GetFileObject() */
+    struct DTContext *fq_Context;
+    BOOL fq_Borrowed;               /* fq_DataType belongs to the context's candidates */
+    UWORD fq_IdentifiedBy;          /* IDBY_ */
+    BOOL fq_MetadataOnly;           /* Not decoded, as it would not fit in memory */
+    struct FootprintEstimate fq_Estimate; /* Set by AdmitDecode() */
+};
+
+/* Encodings CONVERT AUTO tries before the group's other formats; see ConvertAuto() */
+#define AUTO_IFF       0    /* ConvertToIFF(), native writers where they apply */
+#define AUTO_IFF_DELTA 1    /* The same with COMPRESS, for sounds */
+#define AUTO_COUNT     2
+
+/* Outcome of ExplodeAnimation() */
+struct ExplodeResult {
+    ULONG er_Frames;                /* Frames written */
+    ULONG er_Micros;                /* Time taken, 0 if timer.device is not there */
+};
+
+/* Batch orders; see batch.c */
+#define ORDER_ARGS 0        /* As given on the command line */
+#define ORDER_DISK 1        /* By volume, directory and disk key; volumes in parallel */
+
+/* Reads queued per volume ahead of the file being handled */
+#define BATCH_READAHEAD 2
+
+/* States of a BatchFile */
+#define BATCH_PENDING 0
+#define BATCH_READING 1     /* ACTION_READ packet with the filesystem */
+#define BATCH_READY   2     /* Read, or not to be read ahead */
+#define BATCH_DONE    3
+
+/* One file of a batch; the packet comes first so a reply leads back to it */
+struct BatchFile {
+    struct StandardPacket bf_Packet;
+    STRPTR bf_Name;
+    ULONG bf_DirLen;                /* Length of the directory part of bf_Name */
+    struct MsgPort *bf_Handler;     /* Filesystem of the file, NULL if not found */
+    ULONG bf_Volume;                /* Volume number, in first-named order */
+    LONG bf_DirKey;                 /* Lowest disk key of the files in its directory */
+    LONG bf_Key;                    /* Disk key, where the filesystem has one */
+    ULONG bf_Size;
+    BPTR bf_File;                   /* Open while a read is queued */
+    UBYTE *bf_Buffer;               /* Whole file once read, or NULL */
+    UWORD bf_State;                 /* BATCH_ state */
+};
+
+/* A volume's run of files in the sorted batch */
+struct BatchVolume {
+    ULONG bv_First;
+    ULONG bv_Count;
+    ULONG bv_NextRead;              /* Next file to queue a read for */
+    ULONG bv_NextFile;              /* Next file to hand to the handler */
+    ULONG bv_InFlight;              /* Reads queued */
+};
+
+/* Caches and settings shared by every query; see dtlib.c */
+struct DTContext {
+    struct MinList dc_Cache;        /* CacheEntry list; see cache.c */
+    struct DateStamp dc_CacheStamp; /* DEVS:Datatypes date the cache belongs to */
+    ULONG dc_LoadCutoff;            /* Files up to this size are loaded; 0 = never */
+    ULONG dc_Fields;                /* RECF_ flags FillRecord() is asked for */
+    BOOL dc_Compress;               /* Compress IFF output where the format can */
+    ULONG dc_SampleRate;            /* RATE= for sound output; 0 = the sound's own */
+    ULONG dc_SampleBits;            /* BITS= for sound output; 0 = the sound's own */
+    ULONG dc_AutoMillis;            /* MAXTIME= for CONVERT AUTO; 0 = no limit */
+    ULONG dc_MemLimit;              /* MEMLIMIT= bytes a decode may take; 0 = free memory */
+    struct ToolNode dc_ToolNode;    /* DTYP fallback tool from FindToolByType() */
+    struct QueryStats *dc_Stats;    /* Per-file STATS records; see stats.c */
+    ULONG dc_StatsCount;
+    ULONG dc_StatsMax;
+    struct EClockVal dc_StatsStart; /* When the batch started */
+    UBYTE *dc_ReadAhead;            /* File read by the batch scheduler, for OpenFileQuery() */
+    ULONG dc_ReadAheadSize;
+    STRPTR dc_ReadAheadName;        /* The name it was read for */
+    struct Candidate *dc_Candidates; /* Learned descriptor order; see learn.c */
+    ULONG dc_CandidateCount;
+    BOOL dc_HitsDirty;              /* The learned order changed since loaded */
+    ULONG dc_HitsUnsaved;           /* Hits counted since loaded or saved */
+    struct PendingHit dc_Pending[HITS_PENDING]; /* Hits before BuildCandidates() */
+    ULONG dc_PendingCount;
+    BOOL dc_Fast;                   /* FAST: try the extension's descriptor first */
+    struct ExtensionEntry *dc_Extensions; /* Sorted by extension; see learn.c */
+    ULONG dc_ExtensionCount;
+    struct UnknownFile *dc_Unknown; /* Sorted by uf_Hash; see unknown.c */
+    ULONG dc_UnknownCount;
+    ULONG dc_UnknownMax;
+    UBYTE *dc_UnknownText;          /* UNKNOWN_FILE as loaded */
+    struct DateStamp dc_UnknownStamp; /* DEVS:Datatypes date the entries belong to */
+    BOOL dc_UnknownLoaded;
+    BOOL dc_UnknownDirty;           /* Entries changed since loaded */
+    BOOL dc_OwnsLibraries;          /* Libraries were opened by CreateDTContext() */
+};
+
+/* Fields of a DTRecord, set in dr_Valid when filled in */
+#define RECF_GROUP    0x0001
+#define RECF_BASENAME 0x0002
+#define RECF_NAME     0x0004
+#define RECF_DIMS     0x0008        /* dr_Width, dr_Height, dr_Depth */
+#define RECF_COLORS   0x0010
+#define RECF_FRAMES   0x0020
+#define RECF_AUDIO    0x0040        /* dr_SampleLength, dr_SamplesPerSec, dr_BitsPerSample */
+#define RECF_TEXT     0x0080
+#define RECF_WRITE    0x0100
+#define RECF_TOOLS    0x0200
+#define RECF_DEFICONS 0x0400
+#define RECF_ALL      0x07FF
+
+/* A field name for FIELDS= and the phases that must run to fill it in */
+/* Identification (PHASE_OBTAIN) is implied for every field */
+struct FieldDef {
+    STRPTR fd_Name;
+    ULONG fd_Field;                 /* RECF_ flag */
+    ULONG fd_Phases;                /* PHASEF() bits */
+};
+
+extern const struct FieldDef FieldMap[];
+
+/* Tool slots of a DTRecord: INFO, VIEW, EDIT, PRINT, MAIL */
+#define RECORD_TOOLS 5
+
+/* Everything found out about one file */
+struct DTRecord {
+    ULONG dr_Valid;                 /* RECF_ flags */
+    ULONG dr_GroupID;
+    ULONG dr_ID;
+    UBYTE dr_GroupName[32];
+    UBYTE dr_BaseName[32];
+    UBYTE dr_Name[64];
+    ULONG dr_Width;
+    ULONG dr_Height;
+    ULONG dr_Depth;
+    ULONG dr_Colors;
+    ULONG dr_Frames;
+    ULONG dr_SampleLength;
+    ULONG dr_SamplesPerSec;
+    ULONG dr_BitsPerSample;
+    ULONG dr_TextLength;
+    ULONG dr_WriteCaps;             /* WRITECAP_ flags */
+    UBYTE dr_DefIconsType[64];      /* Empty if DefIcons did not identify it */
+    UBYTE dr_DefIconsTool[256];
+    UWORD dr_ToolWhich[RECORD_TOOLS];       /* Tool type found; may be a fallback */
+    UBYTE dr_ToolProgram[RECORD_TOOLS][256];
+    BOOL dr_MetadataOnly;           /* Filled from headers; decoding was refused */
+    ULONG dr_Estimate;              /* Bytes the refused decode would have taken */
+    UWORD dr_IdentifiedBy;          /* IDBY_, reported with FAST */
+};
+
+/* WATCH: how long a directory must stay quiet before it is scanned, and */
+/* the longest a burst of changes may hold a scan back, in ticks */
+#define WATCH_SETTLE_TICKS 25
+#define WATCH_MAX_TICKS    250
+
+/* Index journal lines, and the DOS buffer they are written through */
+#define WATCH_LINE_SIZE   (WALK_PATH_SIZE + 160)
+#define WATCH_BUFFER_SIZE 8192
+
+/* Lines the journal may have beyond two per file before it is compacted */
+#define WATCH_COMPACT_SLACK 256
+
+/* Fields an index entry holds; FIELDS= narrows them further */
+#define WATCH_FIELDS (RECF_GROUP | RECF_BASENAME | RECF_DIMS | RECF_FRAMES | RECF_AUDIO)
+
+/* Files a watch writes itself, the index and a CATALOG, left out of it */
+#define WATCH_OWN_FILES 2
+
+/* One file of a WATCH index; see watch.c */
+struct IndexEntry {
+    STRPTR ie_Path;                 /* Full path, OSAllocMem()'d */
+    ULONG ie_Size;
+    struct DateStamp ie_Date;
+    ULONG ie_GroupID;               /* 0 if it could not be identified */
+    UBYTE ie_BaseName[32];
+    ULONG ie_Width;                 /* 0 for what was not worked out */
+    ULONG ie_Height;
+    ULONG ie_Depth;
+    ULONG ie_Frames;
+    ULONG ie_SamplesPerSec;
+    ULONG ie_SampleLength;
+    ULONG ie_Sequence;              /* Journal line it came from, while loading */
+    BOOL ie_Removed;                /* A removal line, while loading */
+    BOOL ie_Seen;                   /* Found by the scan in progress */
+};
+
+/* A directory being watched; the request must not move once started */
+struct WatchDir {
+    struct MinNode wd_Node;
+    struct NotifyRequest wd_Notify;
+    STRPTR wd_Path;                 /* Stored after the structure */
+    BOOL wd_Notified;               /* OSStartNotify() succeeded */
+    BOOL wd_Dirty;                  /* Changed since it was last scanned */
+    BOOL wd_Seen;                   /* Found by the scan of its parent */
+};
+
+/* CATALOG files: "DTCT", and the layout version */
+#define CATALOG_MAGIC   MAKE_ID('D','T','C','T')
+#define CATALOG_VERSION 1
+
+/* Keys a catalogue is sorted by, one CatalogKey array each */
+#define CATKEY_GROUP    0
+#define CATKEY_BASENAME 1           /* Value is the BaseName's rank among those in the file */
+#define CATKEY_SIZE     2
+#define CATKEY_WIDTH    3
+#define CATKEY_HEIGHT   4
+#define CATKEY_DEPTH    5
+#define CATKEY_FRAMES   6
+#define CATKEY_RATE     7
+#define CATKEY_LENGTH   8
+#define CATKEY_COUNT    9
+
+/* Terms a FIND= query may have; all must hold */
+#define CATALOG_MAX_TERMS 8
+
+/* A candidate range over this share of the records is read in order instead */
+#define CATALOG_SCAN_RATIO 8
+
+/* Keys or records read at a time while going through a range */
+#define CATALOG_READ_COUNT 256
+
+/* DOS buffer a catalogue is written through */
+#define CATALOG_BUFFER_SIZE 32768
+
+/* Start of a catalogue file; offsets are from the start of the file */
+struct CatalogHeader {
+    ULONG ch_Magic;                 /* CATALOG_MAGIC */
+    ULONG ch_Version;               /* CATALOG_VERSION */
+    ULONG ch_Count;                 /* Records */
+    ULONG ch_Records;               /* CatalogRecords, in path order */
+    ULONG ch_Keys;                  /* CATKEY_COUNT arrays of ch_Count CatalogKeys */
+    ULONG ch_BaseNames;             /* BaseNames in order, each ending in a NUL */
+    ULONG ch_BaseNameCount;
+    ULONG ch_BaseNameSize;
+    ULONG ch_Strings;               /* Paths, each ending in a NUL */
+};
+
+/* One identified file of a catalogue */
+struct CatalogRecord {
+    ULONG cr_Path;                  /* Offset from ch_Strings */
+    ULONG cr_PathLength;
+    ULONG cr_Values[CATKEY_COUNT];  /* By CATKEY_; 0 for what the file does not have */
+};
+
+/* Entry of a key array, sorted by value, then record */
+struct CatalogKey {
+    ULONG ck_Value;
+    ULONG ck_Record;
+};
+
+/* One term of a FIND= query: a key and the values it may take */
+struct CatalogTerm {
+    UWORD ct_Key;                   /* CATKEY_ */
+    ULONG ct_Low;
+    ULONG ct_High;
+    UBYTE ct_BaseName[32];          /* For CATKEY_BASENAME, looked up when searching */
+};
+
+/* A parsed FIND= query */
+struct CatalogQuery {
+    struct CatalogTerm cq_Terms[CATALOG_MAX_TERMS];
+    ULONG cq_TermCount;
+};
+
+/* A catalogue open for searching; see catalog.c */
+struct CatalogFile {
+    BPTR cf_File;
+    struct CatalogHeader cf_Header;
+    UBYTE *cf_BaseNames;            /* Loaded, ch_BaseNameSize bytes */
+    STRPTR *cf_BaseNameTable;       /* Each of them, by rank */
+    ULONG cf_Reads;                 /* Read() calls made searching */
+    ULONG cf_Candidates;            /* Records the last search looked at */
+};
+
+/* A result index kept up to date by WATCH; see watch.c */
+struct WatchIndex {
+    struct DTContext *wi_Context;
+    STRPTR wi_Name;
+    BPTR wi_Journal;                /* The index file, open at its end */
+    ULONG wi_JournalLines;
+    BOOL wi_Compact;                /* Rewrite the journal at the next flush */
+    struct DateStamp wi_Stamp;      /* DEVS:Datatypes date the entries belong to */
+    struct IndexEntry *wi_Entries;  /* Sorted by path up to wi_Sorted */
+    ULONG wi_Count;
+    ULONG wi_Sorted;
+    ULONG wi_Max;
+    struct MinList wi_Dirs;         /* WatchDir list */
+    struct MsgPort *wi_Port;        /* Notifications, or NULL if not watching */
+    struct DTRecord *wi_Record;     /* Filled in for each file identified */
+    ULONG wi_Checked;               /* Files looked at */
+    ULONG wi_Identified;            /* Of those, new or changed */
+    ULONG wi_Removed;
+    ULONG wi_Unnotified;            /* Directories OSStartNotify() refused */
+    UBYTE wi_Own[WATCH_OWN_FILES][WALK_PATH_SIZE]; /* Full paths of files written */
+    ULONG wi_OwnCount;
+};
+
+/* main.c */
+VOID ShowUsage(VOID);
+VOID ShowFields(VOID);
+LONG RunCommand(struct DTContext *ctx, LONG *args);
+LONG ServeArgs(struct DTContext *ctx, STRPTR argLine);
+
+/* datatype.c */
+BOOL InitializeLibraries(VOID);
+VOID Cleanup(VOID);
+LONG QueryDataType(struct DTContext *ctx, STRPTR fileName, STRPTR outputFile, STRPTR formats, BOOL edit, BOOL browse, BOOL info, BOOL print, BOOL mail, BOOL convert, BOOL autoFormat, BOOL explode, BOOL force);
+VOID PrintDataTypeInfo(struct DTRecord *record, STRPTR fileName);
+VOID PrintTools(struct DTRecord *record);
+
+/* dtlib.c */
+struct DTContext *CreateDTContext(VOID);
+VOID FreeDTContext(struct DTContext *ctx);
+BOOL FillRecord(struct DTContext *ctx, struct FileQuery *fq, struct DTRecord *record);
+BOOL DTIdentify(struct DTContext *ctx, STRPTR path, struct DTRecord *record);
+BOOL DTConvert(struct DTContext *ctx, STRPTR path, STRPTR formatBaseName, STRPTR target);
+BOOL ParseFields(STRPTR list, ULONG *fields);
+ULONG FieldPhases(ULONG fields);
+
+/* metadata.c */
+VOID GetDatatypeMetadata(Object *dtObject, ULONG groupID, struct DTRecord *record);
+VOID GetWriteCapabilities(struct DTContext *ctx, Object *dtObject, struct DataType *dtn, struct DTRecord *record);
+
+/* tools.c */
+STRPTR GetToolModeName(UWORD toolWhich);
+STRPTR GetLaunchTypeName(UWORD flags);
+struct ToolNode *FindToolByType(struct DTContext *ctx, struct DataType *dtn, UWORD toolType);
+VOID GetRecordTools(struct DTContext *ctx, struct DataType *dtn, struct DTRecord *record);
+VOID LaunchToolForFile(struct Tool *tool, STRPTR fileName);
+BOOL FindToolInDTYPFile(struct DTContext *ctx, struct DataType *dtn, UWORD toolType, struct Tool *toolOut);
+STRPTR FindDTYPFilePath(STRPTR baseName);
+BOOL ParseToolFromDTYP(STRPTR dtypPath, UWORD toolType, struct Tool *toolOut);
+
+/* deficons.c */
+STRPTR LookupDefIcons(struct DTContext *ctx, STRPTR fileName, STRPTR typeBuffer, ULONG typeSize, STRPTR *defaultTool);
+BOOL IsDefIconsRunning(VOID);
+STRPTR GetDefIconsTypeIdentifier(STRPTR fileName, BPTR fileLock, STRPTR typeBuffer);
+STRPTR GetDefIconsDefaultTool(STRPTR typeIdentifier);
+
+/* convert.c */
+BOOL ConvertTargets(struct FileQuery *fq, STRPTR targets, STRPTR formats, BOOL force);
+BOOL ConvertAuto(struct FileQuery *fq, STRPTR outputFile, BOOL force);
+BOOL ExplodeAnimation(struct FileQuery *fq, STRPTR outputBase, BOOL force, struct ExplodeResult *er);
+BOOL ConvertToIFF(struct FileQuery *fq, STRPTR outputFile);
+ULONG ListAvailableFormats(struct DataType *sourceDtn, ULONG groupID);
+struct DataType *SelectFormatFromList(ULONG groupID, LONG *selectedIndex);
+struct DataType *FindFormatByBaseName(ULONG groupID, STRPTR baseName);
+BOOL ConvertToFormat(struct FileQuery *fq, struct DataType *destDtn, STRPTR outputFile);
+BOOL WriteDTObject(Object *dtObject, STRPTR outputFile, ULONG mode);
+BOOL CheckOutputFileExists(STRPTR outputFile, BOOL force);
+
+/* source.c */
+BOOL OpenFileQuery(struct DTContext *ctx, struct FileQuery *fq, STRPTR fileName);
+VOID CloseFileQuery(struct FileQuery *fq);
+struct DataType *ObtainFileDataType(struct FileQuery *fq);
+Object *NewFileObject(struct FileQuery *fq, struct TagItem *extraTags);
+Object *GetFileObject(struct FileQuery *fq);
+
+/* estimate.c */
+BOOL EstimateFootprint(struct FileQuery *fq, struct FootprintEstimate *fe);
+BOOL AdmitDecode(struct FileQuery *fq);
+
+/* unknown.c */
+BOOL IsUnknownFile(struct FileQuery *fq);
+VOID NoteUnknownFile(struct FileQuery *fq, BOOL unknown);
+VOID ForgetUnknownFiles(struct DTContext *ctx);
+VOID SaveUnknownFiles(struct DTContext *ctx);
+VOID FreeUnknownFiles(struct DTContext *ctx);
+
+/* watch.c */
+struct WatchIndex *OpenWatchIndex(struct DTContext *ctx, STRPTR name, BOOL notify);
+BOOL IgnoreWatchFile(struct WatchIndex *wi, STRPTR name);
+BOOL WatchTree(struct WatchIndex *wi, STRPTR root);
+ULONG UpdateWatchIndex(struct WatchIndex *wi);
+BOOL FlushWatchIndex(struct WatchIndex *wi);
+VOID CloseWatchIndex(struct WatchIndex *wi);
+LONG RunWatch(struct DTContext *ctx, STRPTR *roots, ULONG count, STRPTR indexName, STRPTR catalogName, BOOL watch);
+
+/* catalog.c */
+BOOL WriteCatalog(STRPTR name, struct IndexEntry *entries, ULONG count);
+BOOL ParseCatalogQuery(STRPTR text, struct CatalogQuery *query);
+struct CatalogFile *OpenCatalog(STRPTR name);
+BOOL SearchCatalog(struct CatalogFile *cf, struct CatalogQuery *query,
+                   BOOL (*handler)(struct CatalogFile *cf, struct CatalogRecord *cr, APTR userData),
+                   APTR userData, ULONG *matches);
+BOOL ReadCatalogPath(struct CatalogFile *cf, struct CatalogRecord *cr, STRPTR buffer, ULONG size);
+VOID CloseCatalog(struct CatalogFile *cf);
+LONG RunFind(STRPTR catalogName, STRPTR query);
+
+/* batch.c */
+LONG RunBatch(struct DTContext *ctx, STRPTR *names, ULONG count, UWORD order,
+              LONG (*handler)(struct DTContext *ctx, STRPTR fileName, APTR userData), APTR userData);
+
+/* cache.c */
+struct CacheEntry *FindCacheEntry(struct DTContext *ctx, ULONG kind, STRPTR key);
+struct CacheEntry *AddCacheEntry(struct DTContext *ctx, ULONG kind, STRPTR key, ULONG value, STRPTR data);
+VOID FreeCache(struct DTContext *ctx);
+VOID ValidateCache(struct DTContext *ctx);
+
+/* learn.c */
+struct DataType *PreIdentify(struct DTContext *ctx, STRPTR fileName, UBYTE *data, ULONG size);
+struct DataType *FastIdentify(struct DTContext *ctx, STRPTR fileName, UBYTE *data, ULONG size);
+VOID NoteHit(struct DTContext *ctx, struct DataType *dtn, BOOL preIdentified);
+VOID SaveHits(struct DTContext *ctx);
+VOID FreeCandidates(struct DTContext *ctx);
+
+/* server.c */
+LONG RunServer(struct DTContext *ctx, LONG (*handler)(struct DTContext *ctx, STRPTR argLine));
+BOOL SendToServer(STRPTR argLine, BPTR input, BPTR output, LONG *result);
+
+/* iffview.c */
+ULONG GetIFFLong(UBYTE *data);
+UWORD GetIFFWord(UBYTE *data);
+BOOL InitIFFView(struct IFFView *view, UBYTE *buffer, ULONG size);
+BOOL NextIFFChunk(struct IFFView *view, struct IFFChunk *chunk);
+BOOL FindIFFChunk(struct IFFView *view, ULONG id, struct IFFChunk *chunk);
+BOOL UnpackByteRun1(UBYTE **src, UBYTE *srcEnd, UBYTE *dst, ULONG size);
+
+/* iffwrite.c */
+VOID PutIFFLong(UBYTE *data, ULONG value);
+VOID PutIFFWord(UBYTE *data, UWORD value);
+BOOL OpenIFFWriter(struct IFFWriter *iw, STRPTR name, ULONG formType);
+VOID WriteIFFData(struct IFFWriter *iw, APTR data, ULONG size);
+VOID BeginIFFChunk(struct IFFWriter *iw, ULONG id);
+VOID EndIFFChunk(struct IFFWriter *iw);
+BOOL CloseIFFWriter(struct IFFWriter *iw);
+ULONG PackByteRun1(UBYTE *src, ULONG size, UBYTE *dst);
+BOOL WriteILBM(STRPTR outputFile, struct BitMapHeader *bmh, struct BitMap *bm,
+               struct ColorRegister *colors, ULONG numColors, ULONG modeID);
+BOOL WritePictureILBM(Object *dtObject, STRPTR outputFile);
+BOOL OpenSVXWriter(struct SVXWriter *sw, STRPTR name, ULONG samplesPerSec, ULONG volume, BOOL compress);
+VOID WriteSVXSamples(struct SVXWriter *sw, BYTE *samples, ULONG count);
+BOOL CloseSVXWriter(struct SVXWriter *sw);
+BOOL OpenAIFFWriter(struct AIFFWriter *aw, STRPTR name, ULONG samplesPerSec);
+VOID WriteAIFFSamples(struct AIFFWriter *aw, WORD *samples, ULONG count);
+BOOL CloseAIFFWriter(struct AIFFWriter *aw);
+
+/* sample.c */
+VOID InitSampleConverter(struct SampleConverter *sc, ULONG inRate, ULONG outRate);
+ULONG SampleInputBlock(struct SampleConverter *sc);
+VOID ExpandSamples(BYTE *src, WORD *dst, ULONG count);
+ULONG ResampleSamples(struct SampleConverter *sc, WORD *src, ULONG count, WORD *dst);
+ULONG FinishResample(struct SampleConverter *sc, WORD *dst, ULONG max);
+VOID DitherSamples(struct SampleConverter *sc, WORD *src, BYTE *dst, ULONG count);
+BOOL WriteSoundIFF(Object *dtObject, STRPTR outputFile, ULONG rate, ULONG bits, BOOL compress);
+
+/* dtos.c */
+BPTR OSLock(STRPTR name);
+BPTR OSParentDir(BPTR lock);
+VOID OSUnLock(BPTR lock);
+BPTR OSOpen(STRPTR name);
+LONG OSRead(BPTR fh, APTR buffer, LONG length);
+BPTR OSCreate(STRPTR name);
+BPTR OSAppend(STRPTR name);
+LONG OSWrite(BPTR fh, APTR buffer, LONG length);
+BOOL OSSeek(BPTR fh, LONG position);
+BOOL OSDelete(STRPTR name);
+BOOL OSCreateDir(STRPTR name);
+BOOL OSTempName(STRPTR name, UBYTE *tempName, ULONG size);
+BPTR OSCreateTemp(STRPTR name, UBYTE *tempName, ULONG size, LONG bufferSize);
+BOOL OSCommitTemp(STRPTR tempName, STRPTR name);
+BOOL OSClose(BPTR fh);
+UBYTE *OSLoadFile(STRPTR name, ULONG maxSize, ULONG *size);
+BOOL OSExamineLock(BPTR lock, struct OSFileInfo *info);
+BOOL OSNameFromLock(BPTR lock, STRPTR buffer, ULONG size);
+BOOL OSExamine(STRPTR name, struct OSFileInfo *info);
+APTR OSAllocMem(ULONG size);
+VOID OSFreeMem(APTR memory);
+struct OSDir *OSOpenDir(STRPTR name, ULONG flags, STRPTR *exclude);
+BOOL OSNextDirEntry(struct OSDir *dir, struct OSDirEntry *entry);
+VOID OSCloseDir(struct OSDir *dir);
+struct OSWalk *OSOpenWalk(STRPTR root, ULONG flags, STRPTR *exclude);
+BOOL OSNextWalkEntry(struct OSWalk *walk, struct OSWalkEntry *entry);
+VOID OSCloseWalk(struct OSWalk *walk);
+BOOL OSStartNotify(struct NotifyRequest *nr, STRPTR name, struct MsgPort *port, ULONG userData);
+VOID OSEndNotify(struct NotifyRequest *nr);
+
+/* stats.c */
+BOOL OpenTimer(VOID);
+VOID CloseTimer(VOID);
+ULONG TimerFrequency(VOID);
+VOID ReadTimer(struct EClockVal *clock);
+ULONG ElapsedMicros(struct EClockVal *start);
+BOOL InitStats(struct DTContext *ctx, ULONG maxFiles);
+VOID FreeStats(struct DTContext *ctx);
+VOID BeginFileStats(struct DTContext *ctx);
+VOID EndFileStats(struct DTContext *ctx);
+VOID BeginPhase(struct EClockVal *clock);
+VOID EndPhase(UWORD phase, struct EClockVal *clock);
+STRPTR GetPhaseName(UWORD phase);
+VOID PrintFileStats(struct DTContext *ctx, STRPTR fileName);
+VOID PrintBatchStats(struct DTContext *ctx);
+
+#endif /* DATATYPE_H */
@@ -0,0 +1,218 @@
+/*
+ * DataType - DefIcons integration
+ *
+ * Copyright (c) 2025 amigazen project
+ * Licensed under BSD 2-Clause License
+ */
+
+#include "datatype.h"
+
+/* Check if DefIcons is running by looking for its message port */
+BOOL IsDefIconsRunning(VOID)
+{
+    struct MsgPort *port;
+    
+    if (!SysBase) {
+        return FALSE;
+    }
+    
+    /* Look for the DEFICONS message port */
+    port = FindPort("DEFICONS");
+    
+    if (port != NULL) {
+        return TRUE;
+    }
+    return FALSE;
+}
+
+/* Identify a file with DefIcons and look up the default tool for its type */
+/* Returns typeBuffer holding the type identifier, or NULL */
+/* *defaultTool receives an OSAllocMem()'d string or NULL; the caller frees it */
+STRPTR LookupDefIcons(struct DTContext *ctx, STRPTR fileName, STRPTR typeBuffer, ULONG typeSize, STRPTR *defaultTool)
+{
+    BPTR fileLock = NULL;
+    BPTR parentLock = NULL;
+    STRPTR defIconsType = NULL;
+    STRPTR result = NULL;
+    UBYTE identifyBuffer[DEFICONS_TYPE_SIZE];
+    struct EClockVal clock;
+    
+    if (defaultTool) {
+        *defaultTool = NULL;
+    }
+    
+    if (!fileName || !typeBuffer || typeSize == 0 || !IconBase || !IsDefIconsRunning()) {
+        return NULL;
+    }
+    
+    BeginPhase(&clock);
+    fileLock = OSLock(fileName);
+    if (fileLock) {
+        STRPTR filePartPtr;
+        UBYTE fileNameCopy[256];
+        STRPTR fileNamePart = NULL;
+        
+        /* Get just the filename part */
+        filePartPtr = FilePart(fileName);
+        
+        /* Make a copy of the filename part to ensure it's valid */
+        /* FilePart returns a pointer into the original string, which may become invalid */
+        if (filePartPtr != NULL && *filePartPtr != '\0') {
+            /* Use full buffer size - Strncpy will handle truncation and null-termination */
+            Strncpy(fileNameCopy, filePartPtr, sizeof(fileNameCopy));
+            fileNamePart = fileNameCopy;
+        } else {
+            /* Fallback: use the original fileName if FilePart fails */
+            fileNamePart = fileName;
+        }
+        
+        parentLock = OSParentDir(fileLock);
+        if (parentLock) {
+            defIconsType = GetDefIconsTypeIdentifier(fileNamePart, parentLock, identifyBuffer);
+            if (defIconsType && *defIconsType) {
+                Strncpy(typeBuffer, defIconsType, typeSize);
+                result = typeBuffer;
+                if (defaultTool) {
+                    /* Get DefIcons default tool, reading ENV: once per type */
+                    struct CacheEntry *ce = FindCacheEntry(ctx, CACHE_DEFTOOL, defIconsType);
+                    if (!ce) {
+                        STRPTR tool = GetDefIconsDefaultTool(defIconsType);
+                        ce = AddCacheEntry(ctx, CACHE_DEFTOOL, defIconsType, 0,
+                                           (tool && *tool != '\0') ? tool : NULL);
+                        OSFreeMem(tool);
+                    }
+                    if (ce && ce->ce_Data) {
+                        *defaultTool = (STRPTR)OSAllocMem(strlen(ce->ce_Data) + 1);
+                        if (*defaultTool) {
+                            strcpy(*defaultTool, ce->ce_Data);
+                        }
+                    }
+                }
+            }
+            OSUnLock(parentLock);
+        }
+        OSUnLock(fileLock);
+    }
+    EndPhase(PHASE_DEFICONS, &clock);
+    
+    return result;
+}
+
+/* Get file type identifier using icon.library identification (DefIcons) */
+/* typeBuffer must hold DEFICONS_TYPE_SIZE bytes; returns it, or NULL */
+STRPTR GetDefIconsTypeIdentifier(STRPTR fileName, BPTR fileLock, STRPTR typeBuffer)
+{
+    struct TagItem tags[4];
+    LONG errorCode = 0;
+    struct DiskObject *icon = NULL;
+    BPTR oldDir = NULL;
+    
+    if (!IconBase || !fileName || !typeBuffer) {
+        return NULL;
+    }
+    
+    /* Initialize buffer */
+    typeBuffer[0] = '\0';
+    
+    /* Change to file's directory for identification */
+    if (fileLock != NULL) {
+        oldDir = CurrentDir(fileLock);
+    }
+    
+    /* Set up tags for identification only */
+    tags[0].ti_Tag = ICONGETA_IdentifyBuffer;
+    tags[0].ti_Data = (ULONG)typeBuffer;
+    tags[1].ti_Tag = ICONGETA_IdentifyOnly;
+    tags[1].ti_Data = TRUE;
+    tags[2].ti_Tag = ICONA_ErrorCode;
+    tags[2].ti_Data = (ULONG)&errorCode;
+    tags[3].ti_Tag = TAG_DONE;
+    
+    /* Get file type identifier */
+    /* Note: With ICONGETA_IdentifyOnly, GetIconTagList returns NULL */
+    /* but the type identifier is placed in the buffer */
+    icon = GetIconTagList(fileName, tags);
+    
+    /* If icon was returned (shouldn't happen with IdentifyOnly), free it */
+    if (icon) {
+        FreeDiskObject(icon);
+    }
+    
+    /* Restore original directory */
+    if (oldDir != NULL) {
+        CurrentDir(oldDir);
+    }
+    
+    /* Return the type identifier, or NULL if identification failed */
+    /* Check both errorCode and that buffer has content */
+    if (errorCode == 0 && typeBuffer[0] != '\0') {
+        return typeBuffer;
+    }
+    
+    return NULL;
+}
+
+/* Get default tool from file type identifier (DefIcons) */
+/* Returns the default tool, or NULL if not found */
+STRPTR GetDefIconsDefaultTool(STRPTR typeIdentifier)
+{
+    struct DiskObject *defaultIcon = NULL;
+    STRPTR defaultTool = NULL;
+    UBYTE defIconName[64];
+    BPTR oldDir = NULL;
+    BPTR envDir = NULL;
+    
+    if (!IconBase || !typeIdentifier || *typeIdentifier == '\0') {
+        return NULL;
+    }
+    
+    /* Construct default icon name: def_XXX using SNPrintf */
+    SNPrintf(defIconName, sizeof(defIconName), "def_%s", typeIdentifier);
+    
+    /* Get the default icon from ENVARC:Sys/ or ENV:Sys/ */
+    
+    /* Try ENV:Sys first */
+    if ((envDir = OSLock("ENV:Sys")) != NULL) {
+        oldDir = CurrentDir(envDir);
+        defaultIcon = GetDiskObject(defIconName);
+        CurrentDir(oldDir);
+        OSUnLock(envDir);
+    }
+    
+    /* If not found, try ENVARC:Sys */
+    if (!defaultIcon && (envDir = OSLock("ENVARC:Sys")) != NULL) {
+        oldDir = CurrentDir(envDir);
+        defaultIcon = GetDiskObject(defIconName);
+        CurrentDir(oldDir);
+        OSUnLock(envDir);
+    }
+    
+    if (defaultIcon) {
+        /* Extract default tool from the icon */
+        /* do_DefaultTool is a STRPTR - check if it's not NULL and not empty */
+        if (defaultIcon->do_DefaultTool != NULL) {
+            /* Check if the string has content (not just a null terminator) */
+            if (defaultIcon->do_DefaultTool[0] != '\0') {
+                /* Copy the default tool string before freeing the DiskObject */
+                UBYTE toolBuffer[256];
+                ULONG toolLen;
+                
+                toolLen = strlen(defaultIcon->do_DefaultTool);
+                /* Pass the full buffer size (256) to Strncpy - it will handle truncation and null-termination */
+                Strncpy(toolBuffer, defaultIcon->do_DefaultTool, 256);
+                
+                /* Allocate memory for the tool name to return */
+                /* We need to allocate this because we're freeing the DiskObject */
+                defaultTool = OSAllocMem(toolLen + 1);
+                if (defaultTool) {
+                    Strncpy((UBYTE *)defaultTool, toolBuffer, toolLen + 1);
+                }
+            }
+        }
+        /* Note: If icon was found but has no default tool, defaultTool will be NULL */
+        
+        FreeDiskObject(defaultIcon);
+    }
+    
+    return defaultTool;
+}
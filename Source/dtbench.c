@@ -0,0 +1,2339 @@
+/*
+ * DTBench - DataType benchmark suite
+ *
+ * Copyright (c) 2025 amigazen project
+ * Licensed under BSD 2-Clause License
+ */
+
+#include "datatype.h"
+
+/* IFF chunk IDs used by the corpus generator */
+#ifndef ID_ILBM
+#define ID_ILBM MAKE_ID('I','L','B','M')
+#endif
+#ifndef ID_BMHD
+#define ID_BMHD MAKE_ID('B','M','H','D')
+#endif
+#ifndef ID_CMAP
+#define ID_CMAP MAKE_ID('C','M','A','P')
+#endif
+#ifndef ID_BODY
+#define ID_BODY MAKE_ID('B','O','D','Y')
+#endif
+#ifndef ID_DLTA
+#define ID_DLTA MAKE_ID('D','L','T','A')
+#endif
+#ifndef ID_8SVX
+#define ID_8SVX MAKE_ID('8','S','V','X')
+#endif
+#ifndef ID_VHDR
+#define ID_VHDR MAKE_ID('V','H','D','R')
+#endif
+#ifndef ID_FTXT
+#define ID_FTXT MAKE_ID('F','T','X','T')
+#endif
+#ifndef ID_CHRS
+#define ID_CHRS MAKE_ID('C','H','R','S')
+#endif
+
+/* Corpus formats, in the order they are generated */
+#define FMT_ILBM  0
+#define FMT_ANIM  1
+#define FMT_8SVX  2
+#define FMT_FTXT  3
+#define FMT_DTYP  4
+#define FMT_COUNT 5
+
+/* Defaults for the generator and the measurement loops */
+#define DEFAULT_COUNT      16
+#define DEFAULT_SIZE       16384
+#define DEFAULT_SEED       1985
+#define DEFAULT_ITERATIONS 4
+#define MAX_CORPUS_FILES   1024
+#define MUTATIONS          64
+#define RESULT_COUNT       36
+#define PACK_BUFFER_SIZE   65536
+#define PACK_ROW_BYTES     40
+#define ILBM_SCRATCH       "T:DTBench.ilbm"
+#define SVX_SCRATCH        "T:DTBench.8svx"
+#define FRAME_SCRATCH      "T:DTBench.frame"
+#define RATE_SCRATCH       "T:DTBench.rate"
+#define AUTO_SCRATCH       "T:DTBench.auto"
+#define FORMAT_SCRATCH     "T:DTBench.format"
+#define ANIM_SCRATCH       "T:DTBench.anim"
+#define WRITE_SCRATCH      "DTBench.write"
+#define UNKNOWN_SCRATCH    "T:DTBench.unknown"
+#define UNKNOWN_QUERIES    16
+#define WATCH_SCRATCH      "T:DTBench.index"
+#define WATCH_OWN_INDEX    "DTBench.index"
+#define WATCH_OWN_CATALOG  "DTBench.catalog"
+#define CATALOG_SCRATCH    "T:DTBench.catalog"
+#define CATALOG_RECORDS    20000
+#define CATALOG_QUERIES    6
+#define DTM_WRITE_BOGUS    0x7FFFFFFF
+#define SAMPLE_BUFFER_SIZE 65536
+
+/* One measured benchmark */
+struct BenchResult {
+    STRPTR br_Name;
+    ULONG br_Count;
+    ULONG br_Micros;
+};
+
+/* Corpus file as found in the corpus directory */
+struct CorpusFile {
+    UBYTE cf_Path[256];
+    UWORD cf_Format;
+    ULONG cf_Size;
+};
+
+static ULONG randomState = DEFAULT_SEED;
+
+/* Memory taken by an open SVXWriter, plain and delta-coded */
+static ULONG svxMemory[2];
+
+/* Files lost when a DTM_WRITE over them failed: SaveDTObjectA(), WriteDTObject() */
+static ULONG writeLost[2];
+static ULONG writeFailures;
+
+/* Largest resampling error on a ramp and largest dither bias, in 16-bit units */
+static ULONG resampleError;
+static ULONG ditherBias;
+
+/* FORMAT= targets tried, written, and written but identified as another format */
+static ULONG formatTried;
+static ULONG formatWritten;
+static ULONG formatMismatched;
+
+/* Decodes estimated against what they took, and files MEMLIMIT=1 refused */
+static ULONG footprintFiles;
+static ULONG footprintEstimated;
+static ULONG footprintMeasured;
+static ULONG footprintRefused;
+
+/* Estimates of one ANIM written with interleave 0 and with interleave 1 */
+static ULONG animEstimate[2];
+
+/* FAST identifications: files, decided by extension, same type as without FAST */
+static ULONG fastFiles;
+static ULONG fastByExtension;
+static ULONG fastAgreed;
+
+/* WATCH index of the walk tree: files, identified building it, identified reopening it, */
+/* and changes seen after rewriting an index and catalogue kept inside it */
+static ULONG watchFiles;
+static ULONG watchIdentified;
+static ULONG watchAgain;
+static ULONG watchOwn;
+
+/* Catalogue searched: records, queries made, reads, records looked at, matches */
+static ULONG catalogRecords = CATALOG_RECORDS;
+static ULONG catalogQueries;
+static ULONG catalogReads;
+static ULONG catalogCandidates;
+static ULONG catalogMatches;
+
+/* Checks that failed; any failure makes DTBench return RETURN_WARN */
+static ULONG checksFailed;
+
+static STRPTR formatExtensions[FMT_COUNT] = {
+    (STRPTR)"ilbm", (STRPTR)"anim", (STRPTR)"8svx", (STRPTR)"ftxt", (STRPTR)"dtyp"
+};
+
+/* BaseNames looked up in DEVS:Datatypes; the last one never matches */
+static STRPTR lookupNames[] = {
+    (STRPTR)"ilbm", (STRPTR)"anim", (STRPTR)"8svx", (STRPTR)"ftxt", (STRPTR)"ascii", (STRPTR)"zzznomatch", NULL
+};
+
+static const char *verstag = "$VER: DTBench 47.2 (2/1/2026)\n";
+static const char *stack_cookie = "$STACK: 8192\n";
+
+ULONG NextRandom(VOID);
+BOOL WriteCorpus(STRPTR dirName, ULONG count, ULONG size);
+BOOL WriteCorpusFile(STRPTR dirName, UWORD format, ULONG index, ULONG size);
+ULONG LoadCorpus(STRPTR dirName, struct CorpusFile *files, ULONG maxFiles, ULONG *totalBytes);
+ULONG WalkExNext(BPTR lock, struct FileInfoBlock *fib, ULONG depth);
+LONG BenchBatchFile(struct DTContext *ctx, STRPTR fileName, APTR userData);
+VOID RunBenchmarks(struct DTContext *ctx, struct CorpusFile *files, ULONG fileCount, ULONG iterations, STRPTR walkRoot, STRPTR writeDir, struct BenchResult *results);
+BOOL IsDataTypeResident(VOID);
+ULONG PackReference(UBYTE *src, ULONG size, UBYTE *dst);
+VOID BenchPacking(ULONG iterations, struct BenchResult *word, struct BenchResult *reference);
+BOOL CheckILBMRoundTrip(struct FileQuery *fq);
+BOOL CheckSVXRoundTrip(struct FileQuery *fq, BOOL compress);
+VOID CheckSampleAccuracy(VOID);
+VOID BenchSampleConversion(ULONG iterations, struct BenchResult *resample, struct BenchResult *dither);
+VOID BenchCatalog(ULONG iterations, struct BenchResult *write, struct BenchResult *find);
+BOOL CheckSoundResample(struct FileQuery *fq, ULONG *written);
+VOID CheckFailedWrite(Object *dtObject, STRPTR name);
+VOID CheckFootprint(struct DTContext *ctx, STRPTR fileName);
+VOID CheckAnimEstimate(struct DTContext *ctx);
+VOID CheckFormatWrites(struct DTContext *ctx, STRPTR fileName);
+VOID WriteResults(BPTR fh, struct BenchResult *results, ULONG resultCount, ULONG fileCount, ULONG totalBytes, ULONG iterations);
+
+/* Main entry point */
+int main(int argc, char *argv[])
+{
+    static const char *template = "DIR/A,MAKECORPUS/S,COUNT/N,SIZE/N,SEED/N,ITERATIONS/N,JSON/K,WALK/K,WRITETO/K,RECORDS/N";
+    LONG args[10];
+    struct RDArgs *rda = NULL;
+    struct DTContext *ctx = NULL;
+    struct CorpusFile *files = NULL;
+    struct BenchResult results[RESULT_COUNT];
+    STRPTR dirName;
+    ULONG count = DEFAULT_COUNT;
+    ULONG size = DEFAULT_SIZE;
+    ULONG iterations = DEFAULT_ITERATIONS;
+    ULONG fileCount = 0;
+    ULONG totalBytes = 0;
+    LONG result = RETURN_FAIL;
+
+    {
+        LONG i;
+        for (i = 0; i < 10; i++) {
+            args[i] = 0;
+        }
+    }
+
+    rda = ReadArgs(template, args, NULL);
+    if (!rda) {
+        PrintFault(IoErr(), "DTBench");
+        return RETURN_FAIL;
+    }
+
+    dirName = (STRPTR)args[0];
+    if (args[2]) {
+        count = *(ULONG *)args[2];
+    }
+    if (args[3]) {
+        size = *(ULONG *)args[3];
+    }
+    if (args[4]) {
+        randomState = *(ULONG *)args[4];
+    }
+    if (args[5]) {
+        iterations = *(ULONG *)args[5];
+    }
+    if (iterations == 0) {
+        iterations = 1;
+    }
+    if (args[9] && *(ULONG *)args[9] > 0) {
+        catalogRecords = *(ULONG *)args[9];
+    }
+
+    /* Generating the corpus needs no libraries beyond dos.library */
+    if (args[1]) {
+        if (WriteCorpus(dirName, count, size)) {
+            Printf("Corpus written to %s: %lu files per format, ~%lu bytes each\n", dirName, count, size);
+            result = RETURN_OK;
+        } else {
+            PrintFault(IoErr(), "DTBench");
+        }
+        FreeArgs(rda);
+        return result;
+    }
+
+    ctx = CreateDTContext();
+    if (!ctx) {
+        LONG errorCode = IoErr();
+        PrintFault(errorCode ? errorCode : ERROR_OBJECT_NOT_FOUND, "DTBench");
+        FreeArgs(rda);
+        return RETURN_FAIL;
+    }
+
+    if (!OpenTimer()) {
+        PrintFault(ERROR_OBJECT_NOT_FOUND, "DTBench");
+        FreeDTContext(ctx);
+        FreeArgs(rda);
+        return RETURN_FAIL;
+    }
+
+    files = (struct CorpusFile *)AllocVec(sizeof(struct CorpusFile) * MAX_CORPUS_FILES, MEMF_CLEAR);
+    if (files) {
+        fileCount = LoadCorpus(dirName, files, MAX_CORPUS_FILES, &totalBytes);
+        if (fileCount > 0) {
+            /* The walks default to the corpus; point WALK at a large tree, */
+            /* and WRITETO at a slow device to time output there */
+            RunBenchmarks(ctx, files, fileCount, iterations, args[7] ? (STRPTR)args[7] : dirName,
+                          args[8] ? (STRPTR)args[8] : (STRPTR)"T:", results);
+
+            if (args[6]) {
+                BPTR fh = Open((STRPTR)args[6], MODE_NEWFILE);
+                if (fh) {
+                    WriteResults(fh, results, RESULT_COUNT, fileCount, totalBytes, iterations);
+                    Close(fh);
+                    result = RETURN_OK;
+                } else {
+                    PrintFault(IoErr(), "DTBench");
+                }
+            } else {
+                WriteResults(Output(), results, RESULT_COUNT, fileCount, totalBytes, iterations);
+                result = RETURN_OK;
+            }
+
+            /* A wrong result fails the run even though it was measured */
+            if (result == RETURN_OK && checksFailed > 0) {
+                Printf("DTBench: %lu checks failed\n", checksFailed);
+                result = RETURN_WARN;
+            }
+        } else {
+            Printf("No corpus files found in %s (use MAKECORPUS first)\n", dirName);
+        }
+        FreeVec(files);
+    } else {
+        PrintFault(ERROR_NO_FREE_STORE, "DTBench");
+    }
+
+    CloseTimer();
+    FreeDTContext(ctx);
+    FreeArgs(rda);
+
+    return result;
+}
+
+/* Deterministic pseudo-random generator so corpora are reproducible */
+ULONG NextRandom(VOID)
+{
+    randomState = randomState * 1103515245 + 12345;
+    return (randomState >> 16) & 0x7FFF;
+}
+
+/* Write a complete corpus into dirName */
+BOOL WriteCorpus(STRPTR dirName, ULONG count, ULONG size)
+{
+    BPTR lock;
+    UWORD format;
+    ULONG i;
+
+    /* Create the corpus directory if it does not exist yet */
+    lock = Lock(dirName, ACCESS_READ);
+    if (!lock) {
+        lock = CreateDir(dirName);
+        if (!lock) {
+            return FALSE;
+        }
+    }
+    UnLock(lock);
+
+    for (format = 0; format < FMT_COUNT; format++) {
+        for (i = 0; i < count; i++) {
+            if (!WriteCorpusFile(dirName, format, i, size)) {
+                return FALSE;
+            }
+        }
+    }
+
+    return TRUE;
+}
+
+/* Write a big-endian LONG */
+static BOOL PutLong(BPTR fh, ULONG value)
+{
+    UBYTE buf[4];
+
+    buf[0] = (UBYTE)(value >> 24);
+    buf[1] = (UBYTE)(value >> 16);
+    buf[2] = (UBYTE)(value >> 8);
+    buf[3] = (UBYTE)value;
+
+    return (BOOL)(FWrite(fh, buf, 4, 1) == 1);
+}
+
+/* Write a big-endian WORD */
+static BOOL PutWord(BPTR fh, UWORD value)
+{
+    UBYTE buf[2];
+
+    buf[0] = (UBYTE)(value >> 8);
+    buf[1] = (UBYTE)value;
+
+    return (BOOL)(FWrite(fh, buf, 2, 1) == 1);
+}
+
+/* Write count pseudo-random bytes, optionally restricted to printable text */
+static BOOL PutRandomBytes(BPTR fh, ULONG count, BOOL text)
+{
+    ULONG i;
+
+    for (i = 0; i < count; i++) {
+        UBYTE c = (UBYTE)NextRandom();
+        if (text) {
+            c = (UBYTE)((i % 64) == 63 ? '\n' : 'a' + (c % 26));
+        }
+        if (FPutC(fh, c) < 0) {
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+/* Write a BMHD chunk */
+static BOOL PutBMHD(BPTR fh, UWORD width, UWORD height, UBYTE depth)
+{
+    BOOL ok = TRUE;
+
+    ok = ok && PutLong(fh, ID_BMHD) && PutLong(fh, 20);
+    ok = ok && PutWord(fh, width) && PutWord(fh, height);
+    ok = ok && PutWord(fh, 0) && PutWord(fh, 0);
+    ok = ok && FPutC(fh, depth) >= 0 && FPutC(fh, mskNone) >= 0;
+    ok = ok && FPutC(fh, cmpNone) >= 0 && FPutC(fh, 0) >= 0;
+    ok = ok && PutWord(fh, 0);
+    ok = ok && FPutC(fh, 10) >= 0 && FPutC(fh, 11) >= 0;
+    ok = ok && PutWord(fh, width) && PutWord(fh, height);
+
+    return ok;
+}
+
+/* Write a CMAP chunk with a deterministic palette */
+static BOOL PutCMAP(BPTR fh, UBYTE depth)
+{
+    ULONG colors = 1UL << depth;
+    BOOL ok;
+
+    ok = PutLong(fh, ID_CMAP) && PutLong(fh, colors * 3);
+    ok = ok && PutRandomBytes(fh, colors * 3, FALSE);
+    if (ok && ((colors * 3) & 1)) {
+        ok = (BOOL)(FPutC(fh, 0) >= 0);
+    }
+
+    return ok;
+}
+
+/* Write an ANIM: a key frame followed by empty ANIM5 deltas of about */
+/* size bytes in all. interleave goes in each ANHD; 0 means deltas */
+/* alternate between two buffers, 1 that they all go to one */
+static BOOL PutANIM(BPTR fh, ULONG size, UBYTE interleave)
+{
+    UBYTE depth = 3;
+    UWORD width = 160;
+    UWORD height = 100;
+    UWORD rowBytes = ((width + 15) >> 4) << 1;
+    ULONG bodySize = (ULONG)rowBytes * depth * height;
+    ULONG keySize = 4 + 28 + 8 + 24 + 8 + bodySize;
+    ULONG deltaSize = 4 + 48 + 8 + 64;
+    ULONG frames = size > bodySize ? size / bodySize + 1 : 2;
+    ULONG f;
+    BOOL ok;
+
+    ok = PutLong(fh, ID_FORM) && PutLong(fh, 4 + 8 + keySize + (frames - 1) * (8 + deltaSize));
+    ok = ok && PutLong(fh, ID_ANIM);
+
+    ok = ok && PutLong(fh, ID_FORM) && PutLong(fh, keySize) && PutLong(fh, ID_ILBM);
+    ok = ok && PutBMHD(fh, width, height, depth);
+    ok = ok && PutCMAP(fh, depth);
+    ok = ok && PutLong(fh, ID_BODY) && PutLong(fh, bodySize);
+    ok = ok && PutRandomBytes(fh, bodySize, FALSE);
+
+    for (f = 1; ok && f < frames; f++) {
+        ULONG i;
+
+        ok = PutLong(fh, ID_FORM) && PutLong(fh, deltaSize) && PutLong(fh, ID_ILBM);
+
+        /* ANHD: operation 5, one jiffy per frame, then the interleave */
+        ok = ok && PutLong(fh, ID_ANHD) && PutLong(fh, 40);
+        ok = ok && FPutC(fh, 5) >= 0 && FPutC(fh, 0) >= 0;
+        ok = ok && PutWord(fh, width) && PutWord(fh, height);
+        ok = ok && PutWord(fh, 0) && PutWord(fh, 0);
+        ok = ok && PutLong(fh, 0) && PutLong(fh, 1);
+        ok = ok && FPutC(fh, interleave) >= 0 && FPutC(fh, 0) >= 0;
+        ok = ok && PutLong(fh, 0);
+        for (i = 0; ok && i < 16; i++) {
+            ok = (BOOL)(FPutC(fh, 0) >= 0);
+        }
+
+        /* DLTA: sixteen zero plane offsets mean "no change" */
+        ok = ok && PutLong(fh, ID_DLTA) && PutLong(fh, 64);
+        for (i = 0; ok && i < 16; i++) {
+            ok = PutLong(fh, 0);
+        }
+    }
+
+    return ok;
+}
+
+/* Write one corpus file of the given format */
+BOOL WriteCorpusFile(STRPTR dirName, UWORD format, ULONG index, ULONG size)
+{
+    UBYTE path[256];
+    UBYTE name[32];
+    BPTR fh;
+    BOOL ok = TRUE;
+
+    SNPrintf(name, sizeof(name), "%s%04lu.%s", formatExtensions[format], index, formatExtensions[format]);
+    Strncpy(path, dirName, sizeof(path));
+    if (!AddPart(path, name, sizeof(path))) {
+        SetIoErr(ERROR_LINE_TOO_LONG);
+        return FALSE;
+    }
+
+    fh = Open(path, MODE_NEWFILE);
+    if (!fh) {
+        return FALSE;
+    }
+    SetVBuf(fh, NULL, BUF_FULL, 8192);
+
+    switch (format) {
+        case FMT_ILBM:
+        {
+            /* 4-bitplane image whose BODY is roughly size bytes */
+            UBYTE depth = 4;
+            UWORD width = 320;
+            UWORD rowBytes = ((width + 15) >> 4) << 1;
+            UWORD height = (UWORD)(size / (rowBytes * depth));
+            ULONG bodySize;
+
+            if (height == 0) {
+                height = 1;
+            }
+            bodySize = (ULONG)rowBytes * depth * height;
+
+            ok = PutLong(fh, ID_FORM) && PutLong(fh, 4 + 28 + 8 + 48 + 8 + bodySize);
+            ok = ok && PutLong(fh, ID_ILBM);
+            ok = ok && PutBMHD(fh, width, height, depth);
+            ok = ok && PutCMAP(fh, depth);
+            ok = ok && PutLong(fh, ID_BODY) && PutLong(fh, bodySize);
+            ok = ok && PutRandomBytes(fh, bodySize, FALSE);
+            break;
+        }
+
+        case FMT_ANIM:
+            ok = PutANIM(fh, size, 0);
+            break;
+
+        case FMT_8SVX:
+        {
+            ULONG samples = (size + 1) & ~1UL;
+
+            ok = PutLong(fh, ID_FORM) && PutLong(fh, 4 + 28 + 8 + samples);
+            ok = ok && PutLong(fh, ID_8SVX);
+            ok = ok && PutLong(fh, ID_VHDR) && PutLong(fh, 20);
+            ok = ok && PutLong(fh, samples) && PutLong(fh, 0) && PutLong(fh, 32);
+            ok = ok && PutWord(fh, 8363) && FPutC(fh, 1) >= 0 && FPutC(fh, 0) >= 0;
+            ok = ok && PutLong(fh, 0x10000);
+            ok = ok && PutLong(fh, ID_BODY) && PutLong(fh, samples);
+            ok = ok && PutRandomBytes(fh, samples, FALSE);
+            break;
+        }
+
+        case FMT_FTXT:
+        {
+            ULONG chars = (size + 1) & ~1UL;
+
+            ok = PutLong(fh, ID_FORM) && PutLong(fh, 4 + 8 + chars);
+            ok = ok && PutLong(fh, ID_FTXT);
+            ok = ok && PutLong(fh, ID_CHRS) && PutLong(fh, chars);
+            ok = ok && PutRandomBytes(fh, chars, TRUE);
+            break;
+        }
+
+        case FMT_DTYP:
+        {
+            /* Descriptor with a DTHD and one DTTL chunk per tool type */
+            UBYTE baseName[16];
+            UBYTE pattern[24];
+            UBYTE program[40];
+            ULONG nameLen, baseLen, patLen, progLen;
+            ULONG maskOffset, dthdSize, dttlSize;
+            UWORD tool;
+
+            SNPrintf(baseName, sizeof(baseName), "bench%04lu", index);
+            SNPrintf(pattern, sizeof(pattern), "#?.b%04lu", index);
+            nameLen = strlen("Benchmark descriptor") + 1;
+            baseLen = strlen(baseName) + 1;
+            patLen = strlen(pattern) + 1;
+            /* The mask is a WORD array and must stay word aligned */
+            maskOffset = (32 + nameLen + baseLen + patLen + 1) & ~1UL;
+            dthdSize = maskOffset + 4;
+
+            ok = PutLong(fh, ID_FORM);
+            {
+                ULONG formSize = 4 + 8 + dthdSize;
+                for (tool = TW_INFO; tool <= TW_MAIL; tool++) {
+                    SNPrintf(program, sizeof(program), "SYS:Utilities/Bench%lu", (ULONG)tool);
+                    dttlSize = (8 + strlen(program) + 1 + 1) & ~1UL;
+                    formSize += 8 + dttlSize;
+                }
+                ok = ok && PutLong(fh, formSize);
+            }
+            ok = ok && PutLong(fh, ID_DTYP);
+
+            /* DTHD: offsets are relative to the chunk data */
+            ok = ok && PutLong(fh, ID_DTHD) && PutLong(fh, dthdSize);
+            ok = ok && PutLong(fh, 32);
+            ok = ok && PutLong(fh, 32 + nameLen);
+            ok = ok && PutLong(fh, 32 + nameLen + baseLen);
+            ok = ok && PutLong(fh, maskOffset);
+            ok = ok && PutLong(fh, GID_SYSTEM);
+            ok = ok && PutLong(fh, MAKE_ID('B','N','C','H'));
+            ok = ok && PutWord(fh, 2) && PutWord(fh, 0);
+            ok = ok && PutWord(fh, DTF_BINARY) && PutWord(fh, 0);
+            ok = ok && FWrite(fh, "Benchmark descriptor", nameLen, 1) == 1;
+            ok = ok && FWrite(fh, baseName, baseLen, 1) == 1;
+            ok = ok && FWrite(fh, pattern, patLen, 1) == 1;
+            if (ok && maskOffset != 32 + nameLen + baseLen + patLen) {
+                ok = (BOOL)(FPutC(fh, 0) >= 0);
+            }
+            ok = ok && PutWord(fh, 0xBE) && PutWord(fh, 0xEC);
+
+            for (tool = TW_INFO; ok && tool <= TW_MAIL; tool++) {
+                SNPrintf(program, sizeof(program), "SYS:Utilities/Bench%lu", (ULONG)tool);
+                progLen = strlen(program) + 1;
+                dttlSize = 8 + progLen;
+                ok = PutLong(fh, ID_DTTL) && PutLong(fh, dttlSize);
+                ok = ok && PutWord(fh, tool) && PutWord(fh, TF_SHELL);
+                ok = ok && PutLong(fh, 8);
+                ok = ok && FWrite(fh, program, progLen, 1) == 1;
+                if (ok && (dttlSize & 1)) {
+                    ok = (BOOL)(FPutC(fh, 0) >= 0);
+                }
+            }
+            break;
+        }
+    }
+
+    if (!Close(fh)) {
+        ok = FALSE;
+    }
+
+    if (!ok) {
+        LONG errorCode = IoErr();
+        DeleteFile(path);
+        SetIoErr(errorCode ? errorCode : ERROR_WRITE_PROTECTED);
+    }
+
+    return ok;
+}
+
+/* Collect corpus files by extension */
+ULONG LoadCorpus(STRPTR dirName, struct CorpusFile *files, ULONG maxFiles, ULONG *totalBytes)
+{
+    BPTR lock;
+    struct FileInfoBlock *fib;
+    ULONG count = 0;
+
+    *totalBytes = 0;
+
+    lock = Lock(dirName, ACCESS_READ);
+    if (!lock) {
+        return 0;
+    }
+
+    fib = (struct FileInfoBlock *)AllocDosObject(DOS_FIB, NULL);
+    if (!fib) {
+        UnLock(lock);
+        return 0;
+    }
+
+    if (Examine(lock, fib)) {
+        while (count < maxFiles && ExNext(lock, fib)) {
+            STRPTR ext;
+            UWORD format;
+
+            if (fib->fib_DirEntryType >= 0) {
+                continue;
+            }
+
+            ext = strrchr(fib->fib_FileName, '.');
+            if (!ext) {
+                continue;
+            }
+            ext++;
+
+            for (format = 0; format < FMT_COUNT; format++) {
+                if (Stricmp(ext, formatExtensions[format]) == 0) {
+                    Strncpy(files[count].cf_Path, dirName, sizeof(files[count].cf_Path));
+                    AddPart(files[count].cf_Path, fib->fib_FileName, sizeof(files[count].cf_Path));
+                    files[count].cf_Format = format;
+                    files[count].cf_Size = fib->fib_Size;
+                    *totalBytes += fib->fib_Size;
+                    count++;
+                    break;
+                }
+            }
+        }
+    }
+
+    FreeDosObject(DOS_FIB, fib);
+    UnLock(lock);
+
+    return count;
+}
+
+/* Run every benchmark over the corpus */
+VOID RunBenchmarks(struct DTContext *ctx, struct CorpusFile *files, ULONG fileCount, ULONG iterations, STRPTR walkRoot, STRPTR writeDir, struct BenchResult *results)
+{
+    struct DTRecord *record;
+    struct EClockVal start;
+    BPTR nilOut;
+    BPTR oldOut = NULL;
+    ULONG iter;
+    ULONG i;
+    ULONG f;
+
+    for (i = 0; i < RESULT_COUNT; i++) {
+        results[i].br_Count = 0;
+        results[i].br_Micros = 0;
+    }
+    results[0].br_Name = (STRPTR)"identify";
+    results[1].br_Name = (STRPTR)"descriptor_lookup";
+    results[2].br_Name = (STRPTR)"dttl_parse";
+    results[3].br_Name = (STRPTR)"metadata";
+    results[4].br_Name = (STRPTR)"format";
+    results[5].br_Name = (STRPTR)"dttl_mutate";
+    results[6].br_Name = (STRPTR)"identify_loaded";
+    results[7].br_Name = (STRPTR)"server_query";
+    results[8].br_Name = (STRPTR)"cold_query";
+    results[9].br_Name = (STRPTR)"fields_minimal";
+    results[10].br_Name = (STRPTR)"fields_check";
+    results[11].br_Name = (STRPTR)"walk_exall";
+    results[12].br_Name = (STRPTR)"walk_exnext";
+    results[13].br_Name = (STRPTR)"batch_args";
+    results[14].br_Name = (STRPTR)"batch_disk";
+    results[15].br_Name = (STRPTR)"ilbm_pack";
+    results[16].br_Name = (STRPTR)"ilbm_pack_ref";
+    results[17].br_Name = (STRPTR)"ilbm_write";
+    results[18].br_Name = (STRPTR)"svx_write";
+    results[19].br_Name = (STRPTR)"svx_write_delta";
+    results[20].br_Name = (STRPTR)"anim_explode";
+    results[21].br_Name = (STRPTR)"sample_resample";
+    results[22].br_Name = (STRPTR)"sample_dither";
+    results[23].br_Name = (STRPTR)"sound_rate";
+    results[24].br_Name = (STRPTR)"convert_auto";
+    results[25].br_Name = (STRPTR)"dtwrite_buffered";
+    results[26].br_Name = (STRPTR)"dtwrite_save";
+    results[27].br_Name = (STRPTR)"estimate";
+    results[28].br_Name = (STRPTR)"identify_fast";
+    results[29].br_Name = (STRPTR)"unknown_full";
+    results[30].br_Name = (STRPTR)"unknown_remembered";
+    results[31].br_Name = (STRPTR)"watch_index";
+    results[32].br_Name = (STRPTR)"watch_reopen";
+    results[33].br_Name = (STRPTR)"catalog_write";
+    results[34].br_Name = (STRPTR)"catalog_find";
+    results[35].br_Name = (STRPTR)"watch_own_files";
+
+    record = (struct DTRecord *)OSAllocMem(sizeof(struct DTRecord));
+    if (!record) {
+        return;
+    }
+
+    /* Report output goes to NIL: so console speed is not measured */
+    nilOut = Open("NIL:", MODE_NEWFILE);
+    if (nilOut) {
+        oldOut = SelectOutput(nilOut);
+    }
+
+    /* Identification rate: Lock + ObtainDataTypeA per file */
+    ReadTimer(&start);
+    for (iter = 0; iter < iterations; iter++) {
+        for (i = 0; i < fileCount; i++) {
+            BPTR lock;
+            struct DataType *dtn;
+
+            if (files[i].cf_Format == FMT_DTYP) {
+                continue;
+            }
+            lock = Lock(files[i].cf_Path, ACCESS_READ);
+            if (lock) {
+                dtn = ObtainDataTypeA(DTST_FILE, (APTR)lock, NULL);
+                if (dtn) {
+                    ReleaseDataType(dtn);
+                }
+                UnLock(lock);
+                results[0].br_Count++;
+            }
+        }
+    }
+    results[0].br_Micros = ElapsedMicros(&start);
+
+    /* Identification the way a query does it: one read, then DTST_MEMORY */
+    ReadTimer(&start);
+    for (iter = 0; iter < iterations; iter++) {
+        for (i = 0; i < fileCount; i++) {
+            struct FileQuery fq;
+
+            if (files[i].cf_Format == FMT_DTYP) {
+                continue;
+            }
+            if (OpenFileQuery(ctx, &fq, files[i].cf_Path)) {
+                ObtainFileDataType(&fq);
+                CloseFileQuery(&fq);
+                results[6].br_Count++;
+            }
+        }
+    }
+    results[6].br_Micros = ElapsedMicros(&start);
+
+    /* The same with FAST: the extension's descriptor, checked by mask */
+    ctx->dc_Fast = TRUE;
+    ReadTimer(&start);
+    for (iter = 0; iter < iterations; iter++) {
+        for (i = 0; i < fileCount; i++) {
+            struct FileQuery fq;
+
+            if (files[i].cf_Format == FMT_DTYP) {
+                continue;
+            }
+            if (OpenFileQuery(ctx, &fq, files[i].cf_Path)) {
+                ObtainFileDataType(&fq);
+                CloseFileQuery(&fq);
+                results[28].br_Count++;
+            }
+        }
+    }
+    results[28].br_Micros = ElapsedMicros(&start);
+    ctx->dc_Fast = FALSE;
+
+    /* Whether FAST gave the type the full match gives */
+    for (i = 0; i < fileCount; i++) {
+        struct FileQuery fq;
+        struct DataType *fast = NULL;
+        UWORD by = IDBY_NONE;
+        BOOL borrowed = FALSE;
+
+        if (files[i].cf_Format == FMT_DTYP) {
+            continue;
+        }
+        ctx->dc_Fast = TRUE;
+        if (OpenFileQuery(ctx, &fq, files[i].cf_Path)) {
+            if (ObtainFileDataType(&fq)) {
+                fast = fq.fq_DataType;
+                by = fq.fq_IdentifiedBy;
+                borrowed = fq.fq_Borrowed;
+                fq.fq_DataType = NULL;
+            }
+            CloseFileQuery(&fq);
+        }
+        ctx->dc_Fast = FALSE;
+        if (!fast) {
+            continue;
+        }
+
+        fastFiles++;
+        if (by == IDBY_EXTENSION) {
+            fastByExtension++;
+        }
+        if (OpenFileQuery(ctx, &fq, files[i].cf_Path)) {
+            if (ObtainFileDataType(&fq) && fq.fq_DataType->dtn_Header->dth_BaseName &&
+                fast->dtn_Header->dth_BaseName &&
+                Stricmp(fq.fq_DataType->dtn_Header->dth_BaseName, fast->dtn_Header->dth_BaseName) == 0) {
+                fastAgreed++;
+            } else {
+                Printf("fast_identify: %s identified differently with FAST\n", files[i].cf_Path);
+                checksFailed++;
+            }
+            CloseFileQuery(&fq);
+        }
+        if (!borrowed) {
+            ReleaseDataType(fast);
+        }
+    }
+
+    /* Descriptor lookups in DEVS:Datatypes */
+    ReadTimer(&start);
+    for (iter = 0; iter < iterations; iter++) {
+        for (i = 0; lookupNames[i]; i++) {
+            OSFreeMem(FindDTYPFilePath(lookupNames[i]));
+            results[1].br_Count++;
+        }
+    }
+    results[1].br_Micros = ElapsedMicros(&start);
+
+    /* DTTL parse rate over the generated descriptors */
+    ReadTimer(&start);
+    for (iter = 0; iter < iterations; iter++) {
+        for (i = 0; i < fileCount; i++) {
+            struct Tool tool;
+
+            if (files[i].cf_Format != FMT_DTYP) {
+                continue;
+            }
+            tool.tn_Program = NULL;
+            if (ParseToolFromDTYP(files[i].cf_Path, TW_MAIL, &tool)) {
+                OSFreeMem(tool.tn_Program);
+            }
+            results[2].br_Count++;
+        }
+    }
+    results[2].br_Micros = ElapsedMicros(&start);
+
+    /* Header-metadata extraction: object creation plus attribute queries */
+    ReadTimer(&start);
+    for (iter = 0; iter < iterations; iter++) {
+        for (i = 0; i < fileCount; i++) {
+            BPTR lock;
+            struct DataType *dtn;
+
+            if (files[i].cf_Format == FMT_DTYP) {
+                continue;
+            }
+            lock = Lock(files[i].cf_Path, ACCESS_READ);
+            if (lock) {
+                dtn = ObtainDataTypeA(DTST_FILE, (APTR)lock, NULL);
+                if (dtn) {
+                    Object *dtObject = NewDTObject((APTR)files[i].cf_Path, TAG_DONE);
+                    if (dtObject) {
+                        GetDatatypeMetadata(dtObject, dtn->dtn_Header->dth_GroupID, record);
+                        DisposeDTObject(dtObject);
+                    }
+                    ReleaseDataType(dtn);
+                }
+                UnLock(lock);
+                results[3].br_Count++;
+            }
+        }
+    }
+    results[3].br_Micros = ElapsedMicros(&start);
+
+    /* Full report formatting as printed by a plain query */
+    ReadTimer(&start);
+    for (iter = 0; iter < iterations; iter++) {
+        for (i = 0; i < fileCount; i++) {
+            struct FileQuery fq;
+            struct DataType *dtn;
+
+            if (files[i].cf_Format == FMT_DTYP) {
+                continue;
+            }
+            if (OpenFileQuery(ctx, &fq, files[i].cf_Path)) {
+                dtn = ObtainFileDataType(&fq);
+                if (dtn) {
+                    FillRecord(ctx, &fq, record);
+                    PrintDataTypeInfo(record, files[i].cf_Path);
+                    PrintTools(record);
+                }
+                CloseFileQuery(&fq);
+                results[4].br_Count++;
+            }
+        }
+    }
+    results[4].br_Micros = ElapsedMicros(&start);
+
+    /* The same report with FIELDS=group,basename: identification only */
+    ctx->dc_Fields = RECF_GROUP | RECF_BASENAME;
+    ReadTimer(&start);
+    for (iter = 0; iter < iterations; iter++) {
+        for (i = 0; i < fileCount; i++) {
+            struct FileQuery fq;
+
+            if (files[i].cf_Format == FMT_DTYP) {
+                continue;
+            }
+            if (OpenFileQuery(ctx, &fq, files[i].cf_Path)) {
+                if (ObtainFileDataType(&fq)) {
+                    FillRecord(ctx, &fq, record);
+                    PrintDataTypeInfo(record, files[i].cf_Path);
+                }
+                CloseFileQuery(&fq);
+                results[9].br_Count++;
+            }
+        }
+    }
+    results[9].br_Micros = ElapsedMicros(&start);
+    ctx->dc_Fields = RECF_ALL;
+
+    /* The corpus as one batch, in the order it was listed and in disk order */
+    {
+        STRPTR *names = (STRPTR *)OSAllocMem(sizeof(STRPTR) * (fileCount + 1));
+        ULONG nameCount = 0;
+
+        if (names) {
+            for (i = 0; i < fileCount; i++) {
+                if (files[i].cf_Format != FMT_DTYP) {
+                    names[nameCount++] = (STRPTR)files[i].cf_Path;
+                }
+            }
+
+            ReadTimer(&start);
+            for (iter = 0; iter < iterations; iter++) {
+                RunBatch(ctx, names, nameCount, ORDER_ARGS, BenchBatchFile, record);
+                results[13].br_Count += nameCount;
+            }
+            results[13].br_Micros = ElapsedMicros(&start);
+
+            ReadTimer(&start);
+            for (iter = 0; iter < iterations; iter++) {
+                RunBatch(ctx, names, nameCount, ORDER_DISK, BenchBatchFile, record);
+                results[14].br_Count += nameCount;
+            }
+            results[14].br_Micros = ElapsedMicros(&start);
+
+            OSFreeMem(names);
+        }
+    }
+
+    /* Whole queries answered by a running SERVER (skipped if none runs) */
+    if (FindPort((STRPTR)SERVER_PORT_NAME)) {
+        ReadTimer(&start);
+        for (iter = 0; iter < iterations; iter++) {
+            for (i = 0; i < fileCount; i++) {
+                UBYTE line[300];
+                LONG queryResult;
+
+                if (files[i].cf_Format == FMT_DTYP) {
+                    continue;
+                }
+                SNPrintf(line, sizeof(line), "\"%s\"\n", files[i].cf_Path);
+                if (SendToServer((STRPTR)line, Input(), Output(), &queryResult)) {
+                    results[7].br_Count++;
+                }
+            }
+        }
+        results[7].br_Micros = ElapsedMicros(&start);
+    }
+
+    /* The same queries, each in a freshly loaded DataType process */
+    ReadTimer(&start);
+    for (iter = 0; iter < iterations; iter++) {
+        for (i = 0; i < fileCount; i++) {
+            UBYTE command[300];
+            struct TagItem tags[2];
+
+            if (files[i].cf_Format == FMT_DTYP) {
+                continue;
+            }
+            SNPrintf(command, sizeof(command), "DataType \"%s\"", files[i].cf_Path);
+            tags[0].ti_Tag = SYS_Output;
+            tags[0].ti_Data = (ULONG)Output();
+            tags[1].ti_Tag = TAG_DONE;
+            if (SystemTagsA((STRPTR)command, tags) != -1) {
+                results[8].br_Count++;
+            }
+        }
+    }
+    results[8].br_Micros = ElapsedMicros(&start);
+
+    if (nilOut) {
+        SelectOutput(oldOut);
+        Close(nilOut);
+    }
+
+    /* Chunk walks over damaged copies of the descriptors; sizes and IDs */
+    /* are overwritten at random to exercise the bounds checks */
+    ReadTimer(&start);
+    for (i = 0; i < fileCount; i++) {
+        UBYTE *original;
+        UBYTE *scratch;
+        ULONG size;
+        ULONG m;
+
+        if (files[i].cf_Format != FMT_DTYP) {
+            continue;
+        }
+        original = OSLoadFile(files[i].cf_Path, DTYP_MAX_SIZE, &size);
+        scratch = original ? (UBYTE *)OSAllocMem(size) : NULL;
+        if (scratch) {
+            for (iter = 0; iter < iterations * MUTATIONS; iter++) {
+                struct IFFView view;
+                struct IFFChunk chunk;
+
+                CopyMem(original, scratch, size);
+                for (m = 0; m < 4; m++) {
+                    scratch[NextRandom() % size] = (UBYTE)NextRandom();
+                }
+                /* Truncate now and then as well */
+                if (InitIFFView(&view, scratch, (iter & 7) ? size : NextRandom() % size)) {
+                    while (NextIFFChunk(&view, &chunk)) {
+                        if (chunk.ic_Data < scratch || chunk.ic_Data + chunk.ic_Size > scratch + size) {
+                            Printf("dttl_mutate: chunk outside buffer in %s\n", files[i].cf_Path);
+                            checksFailed++;
+                            break;
+                        }
+                    }
+                }
+                results[5].br_Count++;
+            }
+        }
+        OSFreeMem(scratch);
+        OSFreeMem(original);
+    }
+    results[5].br_Micros = ElapsedMicros(&start);
+
+    /* Each field on its own must fill in only itself and run no phase */
+    /* beyond the ones FieldMap gives for it */
+    ReadTimer(&start);
+    for (f = 0; FieldMap[f].fd_Name; f++) {
+        ULONG allowed = FieldPhases(FieldMap[f].fd_Field);
+
+        ctx->dc_Fields = FieldMap[f].fd_Field;
+        for (i = 0; i < fileCount; i++) {
+            struct FileQuery fq;
+            struct QueryStats qs;
+            UWORD phase;
+
+            if (files[i].cf_Format == FMT_DTYP) {
+                continue;
+            }
+            if (!OpenFileQuery(ctx, &fq, files[i].cf_Path)) {
+                continue;
+            }
+            if (ObtainFileDataType(&fq)) {
+                memset(&qs, 0, sizeof(qs));
+                CurrentStats = &qs;
+                FillRecord(ctx, &fq, record);
+                CurrentStats = NULL;
+
+                if (record->dr_Valid & ~FieldMap[f].fd_Field) {
+                    Printf("fields_check: %s filled in other fields for %s\n", FieldMap[f].fd_Name, files[i].cf_Path);
+                    checksFailed++;
+                }
+                for (phase = 0; phase < PHASE_COUNT; phase++) {
+                    if (qs.qs_PhaseCalls[phase] && !(allowed & PHASEF(phase))) {
+                        Printf("fields_check: %s ran phase %s for %s\n",
+                               FieldMap[f].fd_Name, GetPhaseName(phase), files[i].cf_Path);
+                        checksFailed++;
+                    }
+                }
+                results[10].br_Count++;
+            }
+            CloseFileQuery(&fq);
+        }
+    }
+    results[10].br_Micros = ElapsedMicros(&start);
+    ctx->dc_Fields = RECF_ALL;
+
+    /* Tree walk with ExAll(), icons left out by the filesystem */
+    ReadTimer(&start);
+    for (iter = 0; iter < iterations; iter++) {
+        struct OSWalk *walk;
+        struct OSWalkEntry entry;
+
+        walk = OSOpenWalk(walkRoot, OSDIRF_NOINFO, NULL);
+        if (walk) {
+            while (OSNextWalkEntry(walk, &entry)) {
+                results[11].br_Count++;
+            }
+            OSCloseWalk(walk);
+        }
+    }
+    results[11].br_Micros = ElapsedMicros(&start);
+
+    /* The same tree with recursive Examine()/ExNext(), for comparison */
+    ReadTimer(&start);
+    for (iter = 0; iter < iterations; iter++) {
+        struct FileInfoBlock *fib;
+        BPTR lock;
+
+        fib = (struct FileInfoBlock *)AllocDosObject(DOS_FIB, NULL);
+        lock = Lock(walkRoot, ACCESS_READ);
+        if (fib && lock) {
+            results[12].br_Count += WalkExNext(lock, fib, 0);
+        }
+        if (lock) {
+            UnLock(lock);
+        }
+        if (fib) {
+            FreeDosObject(DOS_FIB, fib);
+        }
+    }
+    results[12].br_Micros = ElapsedMicros(&start);
+
+    /* ByteRun1 packing, word-at-a-time against a byte-at-a-time reference */
+    BenchPacking(iterations, &results[15], &results[16]);
+
+    /* Native ILBM writes, each read back and compared plane by plane */
+    ReadTimer(&start);
+    for (iter = 0; iter < iterations; iter++) {
+        for (i = 0; i < fileCount; i++) {
+            struct FileQuery fq;
+
+            if (files[i].cf_Format != FMT_ILBM) {
+                continue;
+            }
+            if (OpenFileQuery(ctx, &fq, files[i].cf_Path)) {
+                if (ObtainFileDataType(&fq) && CheckILBMRoundTrip(&fq)) {
+                    results[17].br_Count++;
+                }
+                CloseFileQuery(&fq);
+            }
+        }
+    }
+    results[17].br_Micros = ElapsedMicros(&start);
+    OSDelete((STRPTR)ILBM_SCRATCH);
+
+    /* Streamed 8SVX writes, plain and Fibonacci-delta; counts are samples */
+    for (f = 0; f < 2; f++) {
+        ReadTimer(&start);
+        for (iter = 0; iter < iterations; iter++) {
+            for (i = 0; i < fileCount; i++) {
+                struct FileQuery fq;
+
+                if (files[i].cf_Format != FMT_8SVX) {
+                    continue;
+                }
+                if (OpenFileQuery(ctx, &fq, files[i].cf_Path)) {
+                    if (ObtainFileDataType(&fq) && CheckSVXRoundTrip(&fq, (BOOL)f)) {
+                        ULONG length = 0;
+
+                        GetDTAttrs(fq.fq_Object, SDTA_SampleLength, (ULONG)&length, TAG_DONE);
+                        results[18 + f].br_Count += length;
+                    }
+                    CloseFileQuery(&fq);
+                }
+            }
+        }
+        results[18 + f].br_Micros = ElapsedMicros(&start);
+    }
+    OSDelete((STRPTR)SVX_SCRATCH);
+
+    /* Animations written frame by frame; counts are frames */
+    ReadTimer(&start);
+    for (iter = 0; iter < iterations; iter++) {
+        for (i = 0; i < fileCount; i++) {
+            struct FileQuery fq;
+            struct ExplodeResult er;
+            UBYTE name[64];
+            ULONG frame;
+
+            if (files[i].cf_Format != FMT_ANIM) {
+                continue;
+            }
+            if (OpenFileQuery(ctx, &fq, files[i].cf_Path)) {
+                if (ObtainFileDataType(&fq)) {
+                    if (!ExplodeAnimation(&fq, (STRPTR)FRAME_SCRATCH, TRUE, &er)) {
+                        Printf("anim_explode: %s stopped after %lu frames\n", files[i].cf_Path, er.er_Frames);
+                        checksFailed++;
+                    }
+                    results[20].br_Count += er.er_Frames;
+                    for (frame = 1; frame <= er.er_Frames; frame++) {
+                        SNPrintf(name, sizeof(name), "%s.%04lu", (STRPTR)FRAME_SCRATCH, frame);
+                        OSDelete((STRPTR)name);
+                    }
+                }
+                CloseFileQuery(&fq);
+            }
+        }
+    }
+    results[20].br_Micros = ElapsedMicros(&start);
+
+    /* Rate and depth conversion kernels, checked first, then timed */
+    CheckSampleAccuracy();
+    BenchSampleConversion(iterations, &results[21], &results[22]);
+
+    /* Sounds written at twice their rate with WriteSoundIFF(); counts */
+    /* are samples written */
+    ReadTimer(&start);
+    for (iter = 0; iter < iterations; iter++) {
+        for (i = 0; i < fileCount; i++) {
+            struct FileQuery fq;
+            ULONG written;
+
+            if (files[i].cf_Format != FMT_8SVX) {
+                continue;
+            }
+            if (OpenFileQuery(ctx, &fq, files[i].cf_Path)) {
+                if (ObtainFileDataType(&fq) && CheckSoundResample(&fq, &written)) {
+                    results[23].br_Count += written;
+                }
+                CloseFileQuery(&fq);
+            }
+        }
+    }
+    results[23].br_Micros = ElapsedMicros(&start);
+    OSDelete((STRPTR)RATE_SCRATCH);
+
+    /* CONVERT AUTO on pictures and sounds, its size table sent to NIL: */
+    nilOut = Open("NIL:", MODE_NEWFILE);
+    if (nilOut) {
+        oldOut = SelectOutput(nilOut);
+    }
+    ReadTimer(&start);
+    for (iter = 0; iter < iterations; iter++) {
+        for (i = 0; i < fileCount; i++) {
+            struct FileQuery fq;
+            struct OSFileInfo info;
+
+            if (files[i].cf_Format != FMT_ILBM && files[i].cf_Format != FMT_8SVX) {
+                continue;
+            }
+            if (OpenFileQuery(ctx, &fq, files[i].cf_Path)) {
+                if (ObtainFileDataType(&fq) && ConvertAuto(&fq, (STRPTR)AUTO_SCRATCH, TRUE) &&
+                    OSExamine((STRPTR)AUTO_SCRATCH, &info)) {
+                    results[24].br_Count++;
+                }
+                CloseFileQuery(&fq);
+            }
+        }
+    }
+    results[24].br_Micros = ElapsedMicros(&start);
+    if (nilOut) {
+        SelectOutput(oldOut);
+        Close(nilOut);
+    }
+    OSDelete((STRPTR)AUTO_SCRATCH);
+
+    /* FORMAT= with every format of the group; each output must be */
+    /* identified as the format asked for, or not be written at all */
+    for (i = 0; i < fileCount; i++) {
+        if (files[i].cf_Format == FMT_ILBM || files[i].cf_Format == FMT_8SVX) {
+            CheckFormatWrites(ctx, (STRPTR)files[i].cf_Path);
+        }
+    }
+    OSDelete((STRPTR)FORMAT_SCRATCH);
+
+    /* DTM_WRITE through WriteDTObject() against SaveDTObjectA(), both to */
+    /* WRITETO; counts are bytes written */
+    {
+        UBYTE name[256];
+
+        Strncpy(name, writeDir, sizeof(name));
+        AddPart(name, (STRPTR)WRITE_SCRATCH, sizeof(name));
+
+        for (f = 0; f < 2; f++) {
+            ReadTimer(&start);
+            for (iter = 0; iter < iterations; iter++) {
+                for (i = 0; i < fileCount; i++) {
+                    struct FileQuery fq;
+                    struct OSFileInfo info;
+                    Object *dtObject;
+                    BOOL ok;
+
+                    if (files[i].cf_Format != FMT_ILBM) {
+                        continue;
+                    }
+                    if (!OpenFileQuery(ctx, &fq, files[i].cf_Path)) {
+                        continue;
+                    }
+                    if (ObtainFileDataType(&fq) && (dtObject = GetFileObject(&fq)) != NULL) {
+                        if (f == 0) {
+                            ok = WriteDTObject(dtObject, (STRPTR)name, DTWM_IFF);
+                        } else {
+                            ok = (BOOL)(SaveDTObjectA(dtObject, NULL, NULL, (STRPTR)name, DTWM_IFF, FALSE, TAG_DONE) != 0);
+                        }
+                        if (ok && OSExamine((STRPTR)name, &info)) {
+                            results[25 + f].br_Count += info.ofi_Size;
+                        }
+                        if (f == 0 && iter == 0) {
+                            CheckFailedWrite(dtObject, (STRPTR)name);
+                        }
+                    }
+                    CloseFileQuery(&fq);
+                }
+            }
+            results[25 + f].br_Micros = ElapsedMicros(&start);
+        }
+        OSDelete((STRPTR)name);
+    }
+
+    /* A file of random bytes identified in full each time, then answered */
+    /* from the remembered unknown files; counts are files found unknown */
+    {
+        BPTR fh = Open((STRPTR)UNKNOWN_SCRATCH, MODE_NEWFILE);
+        BOOL written = FALSE;
+
+        if (fh) {
+            written = PutRandomBytes(fh, 4096, FALSE);
+            Close(fh);
+        }
+
+        for (f = 0; written && f < 2; f++) {
+            ReadTimer(&start);
+            for (iter = 0; iter < iterations * UNKNOWN_QUERIES; iter++) {
+                struct FileQuery fq;
+
+                /* Nothing remembered, and nothing loaded from ENVARC: */
+                if (f == 0) {
+                    FreeUnknownFiles(ctx);
+                    ctx->dc_UnknownLoaded = TRUE;
+                }
+                if (OpenFileQuery(ctx, &fq, (STRPTR)UNKNOWN_SCRATCH)) {
+                    if (!ObtainFileDataType(&fq)) {
+                        results[29 + f].br_Count++;
+                    }
+                    CloseFileQuery(&fq);
+                }
+            }
+            results[29 + f].br_Micros = ElapsedMicros(&start);
+        }
+
+        /* The scratch file is not to be remembered past the run */
+        FreeUnknownFiles(ctx);
+        ctx->dc_UnknownDirty = FALSE;
+        OSDelete((STRPTR)UNKNOWN_SCRATCH);
+    }
+
+    /* A WATCH index of the walk tree built from nothing, then opened and */
+    /* brought up to date with the tree unchanged, which should identify */
+    /* nothing; counts are files looked at */
+    {
+        struct WatchIndex *wi;
+        ULONG fields = ctx->dc_Fields;
+
+        /* The index, not the decoding, is what is measured */
+        ctx->dc_Fields = RECF_GROUP | RECF_BASENAME;
+        OSDelete((STRPTR)WATCH_SCRATCH);
+
+        ReadTimer(&start);
+        wi = OpenWatchIndex(ctx, (STRPTR)WATCH_SCRATCH, FALSE);
+        if (wi) {
+            WatchTree(wi, walkRoot);
+            results[31].br_Count = wi->wi_Checked;
+            watchFiles = wi->wi_Count;
+            watchIdentified = wi->wi_Identified;
+            CloseWatchIndex(wi);
+        }
+        results[31].br_Micros = ElapsedMicros(&start);
+
+        ReadTimer(&start);
+        for (iter = 0; iter < iterations; iter++) {
+            wi = OpenWatchIndex(ctx, (STRPTR)WATCH_SCRATCH, FALSE);
+            if (wi) {
+                WatchTree(wi, walkRoot);
+                results[32].br_Count += wi->wi_Checked;
+                watchAgain += wi->wi_Identified;
+                CloseWatchIndex(wi);
+            }
+        }
+        results[32].br_Micros = ElapsedMicros(&start);
+        OSDelete((STRPTR)WATCH_SCRATCH);
+
+        /* The index and a catalogue inside the tree, watched: rewriting */
+        /* them notifies the tree, which must not count as a change, or */
+        /* WATCH would rewrite them for ever; counts are updates */
+        {
+            UBYTE ownIndex[WALK_PATH_SIZE];
+            UBYTE ownCatalog[WALK_PATH_SIZE];
+
+            Strncpy(ownIndex, walkRoot, sizeof(ownIndex));
+            Strncpy(ownCatalog, walkRoot, sizeof(ownCatalog));
+            if (AddPart(ownIndex, (STRPTR)WATCH_OWN_INDEX, sizeof(ownIndex)) &&
+                AddPart(ownCatalog, (STRPTR)WATCH_OWN_CATALOG, sizeof(ownCatalog))) {
+                OSDelete((STRPTR)ownIndex);
+                ReadTimer(&start);
+                wi = OpenWatchIndex(ctx, (STRPTR)ownIndex, TRUE);
+                if (wi) {
+                    IgnoreWatchFile(wi, (STRPTR)ownCatalog);
+                    WatchTree(wi, walkRoot);
+                    for (iter = 0; iter < iterations; iter++) {
+                        wi->wi_Compact = TRUE;
+                        FlushWatchIndex(wi);
+                        WriteCatalog((STRPTR)ownCatalog, wi->wi_Entries, wi->wi_Count);
+                        watchOwn += UpdateWatchIndex(wi);
+                        results[35].br_Count++;
+                    }
+                    if (watchOwn) {
+                        Printf("watch_own: rewriting %s and %s counted as %lu changes\n",
+                               ownIndex, ownCatalog, watchOwn);
+                        checksFailed++;
+                    }
+                    CloseWatchIndex(wi);
+                }
+                results[35].br_Micros = ElapsedMicros(&start);
+                OSDelete((STRPTR)ownIndex);
+                OSDelete((STRPTR)ownCatalog);
+            }
+        }
+
+        ctx->dc_Fields = fields;
+    }
+
+    /* A catalogue of RECORDS= synthetic files, written and searched */
+    BenchCatalog(iterations, &results[33], &results[34]);
+
+    /* Decode estimates from headers and sizes, timed, then checked */
+    /* against what the decodes took */
+    ReadTimer(&start);
+    for (iter = 0; iter < iterations; iter++) {
+        for (i = 0; i < fileCount; i++) {
+            struct FileQuery fq;
+            struct FootprintEstimate fe;
+
+            if (files[i].cf_Format == FMT_DTYP) {
+                continue;
+            }
+            if (OpenFileQuery(ctx, &fq, files[i].cf_Path)) {
+                if (ObtainFileDataType(&fq) && EstimateFootprint(&fq, &fe)) {
+                    results[27].br_Count++;
+                }
+                CloseFileQuery(&fq);
+            }
+        }
+    }
+    results[27].br_Micros = ElapsedMicros(&start);
+    for (i = 0; i < fileCount; i++) {
+        if (files[i].cf_Format != FMT_DTYP) {
+            CheckFootprint(ctx, (STRPTR)files[i].cf_Path);
+        }
+    }
+    CheckAnimEstimate(ctx);
+
+    OSFreeMem(record);
+}
+
+/* Plain ByteRun1 packer that looks at one byte at a time, for comparison */
+ULONG PackReference(UBYTE *src, ULONG size, UBYTE *dst)
+{
+    UBYTE *out = dst;
+    ULONG literal = 0;
+    ULONG i = 0;
+    ULONG run;
+
+    while (i < size) {
+        for (run = 1; i + run < size && run < 128 && src[i + run] == src[i]; run++) {
+        }
+        if (run >= 3) {
+            while (literal < i) {
+                ULONG n = (i - literal > 128) ? 128 : i - literal;
+                *out++ = (UBYTE)(n - 1);
+                CopyMem(src + literal, out, n);
+                out += n;
+                literal += n;
+            }
+            *out++ = (UBYTE)(257 - run);
+            *out++ = src[i];
+            i += run;
+            literal = i;
+        } else {
+            i++;
+        }
+    }
+    while (literal < size) {
+        ULONG n = (size - literal > 128) ? 128 : size - literal;
+        *out++ = (UBYTE)(n - 1);
+        CopyMem(src + literal, out, n);
+        out += n;
+        literal += n;
+    }
+
+    return (ULONG)(out - dst);
+}
+
+/* Pack picture-like rows with both packers; every row must unpack to itself */
+VOID BenchPacking(ULONG iterations, struct BenchResult *word, struct BenchResult *reference)
+{
+    struct EClockVal start;
+    UBYTE *rows;
+    UBYTE *packed;
+    UBYTE *unpacked;
+    ULONG iter;
+    ULONG pos;
+    ULONG i;
+
+    rows = (UBYTE *)OSAllocMem(PACK_BUFFER_SIZE);
+    packed = (UBYTE *)OSAllocMem(PACKED_SIZE(PACK_ROW_BYTES));
+    unpacked = (UBYTE *)OSAllocMem(PACK_ROW_BYTES);
+    if (!rows || !packed || !unpacked) {
+        OSFreeMem(unpacked);
+        OSFreeMem(packed);
+        OSFreeMem(rows);
+        return;
+    }
+
+    /* Flat areas broken up by short stretches of detail */
+    for (pos = 0; pos < PACK_BUFFER_SIZE; ) {
+        ULONG length = 1 + NextRandom() % 48;
+        UBYTE value = (UBYTE)NextRandom();
+        BOOL flat = (BOOL)(NextRandom() % 3 != 0);
+
+        for (i = 0; i < length && pos < PACK_BUFFER_SIZE; i++) {
+            rows[pos++] = flat ? value : (UBYTE)NextRandom();
+        }
+    }
+
+    /* Round trip once, outside the timing */
+    for (pos = 0; pos + PACK_ROW_BYTES <= PACK_BUFFER_SIZE; pos += PACK_ROW_BYTES) {
+        UBYTE *in;
+        ULONG size;
+
+        size = PackByteRun1(rows + pos, PACK_ROW_BYTES, packed);
+        in = packed;
+        if (!UnpackByteRun1(&in, packed + size, unpacked, PACK_ROW_BYTES) ||
+            in != packed + size || memcmp(unpacked, rows + pos, PACK_ROW_BYTES) != 0) {
+            Printf("ilbm_pack: row at %lu does not round trip\n", pos);
+            checksFailed++;
+        }
+
+        size = PackReference(rows + pos, PACK_ROW_BYTES, packed);
+        in = packed;
+        if (!UnpackByteRun1(&in, packed + size, unpacked, PACK_ROW_BYTES) ||
+            memcmp(unpacked, rows + pos, PACK_ROW_BYTES) != 0) {
+            Printf("ilbm_pack_ref: row at %lu does not round trip\n", pos);
+            checksFailed++;
+        }
+    }
+
+    /* Counts are bytes packed */
+    ReadTimer(&start);
+    for (iter = 0; iter < iterations; iter++) {
+        for (pos = 0; pos + PACK_ROW_BYTES <= PACK_BUFFER_SIZE; pos += PACK_ROW_BYTES) {
+            PackByteRun1(rows + pos, PACK_ROW_BYTES, packed);
+            word->br_Count += PACK_ROW_BYTES;
+        }
+    }
+    word->br_Micros = ElapsedMicros(&start);
+
+    ReadTimer(&start);
+    for (iter = 0; iter < iterations; iter++) {
+        for (pos = 0; pos + PACK_ROW_BYTES <= PACK_BUFFER_SIZE; pos += PACK_ROW_BYTES) {
+            PackReference(rows + pos, PACK_ROW_BYTES, packed);
+            reference->br_Count += PACK_ROW_BYTES;
+        }
+    }
+    reference->br_Micros = ElapsedMicros(&start);
+
+    OSFreeMem(unpacked);
+    OSFreeMem(packed);
+    OSFreeMem(rows);
+}
+
+/* Write a picture with WritePictureILBM() and compare what reads back */
+BOOL CheckILBMRoundTrip(struct FileQuery *fq)
+{
+    struct BitMapHeader *bmh = NULL;
+    struct BitMapHeader *copyBmh = NULL;
+    struct BitMap *bm = NULL;
+    struct BitMap *copyBm = NULL;
+    Object *dtObject;
+    Object *copy;
+    ULONG rowBytes;
+    ULONG y;
+    UWORD plane;
+    BOOL same = FALSE;
+
+    dtObject = GetFileObject(fq);
+    if (!dtObject || !WritePictureILBM(dtObject, (STRPTR)ILBM_SCRATCH)) {
+        Printf("ilbm_write: %s could not be written\n", fq->fq_Name);
+        checksFailed++;
+        return FALSE;
+    }
+
+    copy = NewDTObject((APTR)ILBM_SCRATCH, DTA_GroupID, GID_PICTURE, TAG_DONE);
+    if (!copy) {
+        Printf("ilbm_write: copy of %s does not load\n", fq->fq_Name);
+        checksFailed++;
+        return FALSE;
+    }
+
+    GetDTAttrs(dtObject, PDTA_BitMapHeader, (ULONG)&bmh, PDTA_BitMap, (ULONG)&bm, TAG_DONE);
+    GetDTAttrs(copy, PDTA_BitMapHeader, (ULONG)&copyBmh, PDTA_BitMap, (ULONG)&copyBm, TAG_DONE);
+
+    if (bmh && bm && copyBmh && copyBm &&
+        bmh->bmh_Width == copyBmh->bmh_Width && bmh->bmh_Height == copyBmh->bmh_Height &&
+        bmh->bmh_Depth == copyBmh->bmh_Depth) {
+        rowBytes = ((bmh->bmh_Width + 15) >> 4) << 1;
+        same = TRUE;
+        for (y = 0; same && y < bmh->bmh_Height; y++) {
+            for (plane = 0; same && plane < bmh->bmh_Depth; plane++) {
+                if (memcmp((UBYTE *)bm->Planes[plane] + y * bm->BytesPerRow,
+                           (UBYTE *)copyBm->Planes[plane] + y * copyBm->BytesPerRow, rowBytes) != 0) {
+                    same = FALSE;
+                }
+            }
+        }
+    }
+
+    if (!same) {
+        Printf("ilbm_write: copy of %s differs\n", fq->fq_Name);
+        checksFailed++;
+    }
+
+    DisposeDTObject(copy);
+
+    return same;
+}
+
+/* Batch handler: the plain report for one file */
+LONG BenchBatchFile(struct DTContext *ctx, STRPTR fileName, APTR userData)
+{
+    struct DTRecord *record = (struct DTRecord *)userData;
+    struct FileQuery fq;
+
+    if (!OpenFileQuery(ctx, &fq, fileName)) {
+        return RETURN_FAIL;
+    }
+    if (ObtainFileDataType(&fq)) {
+        FillRecord(ctx, &fq, record);
+        PrintDataTypeInfo(record, fileName);
+    }
+    CloseFileQuery(&fq);
+
+    return RETURN_OK;
+}
+
+/* Count the entries below a directory the old way, one packet per entry */
+/* Each level needs its own FIB, as ExNext() keeps its place in it */
+ULONG WalkExNext(BPTR lock, struct FileInfoBlock *fib, ULONG depth)
+{
+    ULONG count = 0;
+    LONG nameLen;
+    BPTR oldDir;
+    BPTR subLock;
+
+    if (!Examine(lock, fib)) {
+        return 0;
+    }
+
+    while (ExNext(lock, fib)) {
+        nameLen = strlen(fib->fib_FileName);
+        if (nameLen > 5 && Stricmp(fib->fib_FileName + nameLen - 5, ".info") == 0) {
+            continue;
+        }
+        count++;
+
+        if (fib->fib_DirEntryType == ST_USERDIR && depth + 1 < WALK_MAX_DEPTH) {
+            oldDir = CurrentDir(lock);
+            subLock = Lock(fib->fib_FileName, ACCESS_READ);
+            CurrentDir(oldDir);
+            if (subLock) {
+                struct FileInfoBlock *subFib = (struct FileInfoBlock *)AllocDosObject(DOS_FIB, NULL);
+                if (subFib) {
+                    count += WalkExNext(subLock, subFib, depth + 1);
+                    FreeDosObject(DOS_FIB, subFib);
+                }
+                UnLock(subLock);
+            }
+        }
+    }
+
+    return count;
+}
+
+/* Stream a sound through an SVXWriter, noting the memory it holds, and */
+/* check what reads back: the same samples, or the same length if delta-coded */
+BOOL CheckSVXRoundTrip(struct FileQuery *fq, BOOL compress)
+{
+    struct SVXWriter sw;
+    Object *dtObject;
+    Object *copy;
+    BYTE *sample = NULL;
+    BYTE *copySample = NULL;
+    ULONG length = 0;
+    ULONG copyLength = 0;
+    ULONG samplesPerSec = 0;
+    ULONG before;
+    ULONG held;
+    ULONG done;
+    ULONG part;
+    BOOL same;
+
+    dtObject = GetFileObject(fq);
+    if (!dtObject) {
+        return FALSE;
+    }
+    GetDTAttrs(dtObject, SDTA_Sample, (ULONG)&sample, SDTA_SampleLength, (ULONG)&length,
+               SDTA_SamplesPerSec, (ULONG)&samplesPerSec, TAG_DONE);
+    if (!sample || length == 0) {
+        return FALSE;
+    }
+
+    before = AvailMem(MEMF_ANY);
+    if (!OpenSVXWriter(&sw, (STRPTR)SVX_SCRATCH, samplesPerSec, 64, compress)) {
+        Printf("svx_write: %s could not be written\n", fq->fq_Name);
+        checksFailed++;
+        return FALSE;
+    }
+    held = AvailMem(MEMF_ANY);
+    held = (before > held) ? before - held : 0;
+    if (held > svxMemory[compress ? 1 : 0]) {
+        svxMemory[compress ? 1 : 0] = held;
+    }
+
+    for (done = 0; done < length; done += part) {
+        part = (length - done > SVX_BLOCK_SIZE) ? SVX_BLOCK_SIZE : length - done;
+        WriteSVXSamples(&sw, sample + done, part);
+    }
+    if (!CloseSVXWriter(&sw)) {
+        Printf("svx_write: %s could not be written\n", fq->fq_Name);
+        checksFailed++;
+        return FALSE;
+    }
+
+    copy = NewDTObject((APTR)SVX_SCRATCH, DTA_GroupID, GID_SOUND, TAG_DONE);
+    if (!copy) {
+        Printf("svx_write: copy of %s does not load\n", fq->fq_Name);
+        checksFailed++;
+        return FALSE;
+    }
+    GetDTAttrs(copy, SDTA_Sample, (ULONG)&copySample, SDTA_SampleLength, (ULONG)&copyLength, TAG_DONE);
+
+    same = (BOOL)(copySample && copyLength == length &&
+                  (compress || memcmp(copySample, sample, length) == 0));
+    if (!same) {
+        Printf("svx_write: copy of %s differs\n", fq->fq_Name);
+        checksFailed++;
+    }
+
+    DisposeDTObject(copy);
+
+    return same;
+}
+
+/* Resample ramps, in uneven blocks, and compare with the exact line; */
+/* dither constant levels and compare the average with the level */
+VOID CheckSampleAccuracy(VOID)
+{
+    static const ULONG rates[][2] = {
+        { 8363, 44100 }, { 22050, 44100 }, { 44100, 22050 }, { 44100, 8000 }, { 11025, 11025 }
+    };
+    struct SampleConverter sc;
+    WORD *ramp;
+    WORD *out;
+    BYTE *narrow;
+    ULONG r;
+    ULONG i;
+    LONG level;
+
+    ramp = (WORD *)OSAllocMem(SAMPLE_BLOCK_SIZE * sizeof(WORD) * 2 + SAMPLE_BLOCK_SIZE);
+    if (!ramp) {
+        return;
+    }
+    out = ramp + SAMPLE_BLOCK_SIZE;
+    narrow = (BYTE *)(out + SAMPLE_BLOCK_SIZE);
+
+    /* A ramp of 15 a sample interpolates exactly */
+    for (i = 0; i < SAMPLE_BLOCK_SIZE; i++) {
+        ramp[i] = (WORD)(i * 15 - 30000);
+    }
+
+    for (r = 0; r < sizeof(rates) / sizeof(rates[0]); r++) {
+        ULONG block;
+        ULONG done;
+        ULONG part;
+        ULONG produced = 0;
+        ULONG expected;
+        ULONG pos = 0;
+
+        InitSampleConverter(&sc, rates[r][0], rates[r][1]);
+        block = SampleInputBlock(&sc);
+
+        /* Odd piece sizes make sure the position carries over */
+        for (done = 0; done < 2000; done += part) {
+            ULONG count;
+
+            part = 1 + NextRandom() % 97;
+            if (part > block) {
+                part = block;
+            }
+            if (part > 2000 - done) {
+                part = 2000 - done;
+            }
+            count = ResampleSamples(&sc, ramp + done, part, out);
+            for (i = 0; i < count; i++, pos += sc.sc_Step) {
+                LONG exact = -30000 + (LONG)((pos >> 16) * 15) + (LONG)(((pos & 0xFFFF) * 15) >> 16);
+                ULONG error = (ULONG)((out[i] > exact) ? out[i] - exact : exact - out[i]);
+
+                if (error > resampleError) {
+                    resampleError = error;
+                }
+            }
+            produced += count;
+        }
+        produced += FinishResample(&sc, out, SAMPLE_BLOCK_SIZE);
+
+        /* As many samples out as the rates say, give or take one */
+        expected = (2000 * rates[r][1]) / rates[r][0];
+        if (produced + 1 < expected || produced > expected + 1) {
+            Printf("sample_resample: %lu to %lu Hz gave %lu samples, not %lu\n",
+                   rates[r][0], rates[r][1], produced, expected);
+            checksFailed++;
+        }
+    }
+    if (resampleError > 1) {
+        Printf("sample_resample: ramp off by up to %lu\n", resampleError);
+        checksFailed++;
+    }
+
+    /* Dither is unbiased: levels between 8-bit steps average out to them */
+    InitSampleConverter(&sc, 0, 0);
+    for (level = -32000; level <= 32000; level += 1237) {
+        LONG sum = 0;
+        LONG bias;
+
+        for (i = 0; i < SAMPLE_BLOCK_SIZE; i++) {
+            out[i] = (WORD)level;
+        }
+        DitherSamples(&sc, out, narrow, SAMPLE_BLOCK_SIZE);
+        for (i = 0; i < SAMPLE_BLOCK_SIZE; i++) {
+            sum += narrow[i];
+        }
+
+        /* sum * 256 / SAMPLE_BLOCK_SIZE, the average in 16-bit units */
+        bias = sum / (SAMPLE_BLOCK_SIZE / 256) - level;
+        if (bias < 0) {
+            bias = -bias;
+        }
+        if ((ULONG)bias > ditherBias) {
+            ditherBias = (ULONG)bias;
+        }
+    }
+    if (ditherBias > 32) {
+        Printf("sample_dither: average off by up to %lu\n", ditherBias);
+        checksFailed++;
+    }
+
+    OSFreeMem(ramp);
+}
+
+/* Time 8-bit sound resampled to 16 bits and back, and dither alone */
+/* Counts are output samples */
+VOID BenchSampleConversion(ULONG iterations, struct BenchResult *resample, struct BenchResult *dither)
+{
+    struct SampleConverter sc;
+    struct EClockVal start;
+    BYTE *sound;
+    WORD *wide;
+    WORD *out;
+    BYTE *narrow;
+    ULONG iter;
+    ULONG block;
+    ULONG done;
+    ULONG part;
+    ULONG count;
+    LONG value = 0;
+    ULONG i;
+
+    sound = (BYTE *)OSAllocMem(SAMPLE_BUFFER_SIZE + SAMPLE_BLOCK_SIZE * (sizeof(WORD) * 2 + 1));
+    if (!sound) {
+        return;
+    }
+    wide = (WORD *)(sound + SAMPLE_BUFFER_SIZE);
+    out = wide + SAMPLE_BLOCK_SIZE;
+    narrow = (BYTE *)(out + SAMPLE_BLOCK_SIZE);
+
+    /* A random walk, which sounds more like a sample than noise does */
+    for (i = 0; i < SAMPLE_BUFFER_SIZE; i++) {
+        value += (LONG)(NextRandom() % 9) - 4;
+        if (value > 127) {
+            value = 127;
+        } else if (value < -128) {
+            value = -128;
+        }
+        sound[i] = (BYTE)value;
+    }
+
+    /* 22050 Hz to 44100 Hz, widened, resampled and dithered back */
+    ReadTimer(&start);
+    for (iter = 0; iter < iterations; iter++) {
+        InitSampleConverter(&sc, 22050, 44100);
+        block = SampleInputBlock(&sc);
+        for (done = 0; done < SAMPLE_BUFFER_SIZE; done += part) {
+            part = (SAMPLE_BUFFER_SIZE - done > block) ? block : SAMPLE_BUFFER_SIZE - done;
+            ExpandSamples(sound + done, wide, part);
+            count = ResampleSamples(&sc, wide, part, out);
+            DitherSamples(&sc, out, narrow, count);
+            resample->br_Count += count;
+        }
+    }
+    resample->br_Micros = ElapsedMicros(&start);
+
+    /* 16 bits to 8 alone */
+    ExpandSamples(sound, wide, SAMPLE_BLOCK_SIZE);
+    ReadTimer(&start);
+    for (iter = 0; iter < iterations; iter++) {
+        for (done = 0; done < SAMPLE_BUFFER_SIZE; done += SAMPLE_BLOCK_SIZE) {
+            DitherSamples(&sc, wide, narrow, SAMPLE_BLOCK_SIZE);
+            dither->br_Count += SAMPLE_BLOCK_SIZE;
+        }
+    }
+    dither->br_Micros = ElapsedMicros(&start);
+
+    OSFreeMem(sound);
+}
+
+/* Count a file a catalogue search found */
+static BOOL CountFound(struct CatalogFile *cf, struct CatalogRecord *cr, APTR userData)
+{
+    return TRUE;
+}
+
+/* Time writing a catalogue of catalogRecords made-up files, as a WATCH */
+/* index of that many would be, then FIND queries over it: equalities on */
+/* group and BaseName, ranges on the numbers. Fewer records are made if */
+/* there is not the memory for them. Counts are records, then queries. */
+VOID BenchCatalog(ULONG iterations, struct BenchResult *write, struct BenchResult *find)
+{
+    static STRPTR queries[CATALOG_QUERIES] = {
+        (STRPTR)"group=picture width>640",
+        (STRPTR)"group=sound rate>22050",
+        (STRPTR)"basename=ilbm height>=400 depth=8",
+        (STRPTR)"group=animation frames>100",
+        (STRPTR)"size<1024",
+        (STRPTR)"length>=100000,length<200000"
+    };
+    static STRPTR baseNames[] = {
+        (STRPTR)"ilbm", (STRPTR)"png", (STRPTR)"jpeg", (STRPTR)"8svx",
+        (STRPTR)"wave", (STRPTR)"anim", (STRPTR)"ascii", (STRPTR)"amigaguide"
+    };
+    static const ULONG rates[] = { 8363, 11025, 16726, 22050, 44100 };
+    struct CatalogQuery cq;
+    struct CatalogFile *cf;
+    struct IndexEntry *entries;
+    struct IndexEntry *ie;
+    struct EClockVal start;
+    UBYTE *paths;
+    ULONG records = catalogRecords;
+    ULONG matches;
+    ULONG iter;
+    ULONG kind;
+    ULONG i;
+    ULONG q;
+
+    /* Paths in the order a WATCH index holds them */
+    for (;;) {
+        entries = (struct IndexEntry *)OSAllocMem(sizeof(struct IndexEntry) * records);
+        paths = (UBYTE *)OSAllocMem(records * 24);
+        if ((entries && paths) || records <= 1024) {
+            break;
+        }
+        OSFreeMem(entries);
+        OSFreeMem(paths);
+        records /= 2;
+    }
+    if (!entries || !paths) {
+        OSFreeMem(entries);
+        OSFreeMem(paths);
+        catalogRecords = 0;
+        return;
+    }
+    catalogRecords = records;
+
+    for (i = 0; i < records; i++) {
+        ie = &entries[i];
+        ie->ie_Path = (STRPTR)(paths + i * 24);
+        SNPrintf(ie->ie_Path, 24, "Work:Files/%08lx", i);
+        ie->ie_Size = (NextRandom() << 4) | (NextRandom() & 15);
+        kind = NextRandom() % 8;
+        Strncpy(ie->ie_BaseName, baseNames[kind], sizeof(ie->ie_BaseName));
+        switch (kind) {
+            case 0:
+            case 1:
+            case 2:
+            case 5:
+                ie->ie_GroupID = (kind == 5) ? GID_ANIMATION : GID_PICTURE;
+                ie->ie_Width = 1 + NextRandom() % 1280;
+                ie->ie_Height = 1 + NextRandom() % 1024;
+                ie->ie_Depth = (kind == 2) ? 24 : 1 + NextRandom() % 8;
+                ie->ie_Frames = (kind == 5) ? 2 + NextRandom() % 300 : 0;
+                break;
+            case 3:
+            case 4:
+                ie->ie_GroupID = GID_SOUND;
+                ie->ie_SamplesPerSec = rates[NextRandom() % 5];
+                ie->ie_SampleLength = NextRandom() * 8;
+                break;
+            default:
+                ie->ie_GroupID = GID_TEXT;
+                break;
+        }
+    }
+
+    ReadTimer(&start);
+    if (WriteCatalog((STRPTR)CATALOG_SCRATCH, entries, records)) {
+        write->br_Count = records;
+    }
+    write->br_Micros = ElapsedMicros(&start);
+
+    OSFreeMem(paths);
+    OSFreeMem(entries);
+
+    cf = OpenCatalog((STRPTR)CATALOG_SCRATCH);
+    if (cf) {
+        ReadTimer(&start);
+        for (iter = 0; iter < iterations; iter++) {
+            for (q = 0; q < CATALOG_QUERIES; q++) {
+                cf->cf_Reads = 0;
+                if (ParseCatalogQuery(queries[q], &cq) && SearchCatalog(cf, &cq, CountFound, NULL, &matches)) {
+                    find->br_Count++;
+                    catalogReads += cf->cf_Reads;
+                    catalogCandidates += cf->cf_Candidates;
+                    catalogMatches += matches;
+                }
+            }
+        }
+        find->br_Micros = ElapsedMicros(&start);
+        catalogQueries = find->br_Count;
+        CloseCatalog(cf);
+    }
+
+    OSDelete((STRPTR)CATALOG_SCRATCH);
+}
+
+/* Write a sound at twice its rate and check the copy's rate and length */
+BOOL CheckSoundResample(struct FileQuery *fq, ULONG *written)
+{
+    Object *dtObject;
+    Object *copy;
+    ULONG length = 0;
+    ULONG samplesPerSec = 0;
+    ULONG copyLength = 0;
+    ULONG copyRate = 0;
+    BOOL same;
+
+    *written = 0;
+
+    dtObject = GetFileObject(fq);
+    if (!dtObject) {
+        return FALSE;
+    }
+    GetDTAttrs(dtObject, SDTA_SampleLength, (ULONG)&length, SDTA_SamplesPerSec, (ULONG)&samplesPerSec, TAG_DONE);
+    if (length == 0 || samplesPerSec == 0 || samplesPerSec > 32767) {
+        return FALSE;
+    }
+
+    if (!WriteSoundIFF(dtObject, (STRPTR)RATE_SCRATCH, samplesPerSec * 2, 8, FALSE)) {
+        Printf("sound_rate: %s could not be written\n", fq->fq_Name);
+        checksFailed++;
+        return FALSE;
+    }
+
+    copy = NewDTObject((APTR)RATE_SCRATCH, DTA_GroupID, GID_SOUND, TAG_DONE);
+    if (!copy) {
+        Printf("sound_rate: copy of %s does not load\n", fq->fq_Name);
+        checksFailed++;
+        return FALSE;
+    }
+    GetDTAttrs(copy, SDTA_SampleLength, (ULONG)&copyLength, SDTA_SamplesPerSec, (ULONG)&copyRate, TAG_DONE);
+
+    same = (BOOL)(copyRate == samplesPerSec * 2 && copyLength == length * 2);
+    if (!same) {
+        Printf("sound_rate: copy of %s has %lu samples at %lu Hz\n", fq->fq_Name, copyLength, copyRate);
+        checksFailed++;
+    }
+    *written = copyLength;
+
+    DisposeDTObject(copy);
+
+    return same;
+}
+
+/* Make a DTM_WRITE fail over an existing file, once through each writer, */
+/* and note whether the file that was there survived */
+VOID CheckFailedWrite(Object *dtObject, STRPTR name)
+{
+    struct OSFileInfo info;
+    ULONG size;
+    ULONG w;
+
+    for (w = 0; w < 2; w++) {
+        if (!WriteDTObject(dtObject, name, DTWM_IFF) || !OSExamine(name, &info)) {
+            return;
+        }
+        size = info.ofi_Size;
+
+        /* No class writes in this mode, so DTM_WRITE returns 0 */
+        if (w == 0) {
+            if (SaveDTObjectA(dtObject, NULL, NULL, name, DTM_WRITE_BOGUS, FALSE, TAG_DONE)) {
+                return;
+            }
+        } else if (WriteDTObject(dtObject, name, DTM_WRITE_BOGUS)) {
+            return;
+        }
+
+        if (w == 0) {
+            writeFailures++;
+        }
+        if (!OSExamine(name, &info) || info.ofi_Size != size) {
+            writeLost[w]++;
+
+            /* WriteDTObject() must keep the file; SaveDTObjectA() is only counted */
+            if (w == 1) {
+                Printf("failed_writes: %s lost when WriteDTObject() failed\n", name);
+                checksFailed++;
+            }
+        }
+    }
+}
+
+/* Compare a file's estimate with the memory its decode took, then see */
+/* that a one-byte MEMLIMIT turns the decode away */
+VOID CheckFootprint(struct DTContext *ctx, STRPTR fileName)
+{
+    struct FileQuery fq;
+    struct FootprintEstimate fe;
+    ULONG before;
+    ULONG after;
+
+    if (!OpenFileQuery(ctx, &fq, fileName)) {
+        return;
+    }
+    if (ObtainFileDataType(&fq)) {
+        before = AvailMem(MEMF_ANY);
+        if (GetFileObject(&fq) && fq.fq_Estimate.fe_Source == ESTIMATE_HEADER) {
+            after = AvailMem(MEMF_ANY);
+            footprintFiles++;
+            footprintEstimated += fq.fq_Estimate.fe_Total;
+            footprintMeasured += (before > after) ? before - after : 0;
+        }
+    }
+    CloseFileQuery(&fq);
+
+    ctx->dc_MemLimit = 1;
+    if (OpenFileQuery(ctx, &fq, fileName)) {
+        if (ObtainFileDataType(&fq)) {
+            if (!GetFileObject(&fq) && fq.fq_MetadataOnly) {
+                footprintRefused++;
+            } else if (fq.fq_Object && EstimateFootprint(&fq, &fe)) {
+                Printf("footprint: %s decoded with MEMLIMIT=1\n", fileName);
+                checksFailed++;
+            }
+        }
+        CloseFileQuery(&fq);
+    }
+    ctx->dc_MemLimit = 0;
+}
+
+/* Estimate the same ANIM with interleave 0 and 1. Two display buffers */
+/* and the key frame make three bitmaps, one buffer two, so the second */
+/* estimate must be two thirds of the first */
+VOID CheckAnimEstimate(struct DTContext *ctx)
+{
+    struct FileQuery fq;
+    struct FootprintEstimate fe;
+    ULONG interleave;
+    BOOL ok;
+    BPTR fh;
+
+    for (interleave = 0; interleave < 2; interleave++) {
+        animEstimate[interleave] = 0;
+
+        fh = Open((STRPTR)ANIM_SCRATCH, MODE_NEWFILE);
+        if (!fh) {
+            return;
+        }
+        ok = PutANIM(fh, 16384, (UBYTE)interleave);
+        if (!Close(fh) || !ok) {
+            OSDelete((STRPTR)ANIM_SCRATCH);
+            return;
+        }
+
+        if (OpenFileQuery(ctx, &fq, (STRPTR)ANIM_SCRATCH)) {
+            if (EstimateFootprint(&fq, &fe) && fe.fe_Source == ESTIMATE_HEADER) {
+                animEstimate[interleave] = fe.fe_Total;
+            }
+            CloseFileQuery(&fq);
+        }
+    }
+    OSDelete((STRPTR)ANIM_SCRATCH);
+
+    if (animEstimate[1] == 0 || animEstimate[1] * 3 != animEstimate[0] * 2) {
+        Printf("estimate: ANIM with interleave 1 estimated at %lu bytes, with interleave 0 at %lu\n",
+               animEstimate[1], animEstimate[0]);
+        checksFailed++;
+    }
+}
+
+/* Convert a file to each format of its group in turn, as FORMAT= does, */
+/* and identify what was written against the BaseName asked for */
+VOID CheckFormatWrites(struct DTContext *ctx, STRPTR fileName)
+{
+    struct FileQuery fq;
+    struct FileQuery out;
+    struct DataType *dtn = NULL;
+    struct DataType *prevdtn = NULL;
+    struct TagItem tags[3];
+    STRPTR baseName;
+    STRPTR identified;
+
+    if (!OpenFileQuery(ctx, &fq, fileName)) {
+        return;
+    }
+    if (!ObtainFileDataType(&fq)) {
+        CloseFileQuery(&fq);
+        return;
+    }
+
+    tags[0].ti_Tag = DTA_DataType;
+    tags[0].ti_Data = (ULONG)prevdtn;
+    tags[1].ti_Tag = DTA_GroupID;
+    tags[1].ti_Data = fq.fq_DataType->dtn_Header->dth_GroupID;
+    tags[2].ti_Tag = TAG_DONE;
+
+    while ((dtn = ObtainDataTypeA(DTST_RAM, NULL, tags)) != NULL) {
+        if (prevdtn) {
+            ReleaseDataType(prevdtn);
+        }
+        prevdtn = dtn;
+        tags[0].ti_Data = (ULONG)prevdtn;
+
+        baseName = dtn->dtn_Header->dth_BaseName;
+        if (!baseName) {
+            continue;
+        }
+
+        formatTried++;
+        OSDelete((STRPTR)FORMAT_SCRATCH);
+        if (!ConvertToFormat(&fq, dtn, (STRPTR)FORMAT_SCRATCH)) {
+            continue;
+        }
+        formatWritten++;
+
+        identified = NULL;
+        if (OpenFileQuery(ctx, &out, (STRPTR)FORMAT_SCRATCH)) {
+            if (ObtainFileDataType(&out)) {
+                identified = out.fq_DataType->dtn_Header->dth_BaseName;
+            }
+            if (!identified || Stricmp(identified, baseName) != 0) {
+                formatMismatched++;
+                Printf("format_write: %s as %s was identified as %s\n", fileName, baseName,
+                       identified ? identified : (STRPTR)"nothing");
+                checksFailed++;
+            }
+            CloseFileQuery(&out);
+        }
+    }
+
+    if (prevdtn) {
+        ReleaseDataType(prevdtn);
+    }
+    CloseFileQuery(&fq);
+}
+
+/* Whether cold_query ran DataType from the resident list rather than disk */
+BOOL IsDataTypeResident(VOID)
+{
+    struct Segment *seg;
+
+    Forbid();
+    seg = FindSegment((STRPTR)"DataType", NULL, 0);
+    Permit();
+
+    return (BOOL)(seg != NULL);
+}
+
+/* Emit results as JSON so runs can be compared */
+VOID WriteResults(BPTR fh, struct BenchResult *results, ULONG resultCount, ULONG fileCount, ULONG totalBytes, ULONG iterations)
+{
+    ULONG i;
+
+    FPrintf(fh, "{\n");
+    FPrintf(fh, "  \"tool\": \"DTBench\",\n");
+    FPrintf(fh, "  \"version\": \"47.2\",\n");
+    FPrintf(fh, "  \"eclock_hz\": %lu,\n", TimerFrequency());
+    FPrintf(fh, "  \"iterations\": %lu,\n", iterations);
+    FPrintf(fh, "  \"resident\": %s,\n", IsDataTypeResident() ? (STRPTR)"true" : (STRPTR)"false");
+    FPrintf(fh, "  \"corpus\": { \"files\": %lu, \"bytes\": %lu },\n", fileCount, totalBytes);
+    FPrintf(fh, "  \"checks_failed\": %lu,\n", checksFailed);
+    FPrintf(fh, "  \"svx_writer_bytes\": { \"plain\": %lu, \"delta\": %lu },\n", svxMemory[0], svxMemory[1]);
+    FPrintf(fh, "  \"failed_writes\": { \"tried\": %lu, \"lost_savedtobject\": %lu, \"lost_writedtobject\": %lu },\n",
+            writeFailures, writeLost[0], writeLost[1]);
+    FPrintf(fh, "  \"sample_accuracy\": { \"resample_error\": %lu, \"dither_bias\": %lu },\n", resampleError, ditherBias);
+    FPrintf(fh, "  \"format_write\": { \"tried\": %lu, \"written\": %lu, \"mismatched\": %lu },\n",
+            formatTried, formatWritten, formatMismatched);
+    FPrintf(fh, "  \"footprint\": { \"files\": %lu, \"estimated\": %lu, \"decoded\": %lu, \"refused\": %lu },\n",
+            footprintFiles, footprintEstimated, footprintMeasured, footprintRefused);
+    FPrintf(fh, "  \"anim_estimate\": { \"interleave_0\": %lu, \"interleave_1\": %lu },\n",
+            animEstimate[0], animEstimate[1]);
+    FPrintf(fh, "  \"fast_identify\": { \"files\": %lu, \"by_extension\": %lu, \"agreed\": %lu },\n",
+            fastFiles, fastByExtension, fastAgreed);
+    FPrintf(fh, "  \"watch\": { \"files\": %lu, \"identified\": %lu, \"identified_again\": %lu, \"own_changes\": %lu },\n",
+            watchFiles, watchIdentified, watchAgain, watchOwn);
+    FPrintf(fh, "  \"catalog\": { \"records\": %lu, \"queries\": %lu, \"reads_per_query\": %lu, \"candidates\": %lu, \"matches\": %lu },\n",
+            catalogRecords, catalogQueries, catalogQueries ? catalogReads / catalogQueries : 0,
+            catalogCandidates, catalogMatches);
+    FPrintf(fh, "  \"results\": [\n");
+
+    for (i = 0; i < resultCount; i++) {
+        ULONG perSec = 0;
+
+        /* Operations per second, kept within 32 bits */
+        if (results[i].br_Micros >= 1000) {
+            perSec = (results[i].br_Count * 1000) / (results[i].br_Micros / 1000);
+        }
+
+        FPrintf(fh, "    { \"name\": \"%s\", \"count\": %lu, \"micros\": %lu, \"per_sec\": %lu }%s\n",
+                results[i].br_Name, results[i].br_Count, results[i].br_Micros, perSec,
+                (i + 1 < resultCount) ? (STRPTR)"," : (STRPTR)"");
+    }
+
+    FPrintf(fh, "  ]\n");
+    FPrintf(fh, "}\n");
+}
@@ -0,0 +1,312 @@
+/*
+ * DataType - link library interface
+ *
+ * Copyright (c) 2025 amigazen project
+ * Licensed under BSD 2-Clause License
+ */
+
+#include "datatype.h"
+
+/*
+ * Other programs link datatype.lib and drive identification, metadata,
+ * tool resolution and conversion through a DTContext instead of running
+ * the DataType command:
+ *
+ *     ctx = CreateDTContext();
+ *     while (...) {
+ *         if (DTIdentify(ctx, path, &record)) { ... }
+ *     }
+ *     FreeDTContext(ctx);
+ *
+ * The context owns the lookup caches and, if it had to open them, the
+ * libraries. The DataType command itself is a client of these calls.
+ *
+ * dc_Fields says which fields of a record are wanted. FillRecord() only
+ * runs the phases FieldMap lists for those fields, so group and BaseName
+ * alone cost nothing beyond the identification already made.
+ */
+
+/* Which phases each field needs; DTBench checks queries against this */
+const struct FieldDef FieldMap[] = {
+    { (STRPTR)"group",    RECF_GROUP,    0 },
+    { (STRPTR)"basename", RECF_BASENAME, 0 },
+    { (STRPTR)"name",     RECF_NAME,     0 },
+    { (STRPTR)"dims",     RECF_DIMS,     PHASEF(PHASE_DECODE) },
+    { (STRPTR)"colors",   RECF_COLORS,   PHASEF(PHASE_DECODE) },
+    { (STRPTR)"frames",   RECF_FRAMES,   PHASEF(PHASE_DECODE) },
+    { (STRPTR)"audio",    RECF_AUDIO,    PHASEF(PHASE_DECODE) },
+    { (STRPTR)"text",     RECF_TEXT,     PHASEF(PHASE_DECODE) },
+    { (STRPTR)"write",    RECF_WRITE,    PHASEF(PHASE_DECODE) | PHASEF(PHASE_WRITEPROBE) },
+    { (STRPTR)"tools",    RECF_TOOLS,    PHASEF(PHASE_DTYPSCAN) },
+    { (STRPTR)"deficons", RECF_DEFICONS, PHASEF(PHASE_DEFICONS) },
+    { NULL, 0, 0 }
+};
+
+/* Create a context, opening the libraries if the caller has not */
+struct DTContext *CreateDTContext(VOID)
+{
+    struct DTContext *ctx;
+
+    ctx = (struct DTContext *)OSAllocMem(sizeof(struct DTContext));
+    if (!ctx) {
+        SetIoErr(ERROR_NO_FREE_STORE);
+        return NULL;
+    }
+
+    NewList((struct List *)&ctx->dc_Cache);
+    ctx->dc_LoadCutoff = DEFAULT_LOAD_CUTOFF;
+    ctx->dc_Fields = RECF_ALL;
+
+    if (!DataTypesBase) {
+        if (!InitializeLibraries()) {
+            OSFreeMem(ctx);
+            return NULL;
+        }
+        ctx->dc_OwnsLibraries = TRUE;
+    }
+
+    return ctx;
+}
+
+/* Free a context and everything it holds */
+VOID FreeDTContext(struct DTContext *ctx)
+{
+    if (!ctx) {
+        return;
+    }
+
+    FreeCache(ctx);
+    FreeCandidates(ctx);
+    SaveUnknownFiles(ctx);
+    FreeUnknownFiles(ctx);
+
+    if (ctx->dc_Stats) {
+        FreeStats(ctx);
+    }
+
+    if (ctx->dc_OwnsLibraries) {
+        Cleanup();
+    }
+
+    OSFreeMem(ctx);
+}
+
+/* Parse a comma-separated list of field names into RECF_ flags */
+/* "all" selects every field; FALSE if a name is not known */
+BOOL ParseFields(STRPTR list, ULONG *fields)
+{
+    UBYTE name[16];
+    ULONG len;
+    ULONG i;
+
+    if (!list || !fields) {
+        SetIoErr(ERROR_REQUIRED_ARG_MISSING);
+        return FALSE;
+    }
+
+    *fields = 0;
+
+    while (*list) {
+        for (len = 0; list[len] && list[len] != ','; len++) {
+        }
+
+        if (len > 0) {
+            if (len >= sizeof(name)) {
+                SetIoErr(ERROR_BAD_TEMPLATE);
+                return FALSE;
+            }
+            CopyMem(list, name, len);
+            name[len] = '\0';
+
+            if (Stricmp(name, (STRPTR)"all") == 0) {
+                *fields |= RECF_ALL;
+            } else {
+                for (i = 0; FieldMap[i].fd_Name; i++) {
+                    if (Stricmp(name, FieldMap[i].fd_Name) == 0) {
+                        *fields |= FieldMap[i].fd_Field;
+                        break;
+                    }
+                }
+                if (!FieldMap[i].fd_Name) {
+                    SetIoErr(ERROR_BAD_TEMPLATE);
+                    return FALSE;
+                }
+            }
+        }
+
+        list += len;
+        if (*list == ',') {
+            list++;
+        }
+    }
+
+    return TRUE;
+}
+
+/* Phases that must run to fill in a set of fields */
+ULONG FieldPhases(ULONG fields)
+{
+    ULONG phases = PHASEF(PHASE_OBTAIN);
+    ULONG i;
+
+    for (i = 0; FieldMap[i].fd_Name; i++) {
+        if (fields & FieldMap[i].fd_Field) {
+            phases |= FieldMap[i].fd_Phases;
+        }
+    }
+
+    return phases;
+}
+
+/* Fill in the context's fields of a record for a file that has been */
+/* opened and identified, running only the phases they need */
+BOOL FillRecord(struct DTContext *ctx, struct FileQuery *fq, struct DTRecord *record)
+{
+    struct DataType *dtn;
+    struct DataTypeHeader *dth;
+    STRPTR groupName;
+    STRPTR defIconsTool = NULL;
+    Object *dtObject;
+    ULONG fields;
+    ULONG phases;
+
+    if (!ctx || !fq || !record) {
+        SetIoErr(ERROR_REQUIRED_ARG_MISSING);
+        return FALSE;
+    }
+
+    memset(record, 0, sizeof(struct DTRecord));
+
+    dtn = fq->fq_DataType;
+    if (!dtn || !dtn->dtn_Header) {
+        SetIoErr(ERROR_OBJECT_WRONG_TYPE);
+        return FALSE;
+    }
+    dth = dtn->dtn_Header;
+
+    fields = ctx->dc_Fields;
+    phases = FieldPhases(fields);
+
+    /* Type: group in plain English, BaseName and descriptive name */
+    record->dr_GroupID = dth->dth_GroupID;
+    record->dr_ID = dth->dth_ID;
+    groupName = GetDTString(dth->dth_GroupID);
+    Strncpy(record->dr_GroupName, groupName ? groupName : (STRPTR)"Unknown", sizeof(record->dr_GroupName));
+    Strncpy(record->dr_BaseName, dth->dth_BaseName ? dth->dth_BaseName : (STRPTR)"Unknown", sizeof(record->dr_BaseName));
+    if (dth->dth_Name) {
+        Strncpy(record->dr_Name, dth->dth_Name, sizeof(record->dr_Name));
+    }
+    record->dr_Valid |= RECF_GROUP | RECF_BASENAME | RECF_NAME;
+    if (ctx->dc_Fast) {
+        record->dr_IdentifiedBy = fq->fq_IdentifiedBy;
+    }
+
+    /* DefIcons type and default tool, if DefIcons is running */
+    if (phases & PHASEF(PHASE_DEFICONS)) {
+        LookupDefIcons(ctx, fq->fq_Name, record->dr_DefIconsType, sizeof(record->dr_DefIconsType), &defIconsTool);
+        if (defIconsTool) {
+            Strncpy(record->dr_DefIconsTool, defIconsTool, sizeof(record->dr_DefIconsTool));
+            OSFreeMem(defIconsTool);
+        }
+        record->dr_Valid |= RECF_DEFICONS;
+    }
+
+    /* Metadata and write capabilities need the decoded object */
+    if (phases & PHASEF(PHASE_DECODE)) {
+        dtObject = GetFileObject(fq);
+        if (dtObject) {
+            GetDatatypeMetadata(dtObject, dth->dth_GroupID, record);
+            if (phases & PHASEF(PHASE_WRITEPROBE)) {
+                GetWriteCapabilities(ctx, dtObject, dtn, record);
+            }
+        } else if (fq->fq_MetadataOnly) {
+            /* Too big to decode: what the header said will have to do */
+            struct FootprintEstimate *fe = &fq->fq_Estimate;
+
+            if (fe->fe_Width != 0 && fe->fe_Height != 0) {
+                record->dr_Width = fe->fe_Width;
+                record->dr_Height = fe->fe_Height;
+                record->dr_Depth = fe->fe_Depth;
+                record->dr_Valid |= RECF_DIMS;
+            }
+            if (fe->fe_SampleLength != 0) {
+                record->dr_SampleLength = fe->fe_SampleLength;
+                record->dr_SamplesPerSec = fe->fe_SamplesPerSec;
+                record->dr_Valid |= RECF_AUDIO;
+            }
+            record->dr_MetadataOnly = TRUE;
+            record->dr_Estimate = fe->fe_Total;
+        }
+    }
+
+    if (phases & PHASEF(PHASE_DTYPSCAN)) {
+        GetRecordTools(ctx, dtn, record);
+    }
+
+    /* A phase may fill in more than was asked for; report only that */
+    record->dr_Valid &= fields;
+
+    return TRUE;
+}
+
+/* Identify a file and fill in everything known about it */
+BOOL DTIdentify(struct DTContext *ctx, STRPTR path, struct DTRecord *record)
+{
+    struct FileQuery fq;
+    BOOL result = FALSE;
+
+    if (!ctx || !path || !record) {
+        SetIoErr(ERROR_REQUIRED_ARG_MISSING);
+        return FALSE;
+    }
+
+    if (!OpenFileQuery(ctx, &fq, path)) {
+        return FALSE;
+    }
+
+    if (ObtainFileDataType(&fq)) {
+        result = FillRecord(ctx, &fq, record);
+    }
+
+    CloseFileQuery(&fq);
+
+    return result;
+}
+
+/* Convert a file to the format with the given BaseName, or to IFF if NULL */
+/* An existing target is overwritten */
+BOOL DTConvert(struct DTContext *ctx, STRPTR path, STRPTR formatBaseName, STRPTR target)
+{
+    struct FileQuery fq;
+    struct DataType *dtn;
+    struct DataType *destDtn;
+    BOOL result = FALSE;
+
+    if (!ctx || !path || !target) {
+        SetIoErr(ERROR_REQUIRED_ARG_MISSING);
+        return FALSE;
+    }
+
+    if (!OpenFileQuery(ctx, &fq, path)) {
+        return FALSE;
+    }
+
+    dtn = ObtainFileDataType(&fq);
+    if (dtn) {
+        if (!formatBaseName) {
+            result = ConvertToIFF(&fq, target);
+        } else {
+            destDtn = FindFormatByBaseName(dtn->dtn_Header->dth_GroupID, formatBaseName);
+            if (destDtn) {
+                result = ConvertToFormat(&fq, destDtn, target);
+                ReleaseDataType(destDtn);
+            } else {
+                SetIoErr(ERROR_OBJECT_NOT_FOUND);
+            }
+        }
+    }
+
+    CloseFileQuery(&fq);
+
+    return result;
+}
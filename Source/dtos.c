@@ -0,0 +1,661 @@
+/*
+ * DataType - OS layer for files, locks, directories and memory
+ *
+ * Copyright (c) 2025 amigazen project
+ * Licensed under BSD 2-Clause License
+ */
+
+#include "datatype.h"
+
+/*
+ * The query, descriptor, metadata and conversion modules reach files,
+ * locks, directories and memory only through these calls. They keep the
+ * STATS counters in one place and are the seam another backend has to
+ * replace.
+ */
+
+/* Lock a file or directory for reading */
+BPTR OSLock(STRPTR name)
+{
+    STAT_ADD(qs_Locks, 1);
+    return Lock(name, ACCESS_READ);
+}
+
+/* Lock the parent directory of a lock */
+BPTR OSParentDir(BPTR lock)
+{
+    STAT_ADD(qs_Locks, 1);
+    return ParentDir(lock);
+}
+
+/* Release a lock obtained from this layer */
+VOID OSUnLock(BPTR lock)
+{
+    if (lock) {
+        UnLock(lock);
+    }
+}
+
+/* Open an existing file for reading */
+BPTR OSOpen(STRPTR name)
+{
+    STAT_ADD(qs_Opens, 1);
+    return Open(name, MODE_OLDFILE);
+}
+
+/* Read from a file opened with OSOpen() */
+LONG OSRead(BPTR fh, APTR buffer, LONG length)
+{
+    LONG bytesRead;
+
+    bytesRead = Read(fh, buffer, length);
+    STAT_ADD(qs_Reads, 1);
+    if (bytesRead > 0) {
+        STAT_ADD(qs_Bytes, bytesRead);
+    }
+
+    return bytesRead;
+}
+
+/* Create a file for writing, replacing any file of that name */
+BPTR OSCreate(STRPTR name)
+{
+    STAT_ADD(qs_Opens, 1);
+    return Open(name, MODE_NEWFILE);
+}
+
+/* Open a file for writing at its end, creating it if it is not there */
+BPTR OSAppend(STRPTR name)
+{
+    BPTR fh;
+
+    STAT_ADD(qs_Opens, 1);
+    fh = Open(name, MODE_READWRITE);
+    if (fh && Seek(fh, 0, OFFSET_END) == -1) {
+        LONG error = IoErr();
+
+        Close(fh);
+        SetIoErr(error);
+        return NULL;
+    }
+
+    return fh;
+}
+
+/* Write to a file opened with OSCreate() or OSAppend() */
+LONG OSWrite(BPTR fh, APTR buffer, LONG length)
+{
+    return Write(fh, buffer, length);
+}
+
+/* Move to an absolute position in a file */
+/* Returns FALSE if the position cannot be reached */
+BOOL OSSeek(BPTR fh, LONG position)
+{
+    return (BOOL)(Seek(fh, position, OFFSET_BEGINNING) != -1);
+}
+
+/* Delete a file, such as a partly written output */
+BOOL OSDelete(STRPTR name)
+{
+    return (BOOL)(DeleteFile(name) != 0);
+}
+
+/* Make sure a directory is there, creating it if it is not */
+/* Returns FALSE if it cannot be made, or a file has its name */
+BOOL OSCreateDir(STRPTR name)
+{
+    struct OSFileInfo info;
+    BPTR lock;
+
+    if (OSExamine(name, &info)) {
+        if (info.ofi_Type < 0) {
+            SetIoErr(ERROR_OBJECT_WRONG_TYPE);
+            return FALSE;
+        }
+        return TRUE;
+    }
+
+    lock = CreateDir(name);
+    if (!lock) {
+        return FALSE;
+    }
+    UnLock(lock);
+
+    return TRUE;
+}
+
+/* Make a temporary name in the directory name will be in, without */
+/* creating the file. It is short, so it fits a 30-character filing */
+/* system however long the target's name is */
+BOOL OSTempName(STRPTR name, UBYTE *tempName, ULONG size)
+{
+    UBYTE unique[16];
+
+    Strncpy(tempName, name, size);
+    *PathPart(tempName) = '\0';
+    SNPrintf(unique, sizeof(unique), "DT%08lX.tmp", GetUniqueID());
+    if (!AddPart(tempName, unique, size)) {
+        SetIoErr(ERROR_LINE_TOO_LONG);
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+/* Create a temporary file in the directory name will be in, to be renamed */
+/* over it by OSCommitTemp(); bufferSize > 0 enlarges the DOS buffer for */
+/* callers that write in small pieces. tempName receives the name. */
+BPTR OSCreateTemp(STRPTR name, UBYTE *tempName, ULONG size, LONG bufferSize)
+{
+    BPTR fh;
+
+    if (!OSTempName(name, tempName, size)) {
+        return NULL;
+    }
+
+    fh = OSCreate((STRPTR)tempName);
+    if (fh && bufferSize > 0) {
+        SetVBuf(fh, NULL, BUF_FULL, bufferSize);
+    }
+
+    return fh;
+}
+
+/* Replace name with a finished temporary file from OSCreateTemp() */
+/* The old file is renamed aside first and only deleted once the new one */
+/* is in place. On failure name is left as it was, and the temporary file */
+/* is kept, so neither the old contents nor the new are lost. */
+/* The new file takes over the old one's protection bits and comment. */
+BOOL OSCommitTemp(STRPTR tempName, STRPTR name)
+{
+    UBYTE backup[TEMP_NAME_SIZE];
+    UBYTE unique[16];
+    struct FileInfoBlock *fib;
+    BOOL saved = FALSE;
+    BOOL examined;
+    LONG error;
+    BPTR lock;
+
+    fib = (struct FileInfoBlock *)AllocDosObject(DOS_FIB, NULL);
+    STAT_ADD(qs_Allocs, 1);
+    if (!fib) {
+        SetIoErr(ERROR_NO_FREE_STORE);
+        return FALSE;
+    }
+
+    /* Rename() will not replace a file, so the old one is moved aside, */
+    /* under a short name beside it as for the temporary file */
+    lock = OSLock(name);
+    if (lock) {
+        examined = (BOOL)(Examine(lock, fib) != 0);
+        error = IoErr();
+        OSUnLock(lock);
+        if (!examined || fib->fib_DirEntryType >= 0) {
+            FreeDosObject(DOS_FIB, fib);
+            SetIoErr(examined ? ERROR_OBJECT_WRONG_TYPE : error);
+            return FALSE;
+        }
+        Strncpy(backup, name, sizeof(backup));
+        *PathPart(backup) = '\0';
+        SNPrintf(unique, sizeof(unique), "DT%08lX.bak", GetUniqueID());
+        if (!AddPart(backup, unique, sizeof(backup))) {
+            FreeDosObject(DOS_FIB, fib);
+            SetIoErr(ERROR_LINE_TOO_LONG);
+            return FALSE;
+        }
+        if (!Rename(name, backup)) {
+            error = IoErr();
+            FreeDosObject(DOS_FIB, fib);
+            SetIoErr(error);
+            return FALSE;
+        }
+        saved = TRUE;
+    }
+
+    if (Rename(tempName, name)) {
+        if (saved) {
+            /* The new file keeps the old one's protection bits and comment */
+            SetProtection(name, fib->fib_Protection);
+            if (fib->fib_Comment[0]) {
+                SetComment(name, fib->fib_Comment);
+            }
+
+            /* A delete-protected backup would stay behind on every save */
+            if (!DeleteFile(backup)) {
+                SetProtection(backup, 0);
+                DeleteFile(backup);
+            }
+        }
+        FreeDosObject(DOS_FIB, fib);
+        return TRUE;
+    }
+
+    error = IoErr();
+    if (saved) {
+        Rename(backup, name);
+    }
+    FreeDosObject(DOS_FIB, fib);
+    SetIoErr(error);
+
+    return FALSE;
+}
+
+/* Close a file opened with OSOpen() or OSCreate() */
+/* Returns FALSE if buffered data could not be written out */
+BOOL OSClose(BPTR fh)
+{
+    if (fh) {
+        return (BOOL)(Close(fh) != 0);
+    }
+    return TRUE;
+}
+
+/* Load a whole file into memory with a single Read() */
+/* Returns an OSAllocMem()'d buffer with a NUL byte after the data, or NULL */
+/* if the file cannot be read, is empty or is larger than maxSize */
+UBYTE *OSLoadFile(STRPTR name, ULONG maxSize, ULONG *size)
+{
+    BPTR fh;
+    struct FileInfoBlock *fib;
+    UBYTE *buffer = NULL;
+    ULONG fileSize;
+
+    if (size) {
+        *size = 0;
+    }
+
+    fh = OSOpen(name);
+    if (!fh) {
+        return NULL;
+    }
+
+    fib = (struct FileInfoBlock *)AllocDosObject(DOS_FIB, NULL);
+    STAT_ADD(qs_Allocs, 1);
+    if (fib && ExamineFH(fh, fib)) {
+        fileSize = (ULONG)fib->fib_Size;
+        if (fileSize > 0 && fileSize <= maxSize) {
+            buffer = (UBYTE *)OSAllocMem(fileSize + 1);
+            if (buffer) {
+                if (OSRead(fh, buffer, (LONG)fileSize) == (LONG)fileSize) {
+                    if (size) {
+                        *size = fileSize;
+                    }
+                } else {
+                    OSFreeMem(buffer);
+                    buffer = NULL;
+                }
+            } else {
+                SetIoErr(ERROR_NO_FREE_STORE);
+            }
+        } else {
+            SetIoErr(fileSize == 0 ? ERROR_OBJECT_WRONG_TYPE : ERROR_OBJECT_TOO_LARGE);
+        }
+    }
+
+    if (fib) {
+        FreeDosObject(DOS_FIB, fib);
+    }
+    OSClose(fh);
+
+    return buffer;
+}
+
+/* Fill in size, type, key and datestamp from an existing lock */
+BOOL OSExamineLock(BPTR lock, struct OSFileInfo *info)
+{
+    struct FileInfoBlock *fib;
+    BOOL result = FALSE;
+
+    if (!lock || !info) {
+        return FALSE;
+    }
+
+    fib = (struct FileInfoBlock *)AllocDosObject(DOS_FIB, NULL);
+    STAT_ADD(qs_Allocs, 1);
+    if (!fib) {
+        SetIoErr(ERROR_NO_FREE_STORE);
+        return FALSE;
+    }
+
+    if (Examine(lock, fib)) {
+        info->ofi_Type = fib->fib_DirEntryType;
+        info->ofi_Size = (ULONG)fib->fib_Size;
+        info->ofi_Key = fib->fib_DiskKey;
+        info->ofi_Date = fib->fib_Date;
+        result = TRUE;
+    }
+
+    FreeDosObject(DOS_FIB, fib);
+
+    return result;
+}
+
+/* Full path of a lock, volume name first */
+BOOL OSNameFromLock(BPTR lock, STRPTR buffer, ULONG size)
+{
+    if (!lock || !buffer) {
+        return FALSE;
+    }
+    return (BOOL)(NameFromLock(lock, buffer, (LONG)size) != 0);
+}
+
+/* Fill in size, type, key and datestamp for a named object */
+BOOL OSExamine(STRPTR name, struct OSFileInfo *info)
+{
+    BPTR lock;
+    BOOL result;
+
+    lock = OSLock(name);
+    if (!lock) {
+        return FALSE;
+    }
+
+    result = OSExamineLock(lock, info);
+    OSUnLock(lock);
+
+    return result;
+}
+
+/* Allocate memory; released with OSFreeMem() */
+APTR OSAllocMem(ULONG size)
+{
+    STAT_ADD(qs_Allocs, 1);
+    return AllocVec(size, MEMF_ANY | MEMF_CLEAR);
+}
+
+/* Release memory obtained from OSAllocMem() */
+VOID OSFreeMem(APTR memory)
+{
+    if (memory) {
+        FreeVec(memory);
+    }
+}
+
+/* Compare two names ignoring ASCII case */
+/* Used by the match hook, which may run in the filesystem's process */
+/* and so must not touch globals or call libraries */
+static BOOL NameEquals(STRPTR a, STRPTR b)
+{
+    UBYTE ca;
+    UBYTE cb;
+
+    do {
+        ca = (UBYTE)*a++;
+        cb = (UBYTE)*b++;
+        if (ca >= 'A' && ca <= 'Z') {
+            ca += 'a' - 'A';
+        }
+        if (cb >= 'A' && cb <= 'Z') {
+            cb += 'a' - 'A';
+        }
+        if (ca != cb) {
+            return FALSE;
+        }
+    } while (ca);
+
+    return TRUE;
+}
+
+/* ExAll() match hook: drop #?.info and excluded names inside the filesystem */
+static ULONG __asm MatchDirEntry(register __a0 struct Hook *hook, register __a1 struct ExAllData *ead, register __a2 LONG *type)
+{
+    struct OSDir *dir = (struct OSDir *)hook->h_Data;
+    STRPTR name = (STRPTR)ead->ed_Name;
+    ULONG len;
+    ULONG i;
+
+    for (len = 0; name[len]; len++) {
+    }
+
+    if ((dir->od_Flags & OSDIRF_NOINFO) && len > 5 && NameEquals(name + len - 5, (STRPTR)".info")) {
+        return FALSE;
+    }
+
+    if (dir->od_Exclude) {
+        for (i = 0; dir->od_Exclude[i]; i++) {
+            if (NameEquals(name, dir->od_Exclude[i])) {
+                return FALSE;
+            }
+        }
+    }
+
+    return TRUE;
+}
+
+/* Start reading the entries of a directory */
+/* Entries come from ExAll() a buffer at a time, filtered by flags and exclude */
+struct OSDir *OSOpenDir(STRPTR name, ULONG flags, STRPTR *exclude)
+{
+    struct OSDir *dir;
+
+    dir = (struct OSDir *)OSAllocMem(sizeof(struct OSDir));
+    if (!dir) {
+        return NULL;
+    }
+
+    dir->od_Lock = OSLock(name);
+    if (!dir->od_Lock) {
+        OSFreeMem(dir);
+        return NULL;
+    }
+
+    dir->od_Buffer = (struct ExAllData *)OSAllocMem(OSDIR_BUFFER_SIZE);
+    dir->od_Control = (struct ExAllControl *)AllocDosObject(DOS_EXALLCONTROL, NULL);
+    STAT_ADD(qs_Allocs, 1);
+    if (!dir->od_Buffer || !dir->od_Control) {
+        if (dir->od_Control) {
+            FreeDosObject(DOS_EXALLCONTROL, dir->od_Control);
+        }
+        OSFreeMem(dir->od_Buffer);
+        OSUnLock(dir->od_Lock);
+        OSFreeMem(dir);
+        SetIoErr(ERROR_NO_FREE_STORE);
+        return NULL;
+    }
+
+    dir->od_Flags = flags;
+    dir->od_Exclude = exclude;
+    dir->od_More = TRUE;
+
+    if (flags || exclude) {
+        dir->od_Hook.h_Entry = (ULONG (*)())MatchDirEntry;
+        dir->od_Hook.h_Data = (APTR)dir;
+        dir->od_Control->eac_MatchFunc = &dir->od_Hook;
+    }
+    dir->od_Control->eac_LastKey = 0;
+
+    return dir;
+}
+
+/* Return the next directory entry, or FALSE when there are no more */
+BOOL OSNextDirEntry(struct OSDir *dir, struct OSDirEntry *entry)
+{
+    struct ExAllData *ead;
+
+    if (!dir || !entry) {
+        return FALSE;
+    }
+
+    /* Refill the buffer; a call may return no entries and still have more */
+    while (!dir->od_Next) {
+        if (!dir->od_More) {
+            return FALSE;
+        }
+        dir->od_More = (BOOL)ExAll(dir->od_Lock, dir->od_Buffer, OSDIR_BUFFER_SIZE, ED_DATE, dir->od_Control);
+        STAT_ADD(qs_Reads, 1);
+        if (!dir->od_More && IoErr() != ERROR_NO_MORE_ENTRIES) {
+            return FALSE;
+        }
+        if (dir->od_Control->eac_Entries > 0) {
+            dir->od_Next = dir->od_Buffer;
+        }
+    }
+
+    ead = dir->od_Next;
+    dir->od_Next = ead->ed_Next;
+
+    entry->ode_Name = (STRPTR)ead->ed_Name;
+    entry->ode_Type = ead->ed_Type;
+    entry->ode_Size = ead->ed_Size;
+    entry->ode_Date.ds_Days = (LONG)ead->ed_Days;
+    entry->ode_Date.ds_Minute = (LONG)ead->ed_Mins;
+    entry->ode_Date.ds_Tick = (LONG)ead->ed_Ticks;
+
+    return TRUE;
+}
+
+/* Finish reading a directory */
+VOID OSCloseDir(struct OSDir *dir)
+{
+    if (!dir) {
+        return;
+    }
+
+    /* The filesystem holds state for an ExAll() that was not run to the end */
+    if (dir->od_More && dir->od_Control->eac_LastKey != 0) {
+        ExAllEnd(dir->od_Lock, dir->od_Buffer, OSDIR_BUFFER_SIZE, ED_DATE, dir->od_Control);
+    }
+
+    FreeDosObject(DOS_EXALLCONTROL, dir->od_Control);
+    OSFreeMem(dir->od_Buffer);
+    OSUnLock(dir->od_Lock);
+    OSFreeMem(dir);
+}
+
+/* Start walking a directory tree, depth first */
+/* flags and exclude apply to every directory, as for OSOpenDir() */
+struct OSWalk *OSOpenWalk(STRPTR root, ULONG flags, STRPTR *exclude)
+{
+    struct OSWalk *walk;
+
+    if (!root) {
+        SetIoErr(ERROR_REQUIRED_ARG_MISSING);
+        return NULL;
+    }
+
+    walk = (struct OSWalk *)OSAllocMem(sizeof(struct OSWalk));
+    if (!walk) {
+        SetIoErr(ERROR_NO_FREE_STORE);
+        return NULL;
+    }
+
+    if (strlen(root) >= WALK_PATH_SIZE) {
+        OSFreeMem(walk);
+        SetIoErr(ERROR_LINE_TOO_LONG);
+        return NULL;
+    }
+    strcpy(walk->ow_Path, root);
+
+    walk->ow_Flags = flags;
+    walk->ow_Exclude = exclude;
+    walk->ow_Dir[0] = OSOpenDir(root, flags, exclude);
+    if (!walk->ow_Dir[0]) {
+        OSFreeMem(walk);
+        return NULL;
+    }
+    walk->ow_PathLen[0] = (UWORD)strlen(root);
+    walk->ow_Depth = 1;
+
+    return walk;
+}
+
+/* Return the next entry of the tree, or FALSE when the walk is done */
+/* A directory is returned before its contents; links are not followed */
+BOOL OSNextWalkEntry(struct OSWalk *walk, struct OSWalkEntry *entry)
+{
+    struct OSDirEntry dirEntry;
+    struct OSDir *dir;
+    UWORD level;
+
+    if (!walk || !entry) {
+        return FALSE;
+    }
+
+    while (walk->ow_Depth > 0) {
+        level = walk->ow_Depth - 1;
+
+        if (!OSNextDirEntry(walk->ow_Dir[level], &dirEntry)) {
+            OSCloseDir(walk->ow_Dir[level]);
+            walk->ow_Dir[level] = NULL;
+            walk->ow_Depth--;
+            continue;
+        }
+
+        walk->ow_Path[walk->ow_PathLen[level]] = '\0';
+        if (!AddPart(walk->ow_Path, dirEntry.ode_Name, WALK_PATH_SIZE)) {
+            walk->ow_Skipped++;
+            continue;
+        }
+
+        entry->owe_Path = (STRPTR)walk->ow_Path;
+        entry->owe_Name = FilePart(walk->ow_Path);
+        entry->owe_Type = dirEntry.ode_Type;
+        entry->owe_Size = dirEntry.ode_Size;
+        entry->owe_Date = dirEntry.ode_Date;
+        entry->owe_Depth = level;
+
+        /* Enter real directories only, so linked trees cannot loop */
+        if (dirEntry.ode_Type == ST_USERDIR) {
+            dir = NULL;
+            if (walk->ow_Depth < WALK_MAX_DEPTH) {
+                dir = OSOpenDir(walk->ow_Path, walk->ow_Flags, walk->ow_Exclude);
+            }
+            if (dir) {
+                walk->ow_Dir[walk->ow_Depth] = dir;
+                walk->ow_PathLen[walk->ow_Depth] = (UWORD)strlen(walk->ow_Path);
+                walk->ow_Depth++;
+            } else {
+                walk->ow_Skipped++;
+            }
+        }
+
+        return TRUE;
+    }
+
+    return FALSE;
+}
+
+/* Finish a walk, closing every directory still open */
+VOID OSCloseWalk(struct OSWalk *walk)
+{
+    if (!walk) {
+        return;
+    }
+
+    while (walk->ow_Depth > 0) {
+        walk->ow_Depth--;
+        OSCloseDir(walk->ow_Dir[walk->ow_Depth]);
+    }
+
+    OSFreeMem(walk);
+}
+
+/* Have a message sent to port whenever an entry of a directory, or a */
+/* file, changes. nr must stay where it is until OSEndNotify(). This is */
+/* where a host backend would put inotify or its equivalent. */
+BOOL OSStartNotify(struct NotifyRequest *nr, STRPTR name, struct MsgPort *port, ULONG userData)
+{
+    if (!nr || !name || !port) {
+        SetIoErr(ERROR_REQUIRED_ARG_MISSING);
+        return FALSE;
+    }
+
+    nr->nr_Name = (UBYTE *)name;
+    nr->nr_UserData = userData;
+    /* No second message until the first is replied: a burst of writes */
+    /* to one directory queues one message, not one per write */
+    nr->nr_Flags = NRF_SEND_MESSAGE | NRF_WAIT_REPLY;
+    nr->nr_stuff.nr_Msg.nr_Port = port;
+
+    return (BOOL)(StartNotify(nr) != 0);
+}
+
+/* Stop a notification from OSStartNotify(); messages still queued for it */
+/* are taken off the port by DOS */
+VOID OSEndNotify(struct NotifyRequest *nr)
+{
+    if (nr) {
+        EndNotify(nr);
+    }
+}
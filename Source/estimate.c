@@ -0,0 +1,250 @@
+/*
+ * DataType - decoded size estimates and decode admission
+ *
+ * Copyright (c) 2025 amigazen project
+ * Licensed under BSD 2-Clause License
+ */
+
+#include "datatype.h"
+
+/*
+ * NewDTObject() on a picture far larger than the free memory either
+ * fails halfway through or leaves the system too short of memory to run
+ * anything else. Before decoding, the headers a class would read first
+ * (BMHD, ANHD, VHDR, COMM, PNG's IHDR) give the size of what it will
+ * allocate; other files are judged by their size and group. A file that
+ * would not fit, in MEMLIMIT= bytes or in free memory, is not decoded,
+ * and is reported with whatever its header said ("metadata only").
+ */
+
+/* a * b, held at ~0 rather than wrapping */
+static ULONG MulSat(ULONG a, ULONG b)
+{
+    if (a != 0 && b > 0xFFFFFFFF / a) {
+        return 0xFFFFFFFF;
+    }
+    return a * b;
+}
+
+/* a + b, held at ~0 rather than wrapping */
+static ULONG AddSat(ULONG a, ULONG b)
+{
+    return (a > 0xFFFFFFFF - b) ? 0xFFFFFFFF : a + b;
+}
+
+/* Size of the bitmap a BMHD describes: planes, or 32-bit pixels if deep */
+static VOID EstimateBitMap(UBYTE *bmhd, struct FootprintEstimate *fe)
+{
+    ULONG plane;
+    UWORD depth;
+
+    fe->fe_Width = GetIFFWord(bmhd);
+    fe->fe_Height = GetIFFWord(bmhd + 2);
+    depth = bmhd[8];
+    fe->fe_Depth = depth;
+
+    if (depth > 8) {
+        fe->fe_Total = MulSat(MulSat(fe->fe_Width, fe->fe_Height), 4);
+        fe->fe_Largest = fe->fe_Total;
+        return;
+    }
+
+    /* A mask is one more plane */
+    plane = MulSat(((fe->fe_Width + 15) >> 4) << 1, fe->fe_Height);
+    if (bmhd[9] == mskHasMask) {
+        depth++;
+    }
+    fe->fe_Total = MulSat(plane, depth);
+    fe->fe_Largest = plane;
+}
+
+/* Estimate from an IFF FORM's headers */
+static BOOL EstimateIFF(UBYTE *data, ULONG size, struct FootprintEstimate *fe)
+{
+    struct IFFView view;
+    struct IFFView frame;
+    struct IFFChunk chunk;
+    ULONG buffers = 2;
+
+    if (!InitIFFView(&view, data, size)) {
+        return FALSE;
+    }
+
+    switch (view.iv_Type) {
+        case ID_ILBM:
+            if (!FindIFFChunk(&view, ID_BMHD, &chunk) || chunk.ic_Size < 20) {
+                return FALSE;
+            }
+            EstimateBitMap(chunk.ic_Data, fe);
+            return TRUE;
+
+        case ID_ANIM:
+            /* The first frame is a whole ILBM with the BMHD; a header */
+            /* read may end inside it, which the view allows for */
+            if (!InitIFFView(&frame, data + 12, size - 12) || frame.iv_Type != ID_ILBM ||
+                !FindIFFChunk(&frame, ID_BMHD, &chunk) || chunk.ic_Size < 20) {
+                return FALSE;
+            }
+            EstimateBitMap(chunk.ic_Data, fe);
+
+            /* The next frame's ANHD says whether deltas go to one buffer */
+            /* or alternate between two: its interleave byte, at offset 18, */
+            /* is 1 or 0. It is only there if the whole first frame is */
+            if (NextIFFChunk(&view, &chunk) && FindIFFChunk(&view, ID_FORM, &chunk) &&
+                InitIFFView(&frame, chunk.ic_Data - 8, chunk.ic_Size + 8) &&
+                FindIFFChunk(&frame, ID_ANHD, &chunk) && chunk.ic_Size >= 19) {
+                buffers = (chunk.ic_Data[18] == 1) ? 1 : 2;
+            }
+
+            /* The key frame as well as the display buffers */
+            fe->fe_Total = MulSat(fe->fe_Total, buffers + 1);
+            return TRUE;
+
+        case ID_8SVX:
+            if (!FindIFFChunk(&view, ID_VHDR, &chunk) || chunk.ic_Size < 20) {
+                return FALSE;
+            }
+            {
+                ULONG samples = AddSat(GetIFFLong(chunk.ic_Data), GetIFFLong(chunk.ic_Data + 4));
+                UBYTE octaves = chunk.ic_Data[14];
+
+                /* Each octave holds the sound again at twice the length */
+                fe->fe_SampleLength = samples;
+                fe->fe_SamplesPerSec = GetIFFWord(chunk.ic_Data + 12);
+                fe->fe_Total = (octaves > 1 && octaves <= 8) ? MulSat(samples, (1UL << octaves) - 1) : samples;
+                fe->fe_Largest = fe->fe_Total;
+            }
+            return TRUE;
+
+        case ID_AIFF:
+            if (!FindIFFChunk(&view, ID_COMM, &chunk) || chunk.ic_Size < 18) {
+                return FALSE;
+            }
+            {
+                ULONG channels = GetIFFWord(chunk.ic_Data);
+                ULONG frames = GetIFFLong(chunk.ic_Data + 2);
+                ULONG bytes = (GetIFFWord(chunk.ic_Data + 6) + 7) / 8;
+
+                fe->fe_SampleLength = frames;
+                fe->fe_Total = MulSat(MulSat(channels, frames), bytes);
+                fe->fe_Largest = fe->fe_Total;
+            }
+            return TRUE;
+    }
+
+    return FALSE;
+}
+
+/* Estimate from a PNG's IHDR: 32-bit pixels for true colour, else bytes */
+static BOOL EstimatePNG(UBYTE *data, ULONG size, struct FootprintEstimate *fe)
+{
+    static const UBYTE signature[8] = { 0x89, 'P', 'N', 'G', 0x0D, 0x0A, 0x1A, 0x0A };
+    UBYTE colorType;
+
+    if (size < 26 || memcmp(data, signature, 8) != 0 ||
+        GetIFFLong(data + 12) != MAKE_ID('I','H','D','R')) {
+        return FALSE;
+    }
+
+    fe->fe_Width = GetIFFLong(data + 16);
+    fe->fe_Height = GetIFFLong(data + 20);
+    colorType = data[25];
+    fe->fe_Depth = (colorType == 2 || colorType == 6) ? 24 : data[24];
+
+    /* Palette pictures also get a bitmap of the same size to display */
+    fe->fe_Total = MulSat(MulSat(fe->fe_Width, fe->fe_Height), (fe->fe_Depth > 8) ? 4 : 2);
+    fe->fe_Largest = (fe->fe_Depth > 8) ? fe->fe_Total : fe->fe_Total / 2;
+
+    return TRUE;
+}
+
+/* Predict the memory a decode of the file will take */
+/* Returns FALSE if nothing is known, not even the file's size */
+BOOL EstimateFootprint(struct FileQuery *fq, struct FootprintEstimate *fe)
+{
+    UBYTE *header = fq->fq_Buffer;
+    ULONG size = fq->fq_BufferSize;
+    ULONG ratio;
+
+    memset(fe, 0, sizeof(struct FootprintEstimate));
+
+    /* A file that was not loaded gives up its first bytes */
+    if (!header) {
+        BPTR fh;
+
+        header = (UBYTE *)OSAllocMem(ESTIMATE_HEADER_SIZE);
+        if (header) {
+            fh = OSOpen(fq->fq_Name);
+            if (fh) {
+                LONG got = OSRead(fh, header, ESTIMATE_HEADER_SIZE);
+
+                size = (got > 0) ? (ULONG)got : 0;
+                OSClose(fh);
+            } else {
+                size = 0;
+            }
+        }
+    }
+
+    if (header && (EstimateIFF(header, size, fe) || EstimatePNG(header, size, fe))) {
+        fe->fe_Source = ESTIMATE_HEADER;
+    }
+
+    if (header != fq->fq_Buffer) {
+        OSFreeMem(header);
+    }
+
+    if (fe->fe_Source == ESTIMATE_HEADER) {
+        return TRUE;
+    }
+
+    /* Otherwise by how much each group tends to grow when decoded */
+    if (fq->fq_Info.ofi_Size == 0 || !fq->fq_DataType) {
+        return FALSE;
+    }
+    switch (fq->fq_DataType->dtn_Header->dth_GroupID) {
+        case GID_PICTURE:
+            ratio = ESTIMATE_RATIO_PICTURE;
+            break;
+        case GID_ANIMATION:
+        case GID_MOVIE:
+        case GID_SOUND:
+            ratio = ESTIMATE_RATIO_SOUND;
+            break;
+        default:
+            ratio = ESTIMATE_RATIO_OTHER;
+            break;
+    }
+    fe->fe_Total = MulSat(fq->fq_Info.ofi_Size, ratio);
+    fe->fe_Largest = fe->fe_Total;
+    fe->fe_Source = ESTIMATE_FILESIZE;
+
+    return TRUE;
+}
+
+/* Whether the file may be decoded: its estimate must fit MEMLIMIT=, or */
+/* free memory less ESTIMATE_RESERVE, and its largest part the largest */
+/* free block. Sets fq_MetadataOnly if not. */
+BOOL AdmitDecode(struct FileQuery *fq)
+{
+    struct FootprintEstimate *fe = &fq->fq_Estimate;
+    ULONG limit;
+    ULONG available;
+
+    if (!EstimateFootprint(fq, fe)) {
+        return TRUE;
+    }
+
+    available = AvailMem(MEMF_ANY);
+    limit = (available > ESTIMATE_RESERVE) ? available - ESTIMATE_RESERVE : 0;
+    if (fq->fq_Context && fq->fq_Context->dc_MemLimit && fq->fq_Context->dc_MemLimit < limit) {
+        limit = fq->fq_Context->dc_MemLimit;
+    }
+
+    if (fe->fe_Total > limit || fe->fe_Largest > AvailMem(MEMF_LARGEST)) {
+        fq->fq_MetadataOnly = TRUE;
+        return FALSE;
+    }
+
+    return TRUE;
+}
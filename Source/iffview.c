@@ -0,0 +1,147 @@
+/*
+ * DataType - in-memory IFF chunk reader
+ *
+ * Copyright (c) 2025 amigazen project
+ * Licensed under BSD 2-Clause License
+ */
+
+#include "datatype.h"
+
+/*
+ * Walks the chunks of an IFF FORM that is already in memory. Chunks are
+ * returned as views into the buffer, so nothing is copied. Every size
+ * read from the data is checked against the bytes actually present, so
+ * a truncated or hostile file can never make a view reach outside the
+ * buffer.
+ */
+
+/* Read a big-endian LONG */
+ULONG GetIFFLong(UBYTE *data)
+{
+    return ((ULONG)data[0] << 24) | ((ULONG)data[1] << 16) |
+           ((ULONG)data[2] << 8) | (ULONG)data[3];
+}
+
+/* Read a big-endian WORD */
+UWORD GetIFFWord(UBYTE *data)
+{
+    return (UWORD)(((UWORD)data[0] << 8) | data[1]);
+}
+
+/* Start reading the FORM at the start of buffer */
+/* Returns FALSE if the buffer does not hold a FORM header */
+BOOL InitIFFView(struct IFFView *view, UBYTE *buffer, ULONG size)
+{
+    ULONG formSize;
+
+    if (!view || !buffer || size < 12) {
+        return FALSE;
+    }
+
+    if (GetIFFLong(buffer) != ID_FORM) {
+        return FALSE;
+    }
+
+    formSize = GetIFFLong(buffer + 4);
+    if (formSize < 4) {
+        return FALSE;
+    }
+
+    view->iv_Buffer = buffer;
+    view->iv_Type = GetIFFLong(buffer + 8);
+    view->iv_Pos = 12;
+
+    /* A FORM claiming more than the buffer holds is read up to the end */
+    if (formSize > size - 8) {
+        view->iv_End = size;
+    } else {
+        view->iv_End = formSize + 8;
+    }
+
+    return TRUE;
+}
+
+/* Return the next chunk of the FORM */
+/* Returns FALSE at the end of the FORM or at a chunk that does not fit */
+BOOL NextIFFChunk(struct IFFView *view, struct IFFChunk *chunk)
+{
+    ULONG avail;
+    ULONG chunkSize;
+
+    if (!view || !chunk || view->iv_Pos >= view->iv_End) {
+        return FALSE;
+    }
+
+    avail = view->iv_End - view->iv_Pos;
+    if (avail < 8) {
+        return FALSE;
+    }
+
+    chunkSize = GetIFFLong(view->iv_Buffer + view->iv_Pos + 4);
+    if (chunkSize > avail - 8) {
+        /* Stop here rather than trust a size that runs past the data */
+        view->iv_Pos = view->iv_End;
+        return FALSE;
+    }
+
+    chunk->ic_ID = GetIFFLong(view->iv_Buffer + view->iv_Pos);
+    chunk->ic_Size = chunkSize;
+    chunk->ic_Data = view->iv_Buffer + view->iv_Pos + 8;
+
+    /* Chunks are padded to an even length; the pad byte may be missing at the end */
+    view->iv_Pos += 8 + chunkSize;
+    if ((chunkSize & 1) && view->iv_Pos < view->iv_End) {
+        view->iv_Pos++;
+    }
+
+    return TRUE;
+}
+
+/* Find the first chunk with the given ID from the current position */
+BOOL FindIFFChunk(struct IFFView *view, ULONG id, struct IFFChunk *chunk)
+{
+    while (NextIFFChunk(view, chunk)) {
+        if (chunk->ic_ID == id) {
+            return TRUE;
+        }
+    }
+
+    return FALSE;
+}
+
+/* Unpack size bytes of ByteRun1 data, advancing *src past what was used */
+/* Returns FALSE if the packed data ends early or overruns size */
+BOOL UnpackByteRun1(UBYTE **src, UBYTE *srcEnd, UBYTE *dst, ULONG size)
+{
+    UBYTE *in = *src;
+    ULONG n;
+    BYTE code;
+
+    while (size > 0) {
+        if (in >= srcEnd) {
+            return FALSE;
+        }
+        code = (BYTE)*in++;
+        if (code >= 0) {
+            n = (ULONG)code + 1;
+            if (n > size || (ULONG)(srcEnd - in) < n) {
+                return FALSE;
+            }
+            CopyMem(in, dst, n);
+            in += n;
+        } else if (code != -128) {
+            n = (ULONG)(1 - code);
+            if (n > size || in >= srcEnd) {
+                return FALSE;
+            }
+            memset(dst, *in++, n);
+        } else {
+            continue;
+        }
+        dst += n;
+        size -= n;
+    }
+
+    *src = in;
+    return TRUE;
+}
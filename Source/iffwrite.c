@@ -0,0 +1,626 @@
+/*
+ * DataType - native IFF writers
+ *
+ * Copyright (c) 2025 amigazen project
+ * Licensed under BSD 2-Clause License
+ */
+
+#include "datatype.h"
+
+/*
+ * An IFFWriter streams one FORM to a file through a buffer, so chunks
+ * cost one Write() per IFFWRITE_BUFFER_SIZE bytes rather than one per
+ * call. Chunk and FORM sizes are not known until the data is written;
+ * their size fields are patched in the buffer if still there, otherwise
+ * with a Seek() back into the file.
+ *
+ * WriteILBM() encodes a planar bitmap itself instead of going through
+ * the picture class's DTM_WRITE, packing BODY rows with ByteRun1.
+ * An SVXWriter takes samples a block at a time, so a sound can be
+ * written, and optionally delta-coded, with a fixed amount of memory.
+ * An AIFFWriter does the same for 16-bit sounds, which 8SVX cannot hold.
+ */
+
+/* Store a big-endian LONG */
+VOID PutIFFLong(UBYTE *data, ULONG value)
+{
+    data[0] = (UBYTE)(value >> 24);
+    data[1] = (UBYTE)(value >> 16);
+    data[2] = (UBYTE)(value >> 8);
+    data[3] = (UBYTE)value;
+}
+
+/* Store a big-endian WORD */
+VOID PutIFFWord(UBYTE *data, UWORD value)
+{
+    data[0] = (UBYTE)(value >> 8);
+    data[1] = (UBYTE)value;
+}
+
+/* Write the buffered bytes to the file */
+static BOOL FlushIFFWriter(struct IFFWriter *iw)
+{
+    if (iw->iw_Used > 0 && !iw->iw_Error) {
+        if (OSWrite(iw->iw_File, iw->iw_Buffer, (LONG)iw->iw_Used) != (LONG)iw->iw_Used) {
+            iw->iw_Error = IoErr() ? IoErr() : ERROR_DISK_FULL;
+        }
+    }
+    iw->iw_Flushed += iw->iw_Used;
+    iw->iw_Used = 0;
+
+    return (BOOL)!iw->iw_Error;
+}
+
+/* Overwrite a size field already written at offset */
+static VOID PatchIFFLong(struct IFFWriter *iw, ULONG offset, ULONG value)
+{
+    UBYTE data[4];
+
+    if (iw->iw_Error) {
+        return;
+    }
+
+    /* Still in the buffer: no I/O needed */
+    if (offset >= iw->iw_Flushed) {
+        PutIFFLong(iw->iw_Buffer + (offset - iw->iw_Flushed), value);
+        return;
+    }
+
+    if (!FlushIFFWriter(iw)) {
+        return;
+    }
+    PutIFFLong(data, value);
+    if (!OSSeek(iw->iw_File, (LONG)offset) ||
+        OSWrite(iw->iw_File, data, 4) != 4 ||
+        !OSSeek(iw->iw_File, (LONG)iw->iw_Flushed)) {
+        iw->iw_Error = IoErr() ? IoErr() : ERROR_SEEK_ERROR;
+    }
+}
+
+/* Create a file and start a FORM of the given type in it */
+BOOL OpenIFFWriter(struct IFFWriter *iw, STRPTR name, ULONG formType)
+{
+    UBYTE header[12];
+
+    if (!iw || !name) {
+        SetIoErr(ERROR_REQUIRED_ARG_MISSING);
+        return FALSE;
+    }
+
+    memset(iw, 0, sizeof(struct IFFWriter));
+    iw->iw_Name = name;
+
+    iw->iw_Buffer = (UBYTE *)OSAllocMem(IFFWRITE_BUFFER_SIZE + TEMP_NAME_SIZE);
+    if (!iw->iw_Buffer) {
+        SetIoErr(ERROR_NO_FREE_STORE);
+        return FALSE;
+    }
+    iw->iw_TempName = iw->iw_Buffer + IFFWRITE_BUFFER_SIZE;
+
+    /* Written under a temporary name, so an existing file survives a failure */
+    iw->iw_File = OSCreateTemp(name, iw->iw_TempName, TEMP_NAME_SIZE, 0);
+    if (!iw->iw_File) {
+        OSFreeMem(iw->iw_Buffer);
+        iw->iw_Buffer = NULL;
+        return FALSE;
+    }
+
+    PutIFFLong(header, ID_FORM);
+    PutIFFLong(header + 4, 0);
+    PutIFFLong(header + 8, formType);
+    WriteIFFData(iw, header, 12);
+
+    return TRUE;
+}
+
+/* Append bytes to the open chunk */
+VOID WriteIFFData(struct IFFWriter *iw, APTR data, ULONG size)
+{
+    UBYTE *src = (UBYTE *)data;
+    ULONG part;
+
+    while (size > 0 && !iw->iw_Error) {
+        if (iw->iw_Used == IFFWRITE_BUFFER_SIZE && !FlushIFFWriter(iw)) {
+            return;
+        }
+
+        /* Large blocks bypass the buffer once it is empty */
+        if (iw->iw_Used == 0 && size >= IFFWRITE_BUFFER_SIZE) {
+            if (OSWrite(iw->iw_File, src, (LONG)size) != (LONG)size) {
+                iw->iw_Error = IoErr() ? IoErr() : ERROR_DISK_FULL;
+                return;
+            }
+            iw->iw_Flushed += size;
+            return;
+        }
+
+        part = IFFWRITE_BUFFER_SIZE - iw->iw_Used;
+        if (part > size) {
+            part = size;
+        }
+        CopyMem(src, iw->iw_Buffer + iw->iw_Used, part);
+        iw->iw_Used += part;
+        src += part;
+        size -= part;
+    }
+}
+
+/* Start a chunk; its size is filled in by EndIFFChunk() */
+VOID BeginIFFChunk(struct IFFWriter *iw, ULONG id)
+{
+    UBYTE header[8];
+
+    iw->iw_ChunkStart = iw->iw_Flushed + iw->iw_Used;
+    PutIFFLong(header, id);
+    PutIFFLong(header + 4, 0);
+    WriteIFFData(iw, header, 8);
+}
+
+/* Finish the open chunk, padding it to an even length */
+VOID EndIFFChunk(struct IFFWriter *iw)
+{
+    ULONG end = iw->iw_Flushed + iw->iw_Used;
+    ULONG size = end - iw->iw_ChunkStart - 8;
+    UBYTE pad = 0;
+
+    PatchIFFLong(iw, iw->iw_ChunkStart + 4, size);
+    if (size & 1) {
+        WriteIFFData(iw, &pad, 1);
+    }
+}
+
+/* Finish the FORM, close the file and rename it to the name asked for */
+/* On failure the partial file is deleted, any file that was there before */
+/* is left alone, and IoErr() says why */
+BOOL CloseIFFWriter(struct IFFWriter *iw)
+{
+    LONG error;
+    BOOL result = TRUE;
+
+    if (!iw || !iw->iw_File) {
+        return FALSE;
+    }
+
+    PatchIFFLong(iw, 4, iw->iw_Flushed + iw->iw_Used - 8);
+    FlushIFFWriter(iw);
+
+    error = iw->iw_Error;
+    if (!OSClose(iw->iw_File) && !error) {
+        error = IoErr() ? IoErr() : ERROR_DISK_FULL;
+    }
+    iw->iw_File = NULL;
+
+    if (error) {
+        OSDelete((STRPTR)iw->iw_TempName);
+        SetIoErr(error);
+        result = FALSE;
+    } else {
+        result = OSCommitTemp((STRPTR)iw->iw_TempName, iw->iw_Name);
+    }
+
+    /* The temporary name lives in the buffer */
+    OSFreeMem(iw->iw_Buffer);
+    iw->iw_Buffer = NULL;
+    iw->iw_TempName = NULL;
+
+    return result;
+}
+
+/* Append a literal run of 1 to 128 bytes */
+static UBYTE *PutLiteral(UBYTE *dst, UBYTE *src, ULONG count)
+{
+    ULONG n;
+
+    while (count > 0) {
+        n = (count > 128) ? 128 : count;
+        *dst++ = (UBYTE)(n - 1);
+        CopyMem(src, dst, n);
+        dst += n;
+        src += n;
+        count -= n;
+    }
+
+    return dst;
+}
+
+/* Append a repeat run of count copies of value */
+static UBYTE *PutRepeat(UBYTE *dst, UBYTE value, ULONG count)
+{
+    ULONG n;
+
+    while (count > 0) {
+        n = (count > 128) ? 128 : count;
+        if (n == 1) {
+            *dst++ = 0;
+        } else {
+            *dst++ = (UBYTE)(257 - n);
+        }
+        *dst++ = value;
+        count -= n;
+    }
+
+    return dst;
+}
+
+/* Pack bytes with ByteRun1; dst needs PACKED_SIZE(size) bytes */
+/* Returns the packed length */
+ULONG PackByteRun1(UBYTE *src, ULONG size, UBYTE *dst)
+{
+    UBYTE *out = dst;
+    ULONG literal = 0;
+    ULONG i;
+
+    /*
+     * Every run of three or more bytes covers a whole aligned word whose
+     * two bytes are equal. So candidates are found by reading aligned
+     * words rather than bytes, and runs are extended a word at a time.
+     * Pairs are left inside literals, where they cost nothing extra.
+     */
+    i = (ULONG)src & 1;
+    while (i + 1 < size) {
+        UWORD word = *(UWORD *)(src + i);
+        UBYTE value = (UBYTE)word;
+        ULONG start;
+        ULONG end;
+
+        if ((UBYTE)(word >> 8) != value) {
+            i += 2;
+            continue;
+        }
+
+        start = i;
+        if (start > literal && src[start - 1] == value) {
+            start--;
+        }
+        end = i + 2;
+        while (end + 1 < size && *(UWORD *)(src + end) == word) {
+            end += 2;
+        }
+        if (end < size && src[end] == value) {
+            end++;
+        }
+
+        if (end - start < 3) {
+            i += 2;
+            continue;
+        }
+
+        out = PutLiteral(out, src + literal, start - literal);
+        out = PutRepeat(out, value, end - start);
+        literal = end;
+
+        /* Carry on at the first aligned word not inside the run */
+        i = end + ((end ^ (ULONG)src) & 1);
+    }
+
+    out = PutLiteral(out, src + literal, size - literal);
+
+    return (ULONG)(out - dst);
+}
+
+/* Write a planar bitmap as an ILBM with a ByteRun1 BODY */
+/* Fails with ERROR_NOT_IMPLEMENTED for bitmaps it cannot read plane by plane */
+BOOL WriteILBM(STRPTR outputFile, struct BitMapHeader *bmh, struct BitMap *bm,
+               struct ColorRegister *colors, ULONG numColors, ULONG modeID)
+{
+    struct IFFWriter iw;
+    UBYTE header[20];
+    UBYTE *packed;
+    ULONG rowBytes;
+    ULONG y;
+    UWORD plane;
+    UWORD depth;
+
+    if (!outputFile || !bmh || !bm) {
+        SetIoErr(ERROR_REQUIRED_ARG_MISSING);
+        return FALSE;
+    }
+
+    /* Deep and RTG bitmaps have no planes to read */
+    depth = bmh->bmh_Depth;
+    rowBytes = ((bmh->bmh_Width + 15) >> 4) << 1;
+    if (depth == 0 || depth > 8 ||
+        !(GetBitMapAttr(bm, BMA_FLAGS) & BMF_STANDARD) ||
+        bm->Depth < depth || bm->Rows < bmh->bmh_Height || bm->BytesPerRow < rowBytes) {
+        SetIoErr(ERROR_NOT_IMPLEMENTED);
+        return FALSE;
+    }
+
+    packed = (UBYTE *)OSAllocMem(PACKED_SIZE(rowBytes));
+    if (!packed) {
+        SetIoErr(ERROR_NO_FREE_STORE);
+        return FALSE;
+    }
+
+    if (!OpenIFFWriter(&iw, outputFile, ID_ILBM)) {
+        OSFreeMem(packed);
+        return FALSE;
+    }
+
+    /* A mask plane is not written, so do not claim one */
+    PutIFFWord(header, bmh->bmh_Width);
+    PutIFFWord(header + 2, bmh->bmh_Height);
+    PutIFFWord(header + 4, (UWORD)bmh->bmh_Left);
+    PutIFFWord(header + 6, (UWORD)bmh->bmh_Top);
+    header[8] = (UBYTE)depth;
+    header[9] = (bmh->bmh_Masking == mskHasMask) ? mskNone : bmh->bmh_Masking;
+    header[10] = cmpByteRun1;
+    header[11] = 0;
+    PutIFFWord(header + 12, bmh->bmh_Transparent);
+    header[14] = bmh->bmh_XAspect;
+    header[15] = bmh->bmh_YAspect;
+    PutIFFWord(header + 16, (UWORD)bmh->bmh_PageWidth);
+    PutIFFWord(header + 18, (UWORD)bmh->bmh_PageHeight);
+    BeginIFFChunk(&iw, ID_BMHD);
+    WriteIFFData(&iw, header, 20);
+    EndIFFChunk(&iw);
+
+    if (colors && numColors > 0) {
+        BeginIFFChunk(&iw, ID_CMAP);
+        WriteIFFData(&iw, colors, numColors * sizeof(struct ColorRegister));
+        EndIFFChunk(&iw);
+    }
+
+    if (modeID != INVALID_ID) {
+        PutIFFLong(header, modeID);
+        BeginIFFChunk(&iw, ID_CAMG);
+        WriteIFFData(&iw, header, 4);
+        EndIFFChunk(&iw);
+    }
+
+    /* Rows are interleaved plane by plane, each packed on its own */
+    BeginIFFChunk(&iw, ID_BODY);
+    for (y = 0; y < bmh->bmh_Height && !iw.iw_Error; y++) {
+        for (plane = 0; plane < depth; plane++) {
+            UBYTE *row = (UBYTE *)bm->Planes[plane] + y * bm->BytesPerRow;
+
+            WriteIFFData(&iw, packed, PackByteRun1(row, rowBytes, packed));
+        }
+    }
+    EndIFFChunk(&iw);
+
+    OSFreeMem(packed);
+
+    return CloseIFFWriter(&iw);
+}
+
+/* Write a picture object's bitmap and palette as an ILBM */
+BOOL WritePictureILBM(Object *dtObject, STRPTR outputFile)
+{
+    struct BitMapHeader *bmh = NULL;
+    struct BitMap *bm = NULL;
+    struct ColorRegister *colors = NULL;
+    ULONG numColors = 0;
+    ULONG modeID = INVALID_ID;
+
+    if (!dtObject || !outputFile) {
+        SetIoErr(ERROR_REQUIRED_ARG_MISSING);
+        return FALSE;
+    }
+
+    if (GetDTAttrs(dtObject,
+                   PDTA_BitMapHeader, (ULONG)&bmh,
+                   PDTA_BitMap, (ULONG)&bm,
+                   PDTA_ColorRegisters, (ULONG)&colors,
+                   PDTA_NumColors, (ULONG)&numColors,
+                   PDTA_ModeID, (ULONG)&modeID,
+                   TAG_DONE) < 2 || !bmh || !bm) {
+        SetIoErr(ERROR_NOT_IMPLEMENTED);
+        return FALSE;
+    }
+
+    return WriteILBM(outputFile, bmh, bm, colors, numColors, modeID);
+}
+
+/* Step sizes of the 8SVX Fibonacci-delta code */
+static const BYTE fibDeltas[16] = {
+    -34, -21, -13, -8, -5, -3, -2, -1, 0, 1, 2, 3, 5, 8, 13, 21
+};
+
+/* Emit one compressed byte once both nibbles are known */
+static VOID PutDeltaCode(struct SVXWriter *sw, UBYTE code)
+{
+    if (!sw->sw_HaveNibble) {
+        sw->sw_Nibble = (UBYTE)(code << 4);
+        sw->sw_HaveNibble = TRUE;
+        return;
+    }
+
+    sw->sw_Block[sw->sw_BlockUsed++] = (UBYTE)(sw->sw_Nibble | code);
+    sw->sw_HaveNibble = FALSE;
+    if (sw->sw_BlockUsed == SVX_BLOCK_SIZE) {
+        WriteIFFData(&sw->sw_IFF, sw->sw_Block, SVX_BLOCK_SIZE);
+        sw->sw_BlockUsed = 0;
+    }
+}
+
+/* Start an 8SVX FORM; samples are then added with WriteSVXSamples() */
+/* compress selects Fibonacci-delta coding, which halves the BODY */
+BOOL OpenSVXWriter(struct SVXWriter *sw, STRPTR name, ULONG samplesPerSec, ULONG volume, BOOL compress)
+{
+    UBYTE header[20];
+    LONG diff;
+    UBYTE code;
+
+    if (!sw || !name) {
+        SetIoErr(ERROR_REQUIRED_ARG_MISSING);
+        return FALSE;
+    }
+
+    memset(sw, 0, sizeof(struct SVXWriter));
+    sw->sw_Compress = compress;
+
+    if (compress) {
+        sw->sw_Block = (UBYTE *)OSAllocMem(SVX_BLOCK_SIZE);
+        if (!sw->sw_Block) {
+            SetIoErr(ERROR_NO_FREE_STORE);
+            return FALSE;
+        }
+
+        /* Nearest step for every difference; the steps only grow, so */
+        /* one pass over the differences finds each in turn */
+        code = 0;
+        for (diff = -255; diff <= 255; diff++) {
+            while (code < 15 && fibDeltas[code + 1] - diff <= diff - fibDeltas[code]) {
+                code++;
+            }
+            sw->sw_Codes[diff + 255] = code;
+        }
+    }
+
+    if (!OpenIFFWriter(&sw->sw_IFF, name, ID_8SVX)) {
+        OSFreeMem(sw->sw_Block);
+        sw->sw_Block = NULL;
+        return FALSE;
+    }
+
+    /* One-shot sound; the sample count is filled in when closing */
+    PutIFFLong(header, 0);
+    PutIFFLong(header + 4, 0);
+    PutIFFLong(header + 8, 0);
+    PutIFFWord(header + 12, (UWORD)samplesPerSec);
+    header[14] = 1;
+    header[15] = compress ? CMP_FIBDELTA : CMP_NONE;
+    PutIFFLong(header + 16, (volume >= 64) ? 0x10000 : volume << 10);
+    BeginIFFChunk(&sw->sw_IFF, ID_VHDR);
+    sw->sw_CountOffset = sw->sw_IFF.iw_Flushed + sw->sw_IFF.iw_Used;
+    WriteIFFData(&sw->sw_IFF, header, 20);
+    EndIFFChunk(&sw->sw_IFF);
+
+    BeginIFFChunk(&sw->sw_IFF, ID_BODY);
+
+    return TRUE;
+}
+
+/* Add signed 8-bit samples to the BODY */
+VOID WriteSVXSamples(struct SVXWriter *sw, BYTE *samples, ULONG count)
+{
+    ULONG i;
+
+    if (!sw->sw_Compress) {
+        WriteIFFData(&sw->sw_IFF, samples, count);
+        sw->sw_Samples += count;
+        return;
+    }
+
+    /* The BODY opens with a pad byte and the starting value */
+    if (sw->sw_Samples == 0 && count > 0) {
+        sw->sw_Value = samples[0];
+        sw->sw_Block[0] = 0;
+        sw->sw_Block[1] = (UBYTE)sw->sw_Value;
+        sw->sw_BlockUsed = 2;
+    }
+
+    for (i = 0; i < count; i++) {
+        LONG target = samples[i];
+        LONG value;
+        UBYTE code;
+
+        code = sw->sw_Codes[target - sw->sw_Value + 255];
+        value = sw->sw_Value + fibDeltas[code];
+
+        /* The decoder wraps a byte, so never step past either end */
+        while (value > 127) {
+            value = sw->sw_Value + fibDeltas[--code];
+        }
+        while (value < -128) {
+            value = sw->sw_Value + fibDeltas[++code];
+        }
+
+        sw->sw_Value = value;
+        PutDeltaCode(sw, code);
+    }
+
+    sw->sw_Samples += count;
+}
+
+/* Finish the BODY, record the sample count and close the file */
+BOOL CloseSVXWriter(struct SVXWriter *sw)
+{
+    if (!sw) {
+        return FALSE;
+    }
+
+    if (sw->sw_Compress) {
+        /* An odd count leaves a nibble; pad with a zero step */
+        if (sw->sw_HaveNibble) {
+            PutDeltaCode(sw, 8);
+        }
+        WriteIFFData(&sw->sw_IFF, sw->sw_Block, sw->sw_BlockUsed);
+        OSFreeMem(sw->sw_Block);
+        sw->sw_Block = NULL;
+    }
+
+    EndIFFChunk(&sw->sw_IFF);
+    PatchIFFLong(&sw->sw_IFF, sw->sw_CountOffset, sw->sw_Samples);
+
+    return CloseIFFWriter(&sw->sw_IFF);
+}
+
+/* Start a 16-bit mono AIFF; samples are then added with WriteAIFFSamples() */
+BOOL OpenAIFFWriter(struct AIFFWriter *aw, STRPTR name, ULONG samplesPerSec)
+{
+    UBYTE header[18];
+    UWORD exponent = 0;
+    ULONG mantissa = samplesPerSec;
+
+    if (!aw || !name) {
+        SetIoErr(ERROR_REQUIRED_ARG_MISSING);
+        return FALSE;
+    }
+
+    memset(aw, 0, sizeof(struct AIFFWriter));
+
+    if (!OpenIFFWriter(&aw->aw_IFF, name, ID_AIFF)) {
+        return FALSE;
+    }
+
+    /* The rate is an 80-bit extended float: normalise it by shifting */
+    if (mantissa) {
+        exponent = 16383 + 31;
+        while (!(mantissa & 0x80000000)) {
+            mantissa <<= 1;
+            exponent--;
+        }
+    }
+
+    /* One channel; the frame count is filled in when closing */
+    PutIFFWord(header, 1);
+    PutIFFLong(header + 2, 0);
+    PutIFFWord(header + 6, 16);
+    PutIFFWord(header + 8, exponent);
+    PutIFFLong(header + 10, mantissa);
+    PutIFFLong(header + 14, 0);
+    BeginIFFChunk(&aw->aw_IFF, ID_COMM);
+    aw->aw_CountOffset = aw->aw_IFF.iw_Flushed + aw->aw_IFF.iw_Used + 2;
+    WriteIFFData(&aw->aw_IFF, header, 18);
+    EndIFFChunk(&aw->aw_IFF);
+
+    /* No offset or block alignment */
+    PutIFFLong(header, 0);
+    PutIFFLong(header + 4, 0);
+    BeginIFFChunk(&aw->aw_IFF, ID_SSND);
+    WriteIFFData(&aw->aw_IFF, header, 8);
+
+    return TRUE;
+}
+
+/* Add signed 16-bit samples, which the 68000 already holds big-endian */
+VOID WriteAIFFSamples(struct AIFFWriter *aw, WORD *samples, ULONG count)
+{
+    WriteIFFData(&aw->aw_IFF, samples, count * sizeof(WORD));
+    aw->aw_Frames += count;
+}
+
+/* Finish the SSND, record the frame count and close the file */
+BOOL CloseAIFFWriter(struct AIFFWriter *aw)
+{
+    if (!aw) {
+        return FALSE;
+    }
+
+    EndIFFChunk(&aw->aw_IFF);
+    PatchIFFLong(&aw->aw_IFF, aw->aw_CountOffset, aw->aw_Frames);
+
+    return CloseIFFWriter(&aw->aw_IFF);
+}
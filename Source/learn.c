@@ -0,0 +1,628 @@
+/*
+ * DataType - learned descriptor order and native pre-identification
+ *
+ * Copyright (c) 2025 amigazen project
+ * Licensed under BSD 2-Clause License
+ */
+
+#include "datatype.h"
+
+/*
+ * ObtainDataTypeA() tests descriptors in registry order, so a file of
+ * the most common kind may be compared against dozens of masks first.
+ * The context keeps every installed descriptor as a candidate with a
+ * hit counter, persisted in HITS_FILE. A loaded file is matched against
+ * the candidates' masks, most frequent first, and datatypes.library is
+ * only asked on a miss.
+ *
+ * Only descriptors the library would decide by mask alone take part: no
+ * identification function, a mask no other descriptor's mask could also
+ * match, and no earlier descriptor of the same kind that matches by name
+ * or function alone. Anything else, text types included, is left to
+ * ObtainDataTypeA(), so the answer is always the one the library gives.
+ *
+ * Building the candidates walks the whole registry, which a run of one
+ * file would never earn back. Until a context has identified
+ * HITS_LEARN_AFTER files, hits are only noted by BaseName, and
+ * HITS_FILE is rewritten only when the order changes or every
+ * HITS_SAVE_EVERY hits.
+ *
+ * FAST trusts file names instead. Every extension a descriptor's pattern
+ * names ("#?.iff", "#?.(jpg|jpeg)"), and its BaseName, is put in a table
+ * sorted by extension. A file's extension is looked up there and only
+ * the descriptors found are checked, each by its mask alone; the library
+ * is asked only if none matches. A file whose extension lies about a
+ * type with the same mask can then be identified differently than the
+ * library would, which is why FAST has to be asked for.
+ */
+
+/* Whether two masks can both match the same bytes */
+static BOOL MasksOverlap(struct DataTypeHeader *a, struct DataTypeHeader *b)
+{
+    WORD len = (a->dth_MaskLen < b->dth_MaskLen) ? a->dth_MaskLen : b->dth_MaskLen;
+    WORD i;
+
+    for (i = 0; i < len; i++) {
+        WORD ca = a->dth_Mask[i];
+        WORD cb = b->dth_Mask[i];
+
+        if (ca == -1 || cb == -1) {
+            continue;
+        }
+        if (ToUpper((ULONG)(UBYTE)ca) != ToUpper((ULONG)(UBYTE)cb)) {
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+/* Whether a file's first bytes match a descriptor's mask */
+static BOOL MaskMatches(struct DataTypeHeader *dth, UBYTE *data, ULONG size)
+{
+    WORD i;
+
+    if ((ULONG)dth->dth_MaskLen > size) {
+        return FALSE;
+    }
+
+    for (i = 0; i < dth->dth_MaskLen; i++) {
+        WORD c = dth->dth_Mask[i];
+
+        if (c == -1) {
+            continue;
+        }
+        if (dth->dth_Flags & DTF_CASE) {
+            if ((UBYTE)c != data[i]) {
+                return FALSE;
+            }
+        } else if (ToUpper((ULONG)(UBYTE)c) != ToUpper((ULONG)data[i])) {
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+/* Add an extension to the table, or just count it if table is NULL */
+static ULONG AddExtension(struct ExtensionEntry *table, ULONG count, UBYTE *ext, ULONG length,
+                          struct DataType *dtn, ULONG rank)
+{
+    if (length == 0 || length >= EXTENSION_SIZE) {
+        return count;
+    }
+
+    if (table) {
+        CopyMem(ext, table[count].ee_Extension, length);
+        table[count].ee_Extension[length] = '\0';
+        table[count].ee_DataType = dtn;
+        table[count].ee_Rank = rank;
+    }
+
+    return count + 1;
+}
+
+/* Whether c may be part of an extension taken from a pattern */
+static BOOL IsExtensionChar(UBYTE c)
+{
+    return (BOOL)((c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_');
+}
+
+/* Add the extensions a name pattern names: "#?.a", "#?.(a|b)", "#?.a|#?.b" */
+/* Anything with wildcards after the dot is passed over */
+static ULONG AddPatternExtensions(struct ExtensionEntry *table, ULONG count, STRPTR pattern,
+                                  struct DataType *dtn, ULONG rank)
+{
+    UBYTE *p = (UBYTE *)pattern;
+    UBYTE *word;
+    BOOL group;
+
+    while ((p = (UBYTE *)strchr((char *)p, '.')) != NULL) {
+        p++;
+        group = (BOOL)(*p == '(');
+        if (group) {
+            p++;
+        }
+
+        for (;;) {
+            for (word = p; IsExtensionChar(*p); p++) {
+            }
+            if (*p != '\0' && *p != '|' && *p != ')') {
+                break;
+            }
+            count = AddExtension(table, count, word, (ULONG)(p - word), dtn, rank);
+            if (!group || *p != '|') {
+                break;
+            }
+            p++;
+        }
+    }
+
+    return count;
+}
+
+/* Sort extensions alphabetically, registry order breaking ties */
+static int CompareExtensions(const void *pa, const void *pb)
+{
+    const struct ExtensionEntry *a = (const struct ExtensionEntry *)pa;
+    const struct ExtensionEntry *b = (const struct ExtensionEntry *)pb;
+    LONG order = Stricmp((STRPTR)a->ee_Extension, (STRPTR)b->ee_Extension);
+
+    if (order != 0) {
+        return (int)order;
+    }
+    return (a->ee_Rank < b->ee_Rank) ? -1 : (a->ee_Rank > b->ee_Rank) ? 1 : 0;
+}
+
+/* Sort candidates by hits, registry order breaking ties */
+static int CompareCandidates(const void *pa, const void *pb)
+{
+    const struct Candidate *a = (const struct Candidate *)pa;
+    const struct Candidate *b = (const struct Candidate *)pb;
+
+    if (a->cd_Hits != b->cd_Hits) {
+        return (a->cd_Hits > b->cd_Hits) ? -1 : 1;
+    }
+    return (a->cd_Rank < b->cd_Rank) ? -1 : (a->cd_Rank > b->cd_Rank) ? 1 : 0;
+}
+
+/* Read the persisted hit counters: one "hits BaseName" line per descriptor */
+static VOID LoadHits(struct DTContext *ctx)
+{
+    UBYTE *buffer;
+    UBYTE *line;
+    UBYTE *next;
+    ULONG size;
+    LONG hits;
+    LONG used;
+    ULONG i;
+
+    buffer = OSLoadFile((STRPTR)HITS_FILE, HITS_MAX_SIZE, &size);
+    if (!buffer) {
+        return;
+    }
+
+    for (line = buffer; *line; line = next) {
+        for (next = line; *next && *next != '\n'; next++) {
+        }
+        if (*next) {
+            *next++ = '\0';
+        }
+
+        used = StrToLong(line, &hits);
+        if (used <= 0 || hits <= 0) {
+            continue;
+        }
+        line += used;
+        while (*line == ' ') {
+            line++;
+        }
+
+        for (i = 0; i < ctx->dc_CandidateCount; i++) {
+            STRPTR baseName = ctx->dc_Candidates[i].cd_DataType->dtn_Header->dth_BaseName;
+            if (baseName && Stricmp(baseName, line) == 0) {
+                ctx->dc_Candidates[i].cd_Hits = (ULONG)hits;
+                break;
+            }
+        }
+    }
+
+    OSFreeMem(buffer);
+}
+
+/* Write the hit counters back if the order has changed */
+/* They go to a temporary file renamed over HITS_FILE, so a failed write */
+/* keeps the old counters and leaves them to be saved another time */
+VOID SaveHits(struct DTContext *ctx)
+{
+    UBYTE tempName[TEMP_NAME_SIZE];
+    BOOL result = FALSE;
+    BPTR fh;
+    ULONG i;
+
+    /* Rewritten when the order changed, or after HITS_SAVE_EVERY hits */
+    if (!ctx || (!ctx->dc_HitsDirty && ctx->dc_HitsUnsaved < HITS_SAVE_EVERY)) {
+        return;
+    }
+
+    /* ENVARC:DataType may not exist yet */
+    if (!OSCreateDir((STRPTR)HITS_DIR)) {
+        return;
+    }
+
+    fh = OSCreateTemp((STRPTR)HITS_FILE, tempName, sizeof(tempName), 0);
+    if (!fh) {
+        return;
+    }
+
+    for (i = 0; i < ctx->dc_CandidateCount; i++) {
+        struct Candidate *cd = &ctx->dc_Candidates[i];
+
+        if (cd->cd_Hits > 0 && cd->cd_DataType->dtn_Header->dth_BaseName) {
+            FPrintf(fh, "%lu %s\n", cd->cd_Hits, cd->cd_DataType->dtn_Header->dth_BaseName);
+        }
+    }
+
+    if (OSClose(fh)) {
+        result = OSCommitTemp((STRPTR)tempName, (STRPTR)HITS_FILE);
+    }
+    if (result) {
+        ctx->dc_HitsDirty = FALSE;
+        ctx->dc_HitsUnsaved = 0;
+    } else {
+        OSDelete((STRPTR)tempName);
+    }
+}
+
+/* The candidate for a descriptor, by header or BaseName, or -1 */
+static LONG FindCandidate(struct DTContext *ctx, struct DataTypeHeader *dth, STRPTR baseName)
+{
+    ULONG i;
+
+    for (i = 0; i < ctx->dc_CandidateCount; i++) {
+        struct DataTypeHeader *other = ctx->dc_Candidates[i].cd_DataType->dtn_Header;
+
+        if (other == dth || (baseName && other->dth_BaseName && Stricmp(baseName, other->dth_BaseName) == 0)) {
+            return (LONG)i;
+        }
+    }
+
+    return -1;
+}
+
+/* Add hits to a candidate and move it up the order */
+/* Only a change of order marks the counters to be saved at once */
+static VOID CountHit(struct DTContext *ctx, ULONG i, ULONG hits)
+{
+    struct Candidate swap;
+
+    ctx->dc_Candidates[i].cd_Hits += hits;
+    ctx->dc_HitsUnsaved += hits;
+
+    while (i > 0 && ctx->dc_Candidates[i - 1].cd_Hits < ctx->dc_Candidates[i].cd_Hits) {
+        swap = ctx->dc_Candidates[i - 1];
+        ctx->dc_Candidates[i - 1] = ctx->dc_Candidates[i];
+        ctx->dc_Candidates[i] = swap;
+        ctx->dc_HitsDirty = TRUE;
+        i--;
+    }
+}
+
+/* Obtain every installed descriptor and load the learned order */
+static BOOL BuildCandidates(struct DTContext *ctx)
+{
+    struct DataType *dtn = NULL;
+    struct TagItem tags[2];
+    ULONG count = 0;
+    ULONG i;
+    ULONG j;
+
+    /* Count first, so the array is allocated once */
+    tags[0].ti_Tag = DTA_DataType;
+    tags[1].ti_Tag = TAG_DONE;
+    for (;;) {
+        struct DataType *next;
+
+        tags[0].ti_Data = (ULONG)dtn;
+        next = ObtainDataTypeA(DTST_RAM, NULL, tags);
+        if (dtn) {
+            ReleaseDataType(dtn);
+        }
+        if (!next) {
+            break;
+        }
+        dtn = next;
+        count++;
+    }
+
+    if (count == 0) {
+        return FALSE;
+    }
+
+    ctx->dc_Candidates = (struct Candidate *)OSAllocMem(sizeof(struct Candidate) * count);
+    if (!ctx->dc_Candidates) {
+        return FALSE;
+    }
+
+    dtn = NULL;
+    while (ctx->dc_CandidateCount < count) {
+        tags[0].ti_Data = (ULONG)dtn;
+        dtn = ObtainDataTypeA(DTST_RAM, NULL, tags);
+        if (!dtn) {
+            break;
+        }
+        /* The candidate keeps this reference; the next call takes another */
+        ctx->dc_Candidates[ctx->dc_CandidateCount].cd_DataType = dtn;
+        ctx->dc_Candidates[ctx->dc_CandidateCount].cd_Rank = ctx->dc_CandidateCount;
+        ctx->dc_CandidateCount++;
+    }
+
+    /* Decide which descriptors can be matched without the library */
+    for (i = 0; i < ctx->dc_CandidateCount; i++) {
+        struct DataTypeHeader *dth = ctx->dc_Candidates[i].cd_DataType->dtn_Header;
+        BOOL usable;
+
+        usable = (BOOL)(dth->dth_MaskLen > 0 && dth->dth_Mask &&
+                        !ctx->dc_Candidates[i].cd_DataType->dtn_FunctionName &&
+                        dth->dth_GroupID != GID_SYSTEM);
+
+        for (j = 0; usable && j < ctx->dc_CandidateCount; j++) {
+            struct DataType *otherDtn = ctx->dc_Candidates[j].cd_DataType;
+            struct DataTypeHeader *other = otherDtn->dtn_Header;
+
+            if (j == i) {
+                continue;
+            }
+            if (other->dth_MaskLen > 0 && other->dth_Mask) {
+                if (MasksOverlap(dth, other)) {
+                    usable = FALSE;
+                }
+            } else if (j < i && (other->dth_Flags & DTF_TYPE_MASK) == (dth->dth_Flags & DTF_TYPE_MASK) &&
+                       other->dth_GroupID != GID_SYSTEM &&
+                       (otherDtn->dtn_FunctionName ||
+                        (other->dth_Pattern && strcmp(other->dth_Pattern, "#?") != 0))) {
+                /* Tested earlier by name or function alone, so it could win */
+                usable = FALSE;
+            }
+        }
+
+        /* A name pattern narrows the match further */
+        if (usable && dth->dth_Pattern && strcmp(dth->dth_Pattern, "#?") != 0) {
+            ULONG patternSize = strlen(dth->dth_Pattern) * 2 + 2;
+
+            ctx->dc_Candidates[i].cd_Pattern = (STRPTR)OSAllocMem(patternSize);
+            if (!ctx->dc_Candidates[i].cd_Pattern ||
+                ParsePatternNoCase(dth->dth_Pattern, ctx->dc_Candidates[i].cd_Pattern, (LONG)patternSize) < 0) {
+                usable = FALSE;
+            }
+        }
+
+        ctx->dc_Candidates[i].cd_Usable = usable;
+    }
+
+    LoadHits(ctx);
+    qsort(ctx->dc_Candidates, ctx->dc_CandidateCount, sizeof(struct Candidate), CompareCandidates);
+
+    /* Hits noted before the candidates were needed */
+    for (i = 0; i < ctx->dc_PendingCount; i++) {
+        LONG found = FindCandidate(ctx, NULL, (STRPTR)ctx->dc_Pending[i].ph_BaseName);
+
+        if (found >= 0) {
+            CountHit(ctx, (ULONG)found, ctx->dc_Pending[i].ph_Hits);
+        }
+    }
+    ctx->dc_PendingCount = 0;
+
+    return TRUE;
+}
+
+/* Build the extension table from the masked candidates' patterns and BaseNames */
+static BOOL BuildExtensions(struct DTContext *ctx)
+{
+    struct ExtensionEntry *table = NULL;
+    ULONG count = 0;
+    ULONG pass;
+    ULONG used;
+    ULONG i;
+
+    /* Count first, so the table is allocated once */
+    for (pass = 0; pass < 2; pass++) {
+        count = 0;
+        for (i = 0; i < ctx->dc_CandidateCount; i++) {
+            struct Candidate *cd = &ctx->dc_Candidates[i];
+            struct DataTypeHeader *dth = cd->cd_DataType->dtn_Header;
+
+            /* Without a mask there is nothing to check the name against */
+            if (dth->dth_MaskLen <= 0 || !dth->dth_Mask || dth->dth_GroupID == GID_SYSTEM) {
+                continue;
+            }
+            if (dth->dth_Pattern) {
+                count = AddPatternExtensions(table, count, dth->dth_Pattern, cd->cd_DataType, cd->cd_Rank);
+            }
+            if (dth->dth_BaseName) {
+                count = AddExtension(table, count, (UBYTE *)dth->dth_BaseName, strlen(dth->dth_BaseName),
+                                     cd->cd_DataType, cd->cd_Rank);
+            }
+        }
+
+        if (pass == 0) {
+            if (count == 0) {
+                return FALSE;
+            }
+            table = (struct ExtensionEntry *)OSAllocMem(sizeof(struct ExtensionEntry) * count);
+            if (!table) {
+                return FALSE;
+            }
+        }
+    }
+
+    qsort(table, count, sizeof(struct ExtensionEntry), CompareExtensions);
+
+    /* A BaseName that is also in its own pattern is there twice */
+    used = 1;
+    for (i = 1; i < count; i++) {
+        if (table[i].ee_DataType != table[used - 1].ee_DataType ||
+            Stricmp((STRPTR)table[i].ee_Extension, (STRPTR)table[used - 1].ee_Extension) != 0) {
+            table[used++] = table[i];
+        }
+    }
+
+    ctx->dc_Extensions = table;
+    ctx->dc_ExtensionCount = used;
+
+    return TRUE;
+}
+
+/* Release the candidates, saving the hit counters first */
+VOID FreeCandidates(struct DTContext *ctx)
+{
+    ULONG i;
+
+    if (!ctx || !ctx->dc_Candidates) {
+        return;
+    }
+
+    SaveHits(ctx);
+
+    /* The extension table points at the candidates' descriptors */
+    OSFreeMem(ctx->dc_Extensions);
+    ctx->dc_Extensions = NULL;
+    ctx->dc_ExtensionCount = 0;
+
+    for (i = 0; i < ctx->dc_CandidateCount; i++) {
+        OSFreeMem(ctx->dc_Candidates[i].cd_Pattern);
+        ReleaseDataType(ctx->dc_Candidates[i].cd_DataType);
+    }
+
+    OSFreeMem(ctx->dc_Candidates);
+    ctx->dc_Candidates = NULL;
+    ctx->dc_CandidateCount = 0;
+}
+
+/* Try the usable candidates' masks on a loaded file, most frequent first */
+/* Returns a DataType owned by the candidate list (not to be released), or NULL */
+struct DataType *PreIdentify(struct DTContext *ctx, STRPTR fileName, UBYTE *data, ULONG size)
+{
+    STRPTR filePart;
+    ULONG tested = 0;
+    ULONG i;
+
+    if (!ctx || !data) {
+        return NULL;
+    }
+
+    /* The candidates cost a registry walk, which only pays once a */
+    /* context has identified a few files */
+    if (!ctx->dc_Candidates) {
+        ULONG noted = 0;
+
+        for (i = 0; i < ctx->dc_PendingCount; i++) {
+            noted += ctx->dc_Pending[i].ph_Hits;
+        }
+        if (noted < HITS_LEARN_AFTER || !BuildCandidates(ctx)) {
+            return NULL;
+        }
+    }
+
+    filePart = FilePart(fileName);
+
+    for (i = 0; i < ctx->dc_CandidateCount; i++) {
+        struct Candidate *cd = &ctx->dc_Candidates[i];
+
+        if (!cd->cd_Usable) {
+            continue;
+        }
+        tested++;
+        if (MaskMatches(cd->cd_DataType->dtn_Header, data, size) &&
+            (!cd->cd_Pattern || MatchPatternNoCase(cd->cd_Pattern, filePart))) {
+            STAT_ADD(qs_Tested, tested);
+            STAT_ADD(qs_RegistryRank, cd->cd_Rank + 1);
+            return cd->cd_DataType;
+        }
+    }
+
+    STAT_ADD(qs_Tested, tested);
+    return NULL;
+}
+
+/* Check the descriptors the file's extension names, by mask only */
+/* Returns a DataType owned by the candidate list (not to be released), or NULL */
+struct DataType *FastIdentify(struct DTContext *ctx, STRPTR fileName, UBYTE *data, ULONG size)
+{
+    STRPTR ext;
+    ULONG low;
+    ULONG high;
+    ULONG tested = 0;
+
+    if (!ctx || !fileName || !data) {
+        return NULL;
+    }
+
+    ext = strrchr(FilePart(fileName), '.');
+    if (!ext || !*++ext) {
+        return NULL;
+    }
+
+    if (!ctx->dc_Candidates && !BuildCandidates(ctx)) {
+        return NULL;
+    }
+    if (!ctx->dc_Extensions && !BuildExtensions(ctx)) {
+        return NULL;
+    }
+
+    /* First entry for the extension */
+    low = 0;
+    high = ctx->dc_ExtensionCount;
+    while (low < high) {
+        ULONG middle = (low + high) / 2;
+
+        if (Stricmp((STRPTR)ctx->dc_Extensions[middle].ee_Extension, ext) < 0) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+
+    for (; low < ctx->dc_ExtensionCount && Stricmp((STRPTR)ctx->dc_Extensions[low].ee_Extension, ext) == 0; low++) {
+        struct ExtensionEntry *ee = &ctx->dc_Extensions[low];
+
+        tested++;
+        if (MaskMatches(ee->ee_DataType->dtn_Header, data, size)) {
+            STAT_ADD(qs_Tested, tested);
+            STAT_ADD(qs_RegistryRank, ee->ee_Rank + 1);
+            return ee->ee_DataType;
+        }
+    }
+
+    STAT_ADD(qs_Tested, tested);
+    return NULL;
+}
+
+/* Count a file identified as dtn and move its descriptor up the order */
+/* Building the candidates walks the whole registry, so until PreIdentify(), */
+/* FAST or STATS needs them a hit is only noted by BaseName; a run that */
+/* never builds them saves nothing */
+VOID NoteHit(struct DTContext *ctx, struct DataType *dtn, BOOL preIdentified)
+{
+    STRPTR baseName;
+    LONG i;
+
+    if (!ctx || !dtn) {
+        return;
+    }
+    baseName = dtn->dtn_Header->dth_BaseName;
+
+    if (!ctx->dc_Candidates && !CurrentStats && baseName) {
+        for (i = 0; i < (LONG)ctx->dc_PendingCount; i++) {
+            if (Stricmp((STRPTR)ctx->dc_Pending[i].ph_BaseName, baseName) == 0) {
+                ctx->dc_Pending[i].ph_Hits++;
+                return;
+            }
+        }
+        if (ctx->dc_PendingCount < HITS_PENDING) {
+            Strncpy(ctx->dc_Pending[ctx->dc_PendingCount].ph_BaseName, baseName,
+                    sizeof(ctx->dc_Pending[0].ph_BaseName));
+            ctx->dc_Pending[ctx->dc_PendingCount].ph_Hits = 1;
+            ctx->dc_PendingCount++;
+            return;
+        }
+        /* So many kinds of file that the order is worth learning */
+    }
+
+    if (!ctx->dc_Candidates && !BuildCandidates(ctx)) {
+        return;
+    }
+
+    i = FindCandidate(ctx, dtn->dtn_Header, baseName);
+    if (i < 0) {
+        return;
+    }
+
+    /* The library went through the registry up to this descriptor */
+    if (!preIdentified) {
+        STAT_ADD(qs_Tested, ctx->dc_Candidates[i].cd_Rank + 1);
+        STAT_ADD(qs_RegistryRank, ctx->dc_Candidates[i].cd_Rank + 1);
+    }
+
+    CountHit(ctx, (ULONG)i, 1);
+}
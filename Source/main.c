@@ -0,0 +1,415 @@
+/*
+ * DataType
+ *
+ * Copyright (c) 2025 amigazen project
+ * Licensed under BSD 2-Clause License
+ */
+
+#include "datatype.h"
+
+static const char *verstag = "$VER: DataType 47.2 (2/1/2026)\n";
+static const char *stack_cookie = "$STACK: 4096\n";
+const long oslibversion = 47L;
+
+/* Argument indices for the command template */
+#define ARG_FILE     0
+#define ARG_TARGET   1
+#define ARG_CONVERT  2
+#define ARG_EDIT     3
+#define ARG_BROWSE   4
+#define ARG_INFO     5
+#define ARG_PRINT    6
+#define ARG_MAIL     7
+#define ARG_FORCE    8
+#define ARG_STATS    9
+#define ARG_LOADMAX  10
+#define ARG_SERVER   11
+#define ARG_CLIENT   12
+#define ARG_FIELDS   13
+#define ARG_ORDER    14
+#define ARG_COMPRESS 15
+#define ARG_EXPLODE  16
+#define ARG_RATE     17
+#define ARG_BITS     18
+#define ARG_FORMAT   19
+#define ARG_AUTO     20
+#define ARG_MAXTIME  21
+#define ARG_MEMLIMIT 22
+#define ARG_FAST     23
+#define ARG_WATCH    24
+#define ARG_INDEX    25
+#define ARG_CATALOG  26
+#define ARG_FIND     27
+#define ARG_COUNT    28
+
+/* Command template, also used for requests sent to a SERVER */
+static const char template[] = "FILE/M,TARGET/K,CONVERT/S,EDIT/S,VIEW=BROWSE/S,INFO/S,PRINT/S,MAIL/S,FORCE/S,STATS/S,LOADMAX/K/N,SERVER/S,CLIENT/S,FIELDS/K,ORDER/K,COMPRESS/S,EXPLODE/S,RATE/K/N,BITS/K/N,FORMAT/K,AUTO/S,MAXTIME/K/N,MEMLIMIT/K/N,FAST/S,WATCH/S,INDEX/K,CATALOG/K,FIND/K";
+
+/* Main entry point */
+int main(int argc, char *argv[])
+{
+    struct RDArgs *rda = NULL;
+    struct DTContext *ctx = NULL;
+    LONG result = RETURN_OK;
+    LONG args[ARG_COUNT];
+    
+    /* Initialize args array */
+    {
+        LONG i;
+        for (i = 0; i < ARG_COUNT; i++) {
+            args[i] = 0;
+        }
+    }
+    
+    /* Parse command-line arguments */
+    rda = ReadArgs(template, args, NULL);
+    if (!rda) {
+        LONG errorCode = IoErr();
+        if (errorCode != 0) {
+            PrintFault(errorCode, "DataType");
+        } else {
+            ShowUsage();
+        }
+        return RETURN_FAIL;
+    }
+    
+    /* CLIENT hands the whole line to a running server; without one, run here */
+    if (args[ARG_CLIENT] && !args[ARG_SERVER]) {
+        if (SendToServer(GetArgStr(), Input(), Output(), &result)) {
+            FreeArgs(rda);
+            return result;
+        }
+    }
+    
+    /* Initialize libraries and caches */
+    ctx = CreateDTContext();
+    if (!ctx) {
+        LONG errorCode = IoErr();
+        PrintFault(errorCode ? errorCode : ERROR_OBJECT_NOT_FOUND, "DataType");
+        FreeArgs(rda);
+        return RETURN_FAIL;
+    }
+    
+    if (args[ARG_SERVER]) {
+        result = RunServer(ctx, ServeArgs);
+        if (result != RETURN_OK) {
+            PrintFault(IoErr(), "DataType");
+        }
+    } else {
+        result = RunCommand(ctx, args);
+    }
+    
+    /* Cleanup */
+    if (rda) {
+        FreeArgs(rda);
+    }
+    
+    FreeDTContext(ctx);
+    
+    return result;
+}
+
+/* Parse an argument line received by the SERVER and run it */
+LONG ServeArgs(struct DTContext *ctx, STRPTR argLine)
+{
+    struct RDArgs *rda;
+    LONG args[ARG_COUNT];
+    LONG result;
+    LONG i;
+    
+    for (i = 0; i < ARG_COUNT; i++) {
+        args[i] = 0;
+    }
+    
+    rda = (struct RDArgs *)AllocDosObject(DOS_RDARGS, NULL);
+    if (!rda) {
+        PrintFault(ERROR_NO_FREE_STORE, "DataType");
+        return RETURN_FAIL;
+    }
+    rda->RDA_Source.CS_Buffer = (UBYTE *)argLine;
+    rda->RDA_Source.CS_Length = strlen(argLine);
+    rda->RDA_Source.CS_CurChr = 0;
+    rda->RDA_Flags |= RDAF_NOPROMPT;
+    
+    if (!ReadArgs(template, args, rda)) {
+        LONG errorCode = IoErr();
+        PrintFault(errorCode ? errorCode : ERROR_BAD_TEMPLATE, "DataType");
+        FreeDosObject(DOS_RDARGS, rda);
+        return RETURN_FAIL;
+    }
+    
+    if (args[ARG_SERVER]) {
+        Printf("Error: SERVER cannot be sent to a running server\n");
+        result = RETURN_FAIL;
+    } else if (args[ARG_WATCH]) {
+        /* It would hold the server until CTRL-C */
+        Printf("Error: WATCH cannot be sent to a running server\n");
+        result = RETURN_FAIL;
+    } else {
+        result = RunCommand(ctx, args);
+    }
+    
+    FreeArgs(rda);
+    FreeDosObject(DOS_RDARGS, rda);
+    
+    return result;
+}
+
+/* Switches of a command, handed to every file of its batch */
+struct QueryOptions {
+    STRPTR qo_Target;
+    STRPTR qo_Formats;              /* FORMAT=, one per TARGET */
+    BOOL qo_Convert;
+    BOOL qo_Auto;                   /* CONVERT AUTO */
+    BOOL qo_Explode;
+    BOOL qo_Edit;
+    BOOL qo_Browse;
+    BOOL qo_Info;
+    BOOL qo_Print;
+    BOOL qo_Mail;
+    BOOL qo_Force;
+    BOOL qo_Stats;
+};
+
+/* Query one file of a batch */
+static LONG QueryBatchFile(struct DTContext *ctx, STRPTR fileName, APTR userData)
+{
+    struct QueryOptions *qo = (struct QueryOptions *)userData;
+    LONG fileResult;
+    
+    if (qo->qo_Stats) {
+        BeginFileStats(ctx);
+    }
+    
+    fileResult = QueryDataType(ctx, fileName, qo->qo_Target, qo->qo_Formats, qo->qo_Edit, qo->qo_Browse, qo->qo_Info,
+                               qo->qo_Print, qo->qo_Mail, qo->qo_Convert, qo->qo_Auto, qo->qo_Explode, qo->qo_Force);
+    
+    if (qo->qo_Stats) {
+        EndFileStats(ctx);
+        PrintFileStats(ctx, fileName);
+    }
+    
+    return fileResult;
+}
+
+/* Query every file named in a parsed argument array */
+LONG RunCommand(struct DTContext *ctx, LONG *args)
+{
+    LONG result = RETURN_OK;
+    STRPTR *fileNames = NULL;
+    ULONG fileCount = 0;
+    struct QueryOptions qo;
+    UWORD order = ORDER_ARGS;
+    
+    /* Extract arguments */
+    fileNames = (STRPTR *)args[ARG_FILE];
+    qo.qo_Target = (STRPTR)args[ARG_TARGET];
+    qo.qo_Formats = (STRPTR)args[ARG_FORMAT];
+    qo.qo_Convert = (BOOL)(args[ARG_CONVERT] != 0);
+    qo.qo_Auto = (BOOL)(args[ARG_AUTO] != 0);
+    qo.qo_Explode = (BOOL)(args[ARG_EXPLODE] != 0);
+    qo.qo_Edit = (BOOL)(args[ARG_EDIT] != 0);
+    qo.qo_Browse = (BOOL)(args[ARG_BROWSE] != 0);
+    qo.qo_Info = (BOOL)(args[ARG_INFO] != 0);
+    qo.qo_Print = (BOOL)(args[ARG_PRINT] != 0);
+    qo.qo_Mail = (BOOL)(args[ARG_MAIL] != 0);
+    qo.qo_Force = (BOOL)(args[ARG_FORCE] != 0);
+    qo.qo_Stats = (BOOL)(args[ARG_STATS] != 0);
+    
+    if (args[ARG_ORDER]) {
+        if (Stricmp((STRPTR)args[ARG_ORDER], (STRPTR)"DISK") == 0) {
+            order = ORDER_DISK;
+        } else if (Stricmp((STRPTR)args[ARG_ORDER], (STRPTR)"ARGS") != 0) {
+            Printf("Error: ORDER must be DISK or ARGS\n");
+            return RETURN_FAIL;
+        }
+    }
+    
+    /* A server keeps running, so every request starts from the default */
+    ctx->dc_LoadCutoff = DEFAULT_LOAD_CUTOFF;
+    if (args[ARG_LOADMAX]) {
+        ctx->dc_LoadCutoff = (ULONG)*(LONG *)args[ARG_LOADMAX];
+    }
+    ctx->dc_Compress = (BOOL)(args[ARG_COMPRESS] != 0);
+    ctx->dc_SampleRate = 0;
+    if (args[ARG_RATE]) {
+        LONG rate = *(LONG *)args[ARG_RATE];
+
+        /* VHDR holds the rate in a UWORD */
+        if (rate < 1 || rate > 65535) {
+            Printf("Error: RATE must be from 1 to 65535\n");
+            return RETURN_FAIL;
+        }
+        ctx->dc_SampleRate = (ULONG)rate;
+    }
+    ctx->dc_AutoMillis = 0;
+    if (args[ARG_MAXTIME]) {
+        ctx->dc_AutoMillis = (ULONG)*(LONG *)args[ARG_MAXTIME];
+    }
+    ctx->dc_MemLimit = 0;
+    if (args[ARG_MEMLIMIT]) {
+        ctx->dc_MemLimit = (ULONG)*(LONG *)args[ARG_MEMLIMIT];
+    }
+    ctx->dc_Fast = (BOOL)(args[ARG_FAST] != 0);
+    ctx->dc_SampleBits = 0;
+    if (args[ARG_BITS]) {
+        LONG bits = *(LONG *)args[ARG_BITS];
+
+        if (bits != 8 && bits != 16) {
+            Printf("Error: BITS must be 8 or 16\n");
+            return RETURN_FAIL;
+        }
+        ctx->dc_SampleBits = (ULONG)bits;
+    }
+    ctx->dc_Fields = RECF_ALL;
+    if (args[ARG_FIELDS] && !ParseFields((STRPTR)args[ARG_FIELDS], &ctx->dc_Fields)) {
+        Printf("Error: Unknown field in FIELDS=%s\n", (STRPTR)args[ARG_FIELDS]);
+        ShowFields();
+        return RETURN_FAIL;
+    }
+    
+    if (fileNames) {
+        while (fileNames[fileCount]) {
+            fileCount++;
+        }
+    }
+    
+    /* FIND searches a catalogue rather than looking at any file */
+    if (args[ARG_FIND]) {
+        if (!args[ARG_CATALOG] || fileCount > 0 || args[ARG_WATCH] || args[ARG_INDEX]) {
+            Printf("Error: FIND is used with CATALOG alone, as CATALOG=<file> FIND=<query>\n");
+            return RETURN_FAIL;
+        }
+        return RunFind((STRPTR)args[ARG_CATALOG], (STRPTR)args[ARG_FIND]);
+    }
+    
+    if (fileCount == 0) {
+        ShowUsage();
+        return RETURN_FAIL;
+    }
+    
+    if (qo.qo_Auto && !qo.qo_Convert) {
+        Printf("Error: AUTO is used with CONVERT, as CONVERT AUTO\n");
+        return RETURN_FAIL;
+    }
+    
+    if (qo.qo_Formats && (!qo.qo_Target || qo.qo_Convert || qo.qo_Explode)) {
+        Printf("Error: FORMAT needs TARGET and cannot be used with CONVERT or EXPLODE\n");
+        return RETURN_FAIL;
+    }
+    
+    /* WATCH runs until CTRL-C, keeping INDEX up to date with the FILE */
+    /* trees; CATALOG writes what they hold for FIND, once or as they change */
+    if (args[ARG_WATCH] || args[ARG_INDEX] || args[ARG_CATALOG]) {
+        if (!args[ARG_CATALOG] && (!args[ARG_WATCH] || !args[ARG_INDEX])) {
+            Printf("Error: WATCH and INDEX are used together, as WATCH INDEX=<file>\n");
+            return RETURN_FAIL;
+        }
+        if (args[ARG_INDEX] && !args[ARG_WATCH]) {
+            Printf("Error: INDEX is kept by WATCH, as WATCH INDEX=<file>\n");
+            return RETURN_FAIL;
+        }
+        if (qo.qo_Target || qo.qo_Convert || qo.qo_Explode || qo.qo_Edit || qo.qo_Browse ||
+            qo.qo_Info || qo.qo_Print || qo.qo_Mail) {
+            Printf("Error: WATCH and CATALOG cannot be used with TARGET, CONVERT, EXPLODE or a tool\n");
+            return RETURN_FAIL;
+        }
+        return RunWatch(ctx, fileNames, fileCount, (STRPTR)args[ARG_INDEX], (STRPTR)args[ARG_CATALOG],
+                        (BOOL)(args[ARG_WATCH] != 0));
+    }
+    
+    /* Conversion writes a single TARGET, so it only makes sense for one file */
+    if (fileCount > 1 && (qo.qo_Target || qo.qo_Convert || qo.qo_Explode)) {
+        Printf("Error: TARGET, CONVERT and EXPLODE can only be used with a single FILE\n");
+        return RETURN_FAIL;
+    }
+    
+    /* Per-phase timing needs timer.device */
+    if (qo.qo_Stats && !InitStats(ctx, fileCount)) {
+        LONG errorCode = IoErr();
+        PrintFault(errorCode ? errorCode : ERROR_OBJECT_NOT_FOUND, "DataType");
+        return RETURN_FAIL;
+    }
+    
+    /* Query datatype and optionally launch tool or convert, in the order */
+    /* given unless ORDER=DISK */
+    result = RunBatch(ctx, fileNames, fileCount, order, QueryBatchFile, &qo);
+    
+    if (qo.qo_Stats) {
+        PrintBatchStats(ctx);
+        FreeStats(ctx);
+    }
+    
+    return result;
+}
+
+/* Show usage information */
+VOID ShowUsage(VOID)
+{
+    Printf("Usage: DataType FILE=<filename> [<filename>...] [OUTPUT=<outfile>] [CONVERT] [EDIT] [BROWSE] [INFO] [PRINT] [MAIL] [FORCE] [STATS] [LOADMAX=<bytes>] [SERVER] [CLIENT] [FIELDS=<list>] [ORDER=DISK|ARGS] [COMPRESS] [EXPLODE] [RATE=<hz>] [BITS=8|16] [FORMAT=<list>] [AUTO] [MAXTIME=<ms>] [MEMLIMIT=<bytes>] [FAST] [WATCH] [INDEX=<file>] [CATALOG=<file>] [FIND=<query>]\n");
+    Printf("\n");
+    Printf("Options:\n");
+    Printf("  FILE=<filename>  - File(s) to query datatype for (required)\n");
+    Printf("  OUTPUT=<file>    - Output file for conversion (assumes IFF if CONVERT not specified)\n");
+    Printf("  CONVERT          - List available formats and prompt for selection\n");
+    Printf("  EDIT             - Launch EDIT tool for the file\n");
+    Printf("  VIEW=BROWSE      - Launch VIEW tool for the file\n");
+    Printf("  INFO             - Launch INFO tool for the file\n");
+    Printf("  PRINT            - Launch PRINT tool for the file\n");
+    Printf("  MAIL             - Launch MAIL tool for the file\n");
+    Printf("  FORCE            - Overwrite existing output file\n");
+    Printf("  STATS            - Print per-phase timing and I/O counters\n");
+    Printf("  LOADMAX=<bytes>  - Read files up to this size into memory once (0 = never)\n");
+    Printf("  SERVER           - Stay resident and answer CLIENT requests until CTRL-C\n");
+    Printf("  CLIENT           - Send the query to a running SERVER (runs locally if none)\n");
+    Printf("  FIELDS=<list>    - Only work out these fields, comma-separated (default all)\n");
+    Printf("  ORDER=DISK|ARGS  - Batch order: by volume and disk position, or as given (default)\n");
+    Printf("  COMPRESS         - Delta-compress sounds converted to 8SVX (half the size)\n");
+    Printf("  EXPLODE          - Write each animation frame as an ILBM, TARGET.0001 on\n");
+    Printf("  RATE=<hz>        - Resample sounds being converted to this rate\n");
+    Printf("  BITS=8|16        - Write sounds as 8-bit 8SVX (dithered) or 16-bit AIFF\n");
+    Printf("  FORMAT=<list>    - Formats for a comma-separated TARGET list (IFF if left out)\n");
+    Printf("  AUTO             - With CONVERT, try every encoding and keep the smallest\n");
+    Printf("  MAXTIME=<ms>     - Stop trying CONVERT AUTO encodings after this long\n");
+    Printf("  MEMLIMIT=<bytes> - Report files whose decode would take more as metadata only\n");
+    Printf("  FAST             - Trust file extensions, checking only their datatype's mask\n");
+    Printf("  WATCH            - Keep INDEX up to date with the FILE directories until CTRL-C\n");
+    Printf("  INDEX=<file>     - Result index WATCH keeps\n");
+    Printf("  CATALOG=<file>   - Write a searchable catalogue of the FILE directories\n");
+    Printf("  FIND=<query>     - List the files of CATALOG that match, e.g. group=picture width>640\n");
+    Printf("\n");
+    Printf("If no tool switch is specified, displays datatype information and\n");
+    Printf("available tools without launching anything.\n");
+    Printf("\n");
+    Printf("Examples:\n");
+    Printf("  DataType FILE=test.txt          - Show datatype info for test.txt\n");
+    Printf("  DataType FILE=image.ilbm EDIT   - Launch editor for image.ilbm\n");
+    Printf("  DataType FILE=document.ftxt BROWSE - Launch browser for document.ftxt\n");
+    Printf("  DataType FILE=pic.jpg OUTPUT=pic.ilbm - Convert pic.jpg to IFF format\n");
+    Printf("  DataType FILE=pic.jpg CONVERT   - List formats and convert pic.jpg\n");
+    Printf("  DataType a.iff b.iff STATS      - Time each query and summarise the batch\n");
+    Printf("  Run DataType SERVER             - Start a resident server\n");
+    Printf("  DataType pic.iff CLIENT         - Query through the running server\n");
+    Printf("  DataType a.iff b.iff FIELDS=group,basename - Identify only, no decoding\n");
+    Printf("  DataType movie.anim TARGET=RAM:f EXPLODE - Frames to RAM:f.0001, RAM:f.0002...\n");
+    Printf("  DataType hit.8svx TARGET=hit.aiff RATE=44100 BITS=16 - Resample to 16-bit AIFF\n");
+    Printf("  DataType pic.jpg TARGET=a.ilbm,b.png FORMAT=ilbm,png - Decode once, write both\n");
+    Printf("  DataType pic.jpg CONVERT AUTO TARGET=pic - Write whichever encoding is smallest\n");
+    Printf("  DataType a.iff b.iff MEMLIMIT=1000000 - Skip decoding anything over a megabyte\n");
+    Printf("  DataType a.ilbm b.ilbm FAST STATS - Identify by extension; see the hit rate\n");
+    Printf("  Run DataType Work:Pics WATCH INDEX=Work:pics.index - Index, then follow changes\n");
+    Printf("  DataType Work: CATALOG=Work:files.cat - Catalogue every file on Work:\n");
+    Printf("  DataType CATALOG=Work:files.cat FIND=\"group=sound rate>22050\" - Search it\n");
+}
+
+/* List the field names FIELDS accepts */
+VOID ShowFields(VOID)
+{
+    ULONG i;
+    
+    Printf("Fields:");
+    for (i = 0; FieldMap[i].fd_Name; i++) {
+        Printf(" %s", FieldMap[i].fd_Name);
+    }
+    Printf(" all\n");
+}
@@ -0,0 +1,173 @@
+/*
+ * DataType - metadata extraction and write capabilities
+ *
+ * Copyright (c) 2025 amigazen project
+ * Licensed under BSD 2-Clause License
+ */
+
+#include "datatype.h"
+
+/* Fill in the datatype-specific metadata of a record from a decoded object */
+VOID GetDatatypeMetadata(Object *dtObject, ULONG groupID, struct DTRecord *record)
+{
+    ULONG width = 0;
+    ULONG height = 0;
+    UWORD depth = 0;
+    ULONG frames = 0;
+    ULONG numColors = 0;
+    ULONG resultCount = 0;
+    ULONG sampleLength = 0;
+    UWORD samplesPerSec = 0;
+    UWORD bitsPerSample = 0;
+    STRPTR textBuffer = NULL;
+    ULONG textBufferLen = 0;
+    
+    if (!dtObject || !record) {
+        return;
+    }
+    
+    /* Query attributes based on group type */
+    if (groupID == GID_PICTURE) {
+        /* Try to get picture dimensions using PDTA attributes */
+        struct BitMapHeader *bmh = NULL;
+        if (GetDTAttrs(dtObject, PDTA_BitMapHeader, &bmh, TAG_DONE) == 1 && bmh) {
+            record->dr_Width = bmh->bmh_Width;
+            record->dr_Height = bmh->bmh_Height;
+            record->dr_Depth = bmh->bmh_Depth;
+            record->dr_Valid |= RECF_DIMS;
+            if (bmh->bmh_Depth > 0 &&
+                GetDTAttrs(dtObject, PDTA_NumColors, &numColors, TAG_DONE) == 1) {
+                record->dr_Colors = numColors;
+                record->dr_Valid |= RECF_COLORS;
+            }
+        } else {
+            /* Fallback to ADTA attributes (for picture.datatype compatibility) */
+            resultCount = GetDTAttrs(dtObject,
+                                     ADTA_Width, &width,
+                                     ADTA_Height, &height,
+                                     ADTA_Depth, &depth,
+                                     ADTA_NumColors, &numColors,
+                                     TAG_DONE);
+            
+            if (resultCount >= 2 && (width > 0 || height > 0)) {
+                record->dr_Width = width;
+                record->dr_Height = height;
+                record->dr_Depth = depth;
+                record->dr_Colors = numColors;
+                record->dr_Valid |= RECF_DIMS | RECF_COLORS;
+            }
+        }
+    } else if (groupID == GID_ANIMATION) {
+        /* Try to get animation dimensions */
+        resultCount = GetDTAttrs(dtObject,
+                                 ADTA_Width, &width,
+                                 ADTA_Height, &height,
+                                 ADTA_Depth, &depth,
+                                 ADTA_NumColors, &numColors,
+                                 TAG_DONE);
+        
+        if (resultCount >= 2 && (width > 0 || height > 0)) {
+            record->dr_Width = width;
+            record->dr_Height = height;
+            record->dr_Depth = depth;
+            record->dr_Colors = numColors;
+            record->dr_Valid |= RECF_DIMS | RECF_COLORS;
+        }
+        
+        /* Get frame count */
+        if (GetDTAttrs(dtObject, ADTA_Frames, &frames, TAG_DONE) == 1) {
+            record->dr_Frames = frames;
+            record->dr_Valid |= RECF_FRAMES;
+        }
+    } else if (groupID == GID_SOUND) {
+        /* Get sound attributes */
+        resultCount = GetDTAttrs(dtObject,
+                                 SDTA_SampleLength, &sampleLength,
+                                 SDTA_SamplesPerSec, &samplesPerSec,
+                                 SDTA_BitsPerSample, &bitsPerSample,
+                                 TAG_DONE);
+        
+        if (resultCount >= 1) {
+            record->dr_SampleLength = sampleLength;
+            record->dr_SamplesPerSec = samplesPerSec;
+            record->dr_BitsPerSample = bitsPerSample;
+            record->dr_Valid |= RECF_AUDIO;
+        }
+    } else if (groupID == GID_TEXT) {
+        /* Get text attributes */
+        if (GetDTAttrs(dtObject, TDTA_Buffer, &textBuffer, TDTA_BufferLen, &textBufferLen, TAG_DONE) >= 1) {
+            record->dr_TextLength = textBufferLen;
+            record->dr_Valid |= RECF_TEXT;
+        }
+    }
+}
+
+/* Find out which write modes a datatype object supports */
+/* Write modes belong to the class, so the probes run once per BaseName */
+VOID GetWriteCapabilities(struct DTContext *ctx, Object *dtObject, struct DataType *dtn, struct DTRecord *record)
+{
+    BOOL supportsIFF = FALSE;
+    BOOL supportsRAW = FALSE;
+    struct CacheEntry *ce = NULL;
+    STRPTR baseName = NULL;
+    struct EClockVal clock;
+    
+    if (!dtObject || !record) {
+        return;
+    }
+    
+    if (dtn && dtn->dtn_Header) {
+        baseName = dtn->dtn_Header->dth_BaseName;
+        ce = FindCacheEntry(ctx, CACHE_WRITECAPS, baseName);
+    }
+    if (ce) {
+        record->dr_WriteCaps = ce->ce_Value;
+        record->dr_Valid |= RECF_WRITE;
+        return;
+    }
+    
+    /* Check if DTM_WRITE method is supported using FindMethod */
+    /* Test which write modes are supported by attempting writes to a temporary file */
+    if (IsDTMethodSupported(dtObject, DTM_WRITE)) {
+        UBYTE tempFileName[64];
+        ULONG uniqueID;
+        
+        BeginPhase(&clock);
+        
+        /* Generate unique temporary filename */
+        uniqueID = GetUniqueID();
+        SNPrintf(tempFileName, sizeof(tempFileName), "T:dtwrite%08lX", uniqueID);
+        
+        /* Clear selection before testing */
+        {
+            struct dtGeneral clearMsg;
+            clearMsg.MethodID = DTM_CLEARSELECTED;
+            clearMsg.dtg_GInfo = NULL;
+            DoDTMethodA(dtObject, NULL, NULL, (Msg)&clearMsg);
+        }
+        
+        /* Test DTWM_IFF mode using SaveDTObjectA */
+        /* SaveDTObjectA deletes the file if DTM_WRITE returns 0; a successful probe is removed here */
+        SetIoErr(0);
+        if (SaveDTObjectA(dtObject, NULL, NULL, (STRPTR)tempFileName, DTWM_IFF, FALSE, TAG_DONE)) {
+            supportsIFF = TRUE;
+            DeleteFile((STRPTR)tempFileName);
+        }
+        
+        /* Test DTWM_RAW mode */
+        SetIoErr(0);
+        if (SaveDTObjectA(dtObject, NULL, NULL, (STRPTR)tempFileName, DTWM_RAW, FALSE, TAG_DONE)) {
+            supportsRAW = TRUE;
+            DeleteFile((STRPTR)tempFileName);
+        }
+        
+        EndPhase(PHASE_WRITEPROBE, &clock);
+    }
+    
+    record->dr_WriteCaps = (supportsIFF ? WRITECAP_IFF : 0) | (supportsRAW ? WRITECAP_RAW : 0);
+    record->dr_Valid |= RECF_WRITE;
+    
+    if (baseName) {
+        AddCacheEntry(ctx, CACHE_WRITECAPS, baseName, record->dr_WriteCaps, NULL);
+    }
+}
@@ -0,0 +1,302 @@
+/*
+ * DataType - sound rate and depth conversion
+ *
+ * Copyright (c) 2025 amigazen project
+ * Licensed under BSD 2-Clause License
+ */
+
+#include "datatype.h"
+
+/*
+ * RATE= and BITS= turn a sound into the rate and sample size asked for
+ * as it is written. Samples pass through in SAMPLE_BLOCK_SIZE pieces:
+ * 8-bit input is widened to 16 bits, resampled, then either written as
+ * it is (an AIFF) or dithered down to 8 bits (an 8SVX). So however long
+ * the sound, only a few blocks are held besides the decoded object.
+ *
+ * Resampling is linear interpolation with a 16.16 fixed-point position
+ * that carries over from one block to the next, so block boundaries are
+ * seamless. It is all integer arithmetic, with one multiply a sample.
+ */
+
+/* Prepare a converter from inRate to outRate samples a second */
+VOID InitSampleConverter(struct SampleConverter *sc, ULONG inRate, ULONG outRate)
+{
+    memset(sc, 0, sizeof(struct SampleConverter));
+
+    sc->sc_Step = 0x10000;
+    if (inRate > 0 && outRate > 0 && outRate < 0x80000000UL && inRate != outRate &&
+        inRate / outRate <= 0xFFFF) {
+        ULONG remainder = inRate % outRate;
+        ULONG bit;
+
+        /* inRate << 16 would overflow from 65536 Hz, as 88.2 and 96 kHz */
+        /* sources are, so the fraction is divided out a bit at a time */
+        sc->sc_Step = (inRate / outRate) << 16;
+        for (bit = 0x8000; bit; bit >>= 1) {
+            remainder <<= 1;
+            if (remainder >= outRate) {
+                remainder -= outRate;
+                sc->sc_Step |= bit;
+            }
+        }
+
+        /* Past this, one input sample's output would not fit a block */
+        if (sc->sc_Step < 0x10000 / (SAMPLE_BLOCK_SIZE / 2)) {
+            sc->sc_Step = 0x10000 / (SAMPLE_BLOCK_SIZE / 2);
+        }
+    }
+    sc->sc_Seed = 0x2545F491;
+}
+
+/* Input samples per block whose output fits a block */
+ULONG SampleInputBlock(struct SampleConverter *sc)
+{
+    ULONG count;
+
+    /* Downsampling never gives more out than in */
+    if (sc->sc_Step >= 0x10000) {
+        return SAMPLE_BLOCK_SIZE;
+    }
+
+    /* One more may come from the position carried in, one is spare */
+    count = ((SAMPLE_BLOCK_SIZE - 2) * sc->sc_Step) >> 16;
+
+    return (count > 0) ? count : 1;
+}
+
+/* Widen signed 8-bit samples to 16 bits */
+VOID ExpandSamples(BYTE *src, WORD *dst, ULONG count)
+{
+    while (count-- > 0) {
+        *dst++ = (WORD)(*src++ << 8);
+    }
+}
+
+/* Resample one block; returns the number of samples put in dst */
+/* The last output is held back until the next block or FinishResample() */
+ULONG ResampleSamples(struct SampleConverter *sc, WORD *src, ULONG count, WORD *dst)
+{
+    WORD *out = dst;
+    ULONG pos;
+    ULONG index;
+
+    if (count == 0) {
+        return 0;
+    }
+
+    /* The first sample is only something to interpolate from */
+    if (!sc->sc_Primed) {
+        sc->sc_Prev = *src++;
+        sc->sc_Primed = TRUE;
+        if (--count == 0) {
+            return 0;
+        }
+    }
+
+    /* Outputs between sc_Prev and src[0], then along the block */
+    pos = sc->sc_Pos;
+    while ((index = pos >> 16) < count) {
+        LONG a = index ? src[index - 1] : sc->sc_Prev;
+        LONG b = src[index];
+
+        /* A 15-bit fraction keeps the product within a LONG */
+        *out++ = (WORD)(a + (((b - a) * (LONG)((pos & 0xFFFF) >> 1)) >> 15));
+        pos += sc->sc_Step;
+    }
+
+    sc->sc_Prev = src[count - 1];
+    sc->sc_Pos = pos - (count << 16);
+
+    return (ULONG)(out - dst);
+}
+
+/* Emit the outputs that fall after the last input sample, up to max */
+ULONG FinishResample(struct SampleConverter *sc, WORD *dst, ULONG max)
+{
+    ULONG count = 0;
+
+    if (!sc->sc_Primed) {
+        return 0;
+    }
+
+    /* Nothing follows the last sample, so it is held */
+    while (sc->sc_Pos < 0x10000 && count < max) {
+        dst[count++] = (WORD)sc->sc_Prev;
+        sc->sc_Pos += sc->sc_Step;
+    }
+
+    return count;
+}
+
+/* Reduce 16-bit samples to 8 bits with triangular dither */
+VOID DitherSamples(struct SampleConverter *sc, WORD *src, BYTE *dst, ULONG count)
+{
+    ULONG seed = sc->sc_Seed;
+
+    while (count-- > 0) {
+        LONG value;
+
+        /* Two bytes of one xorshift step make noise of -255 to 255 */
+        seed ^= seed << 13;
+        seed ^= seed >> 17;
+        seed ^= seed << 5;
+        value = *src++ + (LONG)(seed & 0xFF) + (LONG)((seed >> 8) & 0xFF) - 255 + 128;
+
+        value = (value + 32768) >> 8;
+        if (value > 255) {
+            value = 255;
+        } else if (value < 0) {
+            value = 0;
+        }
+        *dst++ = (BYTE)(value - 128);
+    }
+
+    sc->sc_Seed = seed;
+}
+
+/* Write a converted block to whichever writer is open */
+static VOID PutSamples(struct SampleConverter *sc, struct SVXWriter *sw, struct AIFFWriter *aw,
+                       WORD *samples, BYTE *narrow, ULONG count)
+{
+    if (aw) {
+        WriteAIFFSamples(aw, samples, count);
+    } else {
+        DitherSamples(sc, samples, narrow, count);
+        WriteSVXSamples(sw, narrow, count);
+    }
+}
+
+/* Write a sound object as an IFF: an 8SVX at 8 bits, an AIFF at 16 */
+/* rate and bits of 0 keep the sound's own; compress applies to 8SVX */
+/* Fails with ERROR_NOT_IMPLEMENTED for sounds left to the class */
+BOOL WriteSoundIFF(Object *dtObject, STRPTR outputFile, ULONG rate, ULONG bits, BOOL compress)
+{
+    struct SampleConverter sc;
+    struct SVXWriter sw;
+    struct AIFFWriter aw;
+    struct IFFWriter *iw;
+    APTR sample = NULL;
+    WORD *wide;
+    WORD *converted;
+    BYTE *narrow;
+    ULONG length = 0;
+    ULONG samplesPerSec = 0;
+    ULONG volume = 64;
+    ULONG sourceBits = 8;
+    ULONG sampleType = SDTST_M8S;
+    ULONG block;
+    ULONG done;
+    ULONG part;
+    ULONG count;
+    BOOL resample;
+
+    if (!dtObject || !outputFile) {
+        SetIoErr(ERROR_REQUIRED_ARG_MISSING);
+        return FALSE;
+    }
+
+    GetDTAttrs(dtObject,
+               SDTA_Sample, (ULONG)&sample,
+               SDTA_SampleLength, (ULONG)&length,
+               SDTA_SamplesPerSec, (ULONG)&samplesPerSec,
+               SDTA_Volume, (ULONG)&volume,
+               TAG_DONE);
+    GetDTAttrs(dtObject, SDTA_BitsPerSample, (ULONG)&sourceBits, TAG_DONE);
+    GetDTAttrs(dtObject, SDTA_SampleType, (ULONG)&sampleType, TAG_DONE);
+
+    /* Stereo and unusual sizes are left to the class */
+    if (!sample || length == 0 || (sourceBits != 8 && sourceBits != 16) ||
+        sampleType == SDTST_S8S || sampleType == SDTST_S16S) {
+        SetIoErr(ERROR_NOT_IMPLEMENTED);
+        return FALSE;
+    }
+
+    /* Without options, only what the 8SVX writer always took */
+    if (bits == 0) {
+        if (rate == 0 && sourceBits != 8) {
+            SetIoErr(ERROR_NOT_IMPLEMENTED);
+            return FALSE;
+        }
+        bits = sourceBits;
+    }
+    if (rate == 0 || samplesPerSec == 0) {
+        rate = samplesPerSec;
+    }
+    resample = (BOOL)(rate != samplesPerSec);
+
+    /* 8-bit as it is: straight through the 8SVX writer */
+    if (sourceBits == 8 && bits == 8 && !resample) {
+        if (!OpenSVXWriter(&sw, outputFile, samplesPerSec, volume, compress)) {
+            return FALSE;
+        }
+        for (done = 0; done < length && !sw.sw_IFF.iw_Error; done += part) {
+            part = length - done;
+            if (part > SVX_BLOCK_SIZE) {
+                part = SVX_BLOCK_SIZE;
+            }
+            WriteSVXSamples(&sw, (BYTE *)sample + done, part);
+        }
+        return CloseSVXWriter(&sw);
+    }
+
+    /* Widened input, resampled output and the output dithered to bytes */
+    wide = (WORD *)OSAllocMem(SAMPLE_BLOCK_SIZE * (sizeof(WORD) * 2 + 1));
+    if (!wide) {
+        SetIoErr(ERROR_NO_FREE_STORE);
+        return FALSE;
+    }
+    converted = wide + SAMPLE_BLOCK_SIZE;
+    narrow = (BYTE *)(converted + SAMPLE_BLOCK_SIZE);
+
+    if (bits == 16) {
+        if (!OpenAIFFWriter(&aw, outputFile, rate)) {
+            OSFreeMem(wide);
+            return FALSE;
+        }
+        iw = &aw.aw_IFF;
+    } else {
+        if (!OpenSVXWriter(&sw, outputFile, rate, volume, compress)) {
+            OSFreeMem(wide);
+            return FALSE;
+        }
+        iw = &sw.sw_IFF;
+    }
+
+    InitSampleConverter(&sc, samplesPerSec, rate);
+    block = SampleInputBlock(&sc);
+
+    for (done = 0; done < length && !iw->iw_Error; done += part) {
+        WORD *in;
+
+        part = length - done;
+        if (part > block) {
+            part = block;
+        }
+
+        if (sourceBits == 8) {
+            ExpandSamples((BYTE *)sample + done, wide, part);
+            in = wide;
+        } else {
+            in = (WORD *)sample + done;
+        }
+
+        if (resample) {
+            count = ResampleSamples(&sc, in, part, converted);
+            in = converted;
+        } else {
+            count = part;
+        }
+
+        PutSamples(&sc, (bits == 16) ? NULL : &sw, (bits == 16) ? &aw : NULL, in, narrow, count);
+    }
+
+    if (resample) {
+        count = FinishResample(&sc, converted, SAMPLE_BLOCK_SIZE);
+        PutSamples(&sc, (bits == 16) ? NULL : &sw, (bits == 16) ? &aw : NULL, converted, narrow, count);
+    }
+
+    OSFreeMem(wide);
+
+    return (bits == 16) ? CloseAIFFWriter(&aw) : CloseSVXWriter(&sw);
+}
@@ -0,0 +1,181 @@
+/*
+ * DataType - resident server and thin client
+ *
+ * Copyright (c) 2025 amigazen project
+ * Licensed under BSD 2-Clause License
+ */
+
+#include "datatype.h"
+
+/*
+ * A SERVER keeps one context, with its libraries and lookup caches,
+ * warm and answers requests on the public SERVER_PORT_NAME port. A request is
+ * just the client's argument line: the server switches to the client's
+ * current directory and streams, runs the line through the handler it
+ * was given, and replies with the return code. The client waits for
+ * the reply, so everything it passed stays valid until then.
+ */
+
+/* Run one request in the client's context */
+static VOID ServeMessage(struct DTContext *ctx, struct ServerMsg *msg, LONG (*handler)(struct DTContext *ctx, STRPTR argLine))
+{
+    BPTR oldDir;
+    BPTR oldInput;
+    BPTR oldOutput;
+
+    /* A new or removed descriptor makes the cached lookups stale */
+    ValidateCache(ctx);
+
+    oldDir = CurrentDir(msg->sm_CurrentDir);
+    oldInput = SelectInput(msg->sm_Input);
+    oldOutput = SelectOutput(msg->sm_Output);
+
+    SetIoErr(0);
+    msg->sm_Result = handler(ctx, msg->sm_Args);
+    msg->sm_Error = IoErr();
+
+    /* The client prints nothing until we reply, so hand over all output now */
+    Flush(Output());
+
+    SelectOutput(oldOutput);
+    SelectInput(oldInput);
+    CurrentDir(oldDir);
+}
+
+/* Serve requests until CTRL-C */
+LONG RunServer(struct DTContext *ctx, LONG (*handler)(struct DTContext *ctx, STRPTR argLine))
+{
+    struct MsgPort *port;
+    struct ServerMsg *msg;
+    ULONG signals;
+    BOOL running = TRUE;
+
+    if (!ctx || !handler) {
+        SetIoErr(ERROR_REQUIRED_ARG_MISSING);
+        return RETURN_FAIL;
+    }
+
+    port = CreateMsgPort();
+    if (!port) {
+        SetIoErr(ERROR_NO_FREE_STORE);
+        return RETURN_FAIL;
+    }
+    port->mp_Node.ln_Name = (char *)SERVER_PORT_NAME;
+    port->mp_Node.ln_Pri = 0;
+
+    /* Only one server at a time */
+    Forbid();
+    if (FindPort((STRPTR)SERVER_PORT_NAME)) {
+        Permit();
+        DeleteMsgPort(port);
+        SetIoErr(ERROR_OBJECT_IN_USE);
+        return RETURN_FAIL;
+    }
+    AddPort(port);
+    Permit();
+
+    Printf("DataType server running on port %s (CTRL-C to stop)\n", (STRPTR)SERVER_PORT_NAME);
+
+    while (running) {
+        signals = Wait((1L << port->mp_SigBit) | SIGBREAKF_CTRL_C);
+
+        while ((msg = (struct ServerMsg *)GetMsg(port)) != NULL) {
+            ServeMessage(ctx, msg, handler);
+            ReplyMsg(&msg->sm_Message);
+        }
+
+        if (signals & SIGBREAKF_CTRL_C) {
+            running = FALSE;
+        }
+    }
+
+    /* Turn away anything that arrived while shutting down */
+    Forbid();
+    RemPort(port);
+    while ((msg = (struct ServerMsg *)GetMsg(port)) != NULL) {
+        msg->sm_Result = RETURN_FAIL;
+        msg->sm_Error = ERROR_BREAK;
+        ReplyMsg(&msg->sm_Message);
+    }
+    Permit();
+
+    DeleteMsgPort(port);
+
+    return RETURN_OK;
+}
+
+/* Forward an argument line to a running server and wait for the answer */
+/* Returns FALSE if no server is running; the query has then not been made */
+BOOL SendToServer(STRPTR argLine, BPTR input, BPTR output, LONG *result)
+{
+    struct MsgPort *replyPort;
+    struct MsgPort *serverPort;
+    struct ServerMsg *msg;
+    STRPTR line;
+    ULONG lineLen;
+    BPTR currentDir;
+
+    if (!argLine) {
+        SetIoErr(ERROR_REQUIRED_ARG_MISSING);
+        return FALSE;
+    }
+
+    /* Cheap check first so a missing server costs nothing */
+    if (!FindPort((STRPTR)SERVER_PORT_NAME)) {
+        return FALSE;
+    }
+
+    replyPort = CreateMsgPort();
+    if (!replyPort) {
+        return FALSE;
+    }
+
+    /* ReadArgs() on the server wants the line to end in a newline */
+    lineLen = strlen(argLine);
+    msg = (struct ServerMsg *)OSAllocMem(sizeof(struct ServerMsg) + lineLen + 2);
+    if (!msg) {
+        DeleteMsgPort(replyPort);
+        return FALSE;
+    }
+    line = (STRPTR)(msg + 1);
+    CopyMem(argLine, line, lineLen);
+    if (lineLen == 0 || line[lineLen - 1] != '\n') {
+        line[lineLen++] = '\n';
+    }
+    line[lineLen] = '\0';
+
+    currentDir = CurrentDir(NULL);
+    CurrentDir(currentDir);
+
+    msg->sm_Message.mn_Node.ln_Type = NT_MESSAGE;
+    msg->sm_Message.mn_ReplyPort = replyPort;
+    msg->sm_Message.mn_Length = sizeof(struct ServerMsg);
+    msg->sm_Args = line;
+    msg->sm_CurrentDir = currentDir;
+    msg->sm_Input = input;
+    msg->sm_Output = output;
+    msg->sm_Result = RETURN_FAIL;
+    msg->sm_Error = 0;
+
+    /* The server may quit between FindPort() and PutMsg() */
+    Forbid();
+    serverPort = FindPort((STRPTR)SERVER_PORT_NAME);
+    if (serverPort) {
+        PutMsg(serverPort, &msg->sm_Message);
+    }
+    Permit();
+
+    if (serverPort) {
+        WaitPort(replyPort);
+        GetMsg(replyPort);
+        if (result) {
+            *result = msg->sm_Result;
+        }
+        SetIoErr(msg->sm_Error);
+    }
+
+    OSFreeMem(msg);
+    DeleteMsgPort(replyPort);
+
+    return (BOOL)(serverPort != NULL);
+}
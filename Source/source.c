@@ -0,0 +1,299 @@
+/*
+ * DataType - per-file source for identification and decoding
+ *
+ * Copyright (c) 2025 amigazen project
+ * Licensed under BSD 2-Clause License
+ */
+
+#include "datatype.h"
+
+/*
+ * A file under the load cutoff is read into memory with one Read() when
+ * it is opened. Identification and object creation are then fed from
+ * that buffer with DTST_MEMORY, so the device is only touched once per
+ * file. Larger files, and anything the memory path cannot handle, go
+ * through the lock and name exactly as before. A loaded file is first
+ * matched against the learned descriptor order (see learn.c).
+ *
+ * The decoded object is made once, on first use, and shared by the
+ * metadata report, the write probes and the conversions until the
+ * FileQuery is closed.
+ */
+
+/* Lock a file and load it if it is no larger than the context's cutoff */
+BOOL OpenFileQuery(struct DTContext *ctx, struct FileQuery *fq, STRPTR fileName)
+{
+    if (!ctx || !fq || !fileName) {
+        SetIoErr(ERROR_REQUIRED_ARG_MISSING);
+        return FALSE;
+    }
+
+    fq->fq_Name = fileName;
+    fq->fq_Lock = NULL;
+    fq->fq_DataType = NULL;
+    fq->fq_Buffer = NULL;
+    fq->fq_BufferSize = 0;
+    fq->fq_Object = NULL;
+    fq->fq_ObjectError = 0;
+    fq->fq_Context = ctx;
+    fq->fq_Borrowed = FALSE;
+    fq->fq_IdentifiedBy = IDBY_NONE;
+    fq->fq_MetadataOnly = FALSE;
+
+    fq->fq_Lock = OSLock(fileName);
+    if (!fq->fq_Lock) {
+        return FALSE;
+    }
+
+    if (!OSExamineLock(fq->fq_Lock, &fq->fq_Info)) {
+        OSUnLock(fq->fq_Lock);
+        fq->fq_Lock = NULL;
+        return FALSE;
+    }
+
+    /* The batch scheduler may have read the file already; take it over */
+    /* unless the file has changed size since */
+    if (ctx->dc_ReadAhead && ctx->dc_ReadAheadName == fileName) {
+        if (fq->fq_Info.ofi_Type < 0 && ctx->dc_ReadAheadSize == fq->fq_Info.ofi_Size) {
+            fq->fq_Buffer = ctx->dc_ReadAhead;
+            fq->fq_BufferSize = ctx->dc_ReadAheadSize;
+        } else {
+            OSFreeMem(ctx->dc_ReadAhead);
+        }
+        ctx->dc_ReadAhead = NULL;
+    }
+
+    /* A failed load is not an error; the file is then read through the lock */
+    if (!fq->fq_Buffer && fq->fq_Info.ofi_Type < 0 && fq->fq_Info.ofi_Size > 0 &&
+        fq->fq_Info.ofi_Size <= ctx->dc_LoadCutoff) {
+        fq->fq_Buffer = OSLoadFile(fileName, ctx->dc_LoadCutoff, &fq->fq_BufferSize);
+    }
+
+    return TRUE;
+}
+
+/* Release everything held for a file */
+VOID CloseFileQuery(struct FileQuery *fq)
+{
+    if (!fq) {
+        return;
+    }
+
+    if (fq->fq_Object) {
+        DisposeDTObject(fq->fq_Object);
+        fq->fq_Object = NULL;
+    }
+
+    if (fq->fq_DataType && !fq->fq_Borrowed) {
+        ReleaseDataType(fq->fq_DataType);
+    }
+    fq->fq_DataType = NULL;
+    fq->fq_Borrowed = FALSE;
+    fq->fq_IdentifiedBy = IDBY_NONE;
+    fq->fq_MetadataOnly = FALSE;
+
+    OSFreeMem(fq->fq_Buffer);
+    fq->fq_Buffer = NULL;
+    fq->fq_BufferSize = 0;
+
+    OSUnLock(fq->fq_Lock);
+    fq->fq_Lock = NULL;
+}
+
+/* Whether a descriptor takes any file of its kind: the GID_SYSTEM ones, */
+/* and those such as "ascii" with no mask, no function and a "#?" pattern */
+static BOOL IsCatchAllType(struct DataType *dtn)
+{
+    struct DataTypeHeader *dth = dtn->dtn_Header;
+
+    if (dth->dth_GroupID == GID_SYSTEM) {
+        return TRUE;
+    }
+
+    return (BOOL)((dth->dth_MaskLen <= 0 || !dth->dth_Mask) && !dtn->dtn_FunctionName &&
+                  (!dth->dth_Pattern || strcmp(dth->dth_Pattern, "#?") == 0));
+}
+
+/* Identify the file, from memory when it was loaded */
+/* The DataType stays owned by the FileQuery */
+struct DataType *ObtainFileDataType(struct FileQuery *fq)
+{
+    struct DataType *dtn = NULL;
+    struct EClockVal clock;
+
+    if (!fq || !fq->fq_Lock) {
+        return NULL;
+    }
+
+    if (fq->fq_DataType) {
+        return fq->fq_DataType;
+    }
+
+    BeginPhase(&clock);
+
+    /* A file no descriptor took last time, unchanged since, is not tried */
+    if (IsUnknownFile(fq)) {
+        EndPhase(PHASE_OBTAIN, &clock);
+        fq->fq_IdentifiedBy = IDBY_UNKNOWN;
+        if (CurrentStats) {
+            CurrentStats->qs_IdentifiedBy = IDBY_UNKNOWN;
+        }
+        SetIoErr(ERROR_OBJECT_WRONG_TYPE);
+        return NULL;
+    }
+
+    /* FAST: the descriptors the extension names, checked by their masks */
+    if (fq->fq_Context->dc_Fast) {
+        if (fq->fq_Buffer) {
+            dtn = FastIdentify(fq->fq_Context, fq->fq_Name, fq->fq_Buffer, fq->fq_BufferSize);
+        } else {
+            UBYTE header[FAST_HEADER_SIZE];
+            BPTR fh = OSOpen(fq->fq_Name);
+
+            if (fh) {
+                LONG got = OSRead(fh, header, sizeof(header));
+
+                OSClose(fh);
+                if (got > 0) {
+                    dtn = FastIdentify(fq->fq_Context, fq->fq_Name, header, (ULONG)got);
+                }
+            }
+        }
+        if (dtn) {
+            fq->fq_IdentifiedBy = IDBY_EXTENSION;
+        }
+    }
+
+    /* The descriptors that identified most files so far are tried first */
+    if (!dtn && fq->fq_Buffer) {
+        dtn = PreIdentify(fq->fq_Context, fq->fq_Name, fq->fq_Buffer, fq->fq_BufferSize);
+        if (dtn) {
+            fq->fq_IdentifiedBy = IDBY_LEARNED;
+        }
+    }
+    fq->fq_Borrowed = (BOOL)(dtn != NULL);
+
+    if (!dtn && fq->fq_Buffer) {
+        struct TagItem tags[3];
+        tags[0].ti_Tag = DTA_SourceAddress;
+        tags[0].ti_Data = (ULONG)fq->fq_Buffer;
+        tags[1].ti_Tag = DTA_SourceSize;
+        tags[1].ti_Data = fq->fq_BufferSize;
+        tags[2].ti_Tag = TAG_DONE;
+
+        dtn = ObtainDataTypeA(DTST_MEMORY, NULL, tags);
+
+        /* Memory has no name, so a file whose descriptor matches on the */
+        /* file name alone falls to a catch-all binary or text type; ask */
+        /* again by lock */
+        if (dtn && IsCatchAllType(dtn)) {
+            ReleaseDataType(dtn);
+            dtn = NULL;
+        }
+    }
+
+    if (!dtn) {
+        dtn = ObtainDataTypeA(DTST_FILE, (APTR)fq->fq_Lock, NULL);
+    }
+
+    /* Remember files no descriptor recognises, but not ones that failed */
+    /* to be read */
+    if (!dtn) {
+        LONG error = IoErr();
+
+        if (error == 0 || error == ERROR_OBJECT_WRONG_TYPE) {
+            NoteUnknownFile(fq, TRUE);
+        }
+        SetIoErr(error);
+    } else {
+        NoteUnknownFile(fq, FALSE);
+    }
+
+    EndPhase(PHASE_OBTAIN, &clock);
+
+    if (dtn && !fq->fq_Borrowed) {
+        fq->fq_IdentifiedBy = IDBY_LIBRARY;
+    }
+    if (CurrentStats) {
+        CurrentStats->qs_IdentifiedBy = fq->fq_IdentifiedBy;
+    }
+
+    NoteHit(fq->fq_Context, dtn, fq->fq_Borrowed);
+
+    fq->fq_DataType = dtn;
+    return dtn;
+}
+
+/* Create a datatype object for the file, from memory when it was loaded */
+/* Extra tags are passed on to NewDTObjectA() */
+Object *NewFileObject(struct FileQuery *fq, struct TagItem *extraTags)
+{
+    Object *dtObject = NULL;
+    struct EClockVal clock;
+
+    if (!fq || !fq->fq_Name) {
+        SetIoErr(ERROR_REQUIRED_ARG_MISSING);
+        return NULL;
+    }
+
+    BeginPhase(&clock);
+
+    if (fq->fq_Buffer) {
+        struct TagItem tags[6];
+        tags[0].ti_Tag = DTA_SourceType;
+        tags[0].ti_Data = DTST_MEMORY;
+        tags[1].ti_Tag = DTA_SourceAddress;
+        tags[1].ti_Data = (ULONG)fq->fq_Buffer;
+        tags[2].ti_Tag = DTA_SourceSize;
+        tags[2].ti_Data = fq->fq_BufferSize;
+        /* Skip a second identification when the type is already known */
+        tags[3].ti_Tag = fq->fq_DataType ? DTA_DataType : TAG_IGNORE;
+        tags[3].ti_Data = (ULONG)fq->fq_DataType;
+        tags[4].ti_Tag = extraTags ? TAG_MORE : TAG_DONE;
+        tags[4].ti_Data = (ULONG)extraTags;
+        tags[5].ti_Tag = TAG_DONE;
+
+        dtObject = NewDTObjectA((APTR)fq->fq_Name, tags);
+    }
+
+    /* Not every class can decode from memory; fall back to the file */
+    if (!dtObject) {
+        dtObject = NewDTObjectA((APTR)fq->fq_Name, extraTags);
+    }
+
+    EndPhase(PHASE_DECODE, &clock);
+
+    return dtObject;
+}
+
+/* Return the decoded object for the file, creating it on first use */
+/* The object stays owned by the FileQuery and is disposed when it is closed */
+Object *GetFileObject(struct FileQuery *fq)
+{
+    if (!fq) {
+        SetIoErr(ERROR_REQUIRED_ARG_MISSING);
+        return NULL;
+    }
+
+    if (!fq->fq_Object && !fq->fq_ObjectError) {
+        /* A decode that would not fit is not tried; the header is the record */
+        if (!AdmitDecode(fq)) {
+            fq->fq_ObjectError = ERROR_NO_FREE_STORE;
+        } else {
+            fq->fq_Object = NewFileObject(fq, NULL);
+        }
+        if (!fq->fq_Object && !fq->fq_ObjectError) {
+            /* Remember the failure so later callers do not decode again */
+            fq->fq_ObjectError = IoErr();
+            if (fq->fq_ObjectError == 0) {
+                fq->fq_ObjectError = ERROR_OBJECT_NOT_FOUND;
+            }
+        }
+    }
+
+    if (!fq->fq_Object) {
+        SetIoErr(fq->fq_ObjectError);
+    }
+
+    return fq->fq_Object;
+}
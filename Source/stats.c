@@ -0,0 +1,412 @@
+/*
+ * DataType - per-phase timing and I/O counters
+ *
+ * Copyright (c) 2025 amigazen project
+ * Licensed under BSD 2-Clause License
+ */
+
+#include "datatype.h"
+#include <devices/timer.h>
+#include <proto/timer.h>
+
+struct Device *TimerBase = NULL;
+
+/* Statistics of the file being queried, or NULL when STATS is off */
+struct QueryStats *CurrentStats = NULL;
+
+static struct MsgPort *timerPort = NULL;
+static struct timerequest *timerReq = NULL;
+static ULONG eclockFreq = 0;
+static ULONG timerUsers = 0;
+
+static const STRPTR phaseNames[PHASE_COUNT] = {
+    (STRPTR)"obtain",
+    (STRPTR)"decode",
+    (STRPTR)"writeprobe",
+    (STRPTR)"deficons",
+    (STRPTR)"dtypscan",
+    (STRPTR)"convert"
+};
+
+/* Open timer.device so ReadEClock() can be used */
+/* Calls nest; each successful OpenTimer() needs a CloseTimer() */
+BOOL OpenTimer(VOID)
+{
+    struct EClockVal now;
+
+    if (TimerBase) {
+        timerUsers++;
+        return TRUE;
+    }
+
+    timerPort = CreateMsgPort();
+    if (!timerPort) {
+        return FALSE;
+    }
+
+    timerReq = (struct timerequest *)CreateIORequest(timerPort, sizeof(struct timerequest));
+    if (!timerReq) {
+        DeleteMsgPort(timerPort);
+        timerPort = NULL;
+        return FALSE;
+    }
+
+    if (OpenDevice(TIMERNAME, UNIT_ECLOCK, (struct IORequest *)timerReq, 0L) != 0) {
+        DeleteIORequest(timerReq);
+        timerReq = NULL;
+        DeleteMsgPort(timerPort);
+        timerPort = NULL;
+        return FALSE;
+    }
+
+    TimerBase = timerReq->tr_node.io_Device;
+    eclockFreq = ReadEClock(&now);
+    timerUsers = 1;
+
+    return TRUE;
+}
+
+/* Close timer.device once its last user is done */
+VOID CloseTimer(VOID)
+{
+    if (timerUsers > 1) {
+        timerUsers--;
+        return;
+    }
+    timerUsers = 0;
+
+    if (timerReq) {
+        if (TimerBase) {
+            CloseDevice((struct IORequest *)timerReq);
+            TimerBase = NULL;
+        }
+        DeleteIORequest(timerReq);
+        timerReq = NULL;
+    }
+
+    if (timerPort) {
+        DeleteMsgPort(timerPort);
+        timerPort = NULL;
+    }
+}
+
+/* EClock frequency in ticks per second */
+ULONG TimerFrequency(VOID)
+{
+    return eclockFreq;
+}
+
+/* Read the current EClock value */
+VOID ReadTimer(struct EClockVal *clock)
+{
+    if (TimerBase) {
+        ReadEClock(clock);
+    } else {
+        clock->ev_hi = 0;
+        clock->ev_lo = 0;
+    }
+}
+
+/* Microseconds elapsed since start, without 64-bit arithmetic */
+ULONG ElapsedMicros(struct EClockVal *start)
+{
+    struct EClockVal now;
+    ULONG ticks;
+    ULONG secs;
+    ULONG rem;
+    ULONG millis;
+
+    if (!TimerBase || eclockFreq == 0) {
+        return 0;
+    }
+
+    ReadEClock(&now);
+    ticks = now.ev_lo - start->ev_lo;
+
+    secs = ticks / eclockFreq;
+    rem = ticks % eclockFreq;
+    millis = (rem * 1000) / eclockFreq;
+    rem = (rem * 1000) % eclockFreq;
+
+    return secs * 1000000 + millis * 1000 + (rem * 1000) / eclockFreq;
+}
+
+/* Prepare for collecting statistics over up to maxFiles queries */
+/* The per-file records for the batch summary are kept in the context */
+BOOL InitStats(struct DTContext *ctx, ULONG maxFiles)
+{
+    if (!OpenTimer()) {
+        return FALSE;
+    }
+
+    ctx->dc_Stats = (struct QueryStats *)AllocVec(sizeof(struct QueryStats) * (maxFiles ? maxFiles : 1), MEMF_CLEAR);
+    if (!ctx->dc_Stats) {
+        CloseTimer();
+        SetIoErr(ERROR_NO_FREE_STORE);
+        return FALSE;
+    }
+
+    ctx->dc_StatsCount = 0;
+    ctx->dc_StatsMax = maxFiles ? maxFiles : 1;
+    ReadTimer(&ctx->dc_StatsStart);
+
+    return TRUE;
+}
+
+/* Release statistics resources */
+VOID FreeStats(struct DTContext *ctx)
+{
+    CurrentStats = NULL;
+
+    if (ctx->dc_Stats) {
+        FreeVec(ctx->dc_Stats);
+        ctx->dc_Stats = NULL;
+    }
+    ctx->dc_StatsCount = 0;
+    ctx->dc_StatsMax = 0;
+
+    CloseTimer();
+}
+
+/* Start collecting statistics for a new file */
+VOID BeginFileStats(struct DTContext *ctx)
+{
+    if (!ctx->dc_Stats || ctx->dc_StatsCount >= ctx->dc_StatsMax) {
+        CurrentStats = NULL;
+        return;
+    }
+
+    CurrentStats = &ctx->dc_Stats[ctx->dc_StatsCount];
+    ReadTimer(&CurrentStats->qs_Start);
+}
+
+/* Finish the current file and keep it for the batch summary */
+VOID EndFileStats(struct DTContext *ctx)
+{
+    if (!CurrentStats) {
+        return;
+    }
+
+    CurrentStats->qs_TotalMicros = ElapsedMicros(&CurrentStats->qs_Start);
+    ctx->dc_StatsCount++;
+    CurrentStats = NULL;
+}
+
+/* Start timing a phase of the current query */
+VOID BeginPhase(struct EClockVal *clock)
+{
+    if (CurrentStats) {
+        ReadTimer(clock);
+    }
+}
+
+/* Add the time since BeginPhase() to a phase of the current query */
+VOID EndPhase(UWORD phase, struct EClockVal *clock)
+{
+    if (CurrentStats && phase < PHASE_COUNT) {
+        CurrentStats->qs_PhaseMicros[phase] += ElapsedMicros(clock);
+        CurrentStats->qs_PhaseCalls[phase]++;
+    }
+}
+
+/* How a file was identified, by IDBY_ value */
+static STRPTR identifiedByNames[] = {
+    (STRPTR)"nothing", (STRPTR)"extension", (STRPTR)"learned mask", (STRPTR)"datatypes.library",
+    (STRPTR)"remembered as unknown"
+};
+
+/* Short name of a phase as printed in the statistics */
+STRPTR GetPhaseName(UWORD phase)
+{
+    return (phase < PHASE_COUNT) ? phaseNames[phase] : (STRPTR)"unknown";
+}
+
+/* Print a duration in milliseconds with three decimals */
+static VOID PrintMillis(ULONG micros)
+{
+    Printf("%lu.%03lu", micros / 1000, micros % 1000);
+}
+
+/* Print the breakdown of the most recently finished file */
+VOID PrintFileStats(struct DTContext *ctx, STRPTR fileName)
+{
+    struct QueryStats *qs;
+    ULONG other;
+    UWORD phase;
+
+    if (!ctx->dc_Stats || ctx->dc_StatsCount == 0) {
+        return;
+    }
+
+    qs = &ctx->dc_Stats[ctx->dc_StatsCount - 1];
+    other = qs->qs_TotalMicros;
+
+    Printf("Stats for %s: total ", fileName ? fileName : (STRPTR)"(Unknown file)");
+    PrintMillis(qs->qs_TotalMicros);
+    Printf(" ms\n ");
+
+    for (phase = 0; phase < PHASE_COUNT; phase++) {
+        Printf(" %s ", phaseNames[phase]);
+        PrintMillis(qs->qs_PhaseMicros[phase]);
+        if (other >= qs->qs_PhaseMicros[phase]) {
+            other -= qs->qs_PhaseMicros[phase];
+        } else {
+            other = 0;
+        }
+    }
+    Printf(" other ");
+    PrintMillis(other);
+    Printf("\n");
+
+    Printf("  locks %lu, opens %lu, reads %lu, bytes %lu, allocs %lu\n",
+           qs->qs_Locks, qs->qs_Opens, qs->qs_Reads, qs->qs_Bytes, qs->qs_Allocs);
+
+    if (qs->qs_RegistryRank > 0) {
+        Printf("  descriptors tested %lu, %lu in library order\n", qs->qs_Tested, qs->qs_RegistryRank);
+    }
+
+    if (qs->qs_IdentifiedBy != IDBY_NONE) {
+        Printf("  identified by %s\n", identifiedByNames[qs->qs_IdentifiedBy]);
+    }
+}
+
+/* Comparison function for sorting durations */
+static int CompareMicros(const void *a, const void *b)
+{
+    ULONG ma = *(const ULONG *)a;
+    ULONG mb = *(const ULONG *)b;
+
+    return (ma < mb) ? -1 : (ma > mb) ? 1 : 0;
+}
+
+/* Percentile of a sorted array (nearest rank) */
+static ULONG Percentile(ULONG *sorted, ULONG count, ULONG pct)
+{
+    ULONG rank;
+
+    if (count == 0) {
+        return 0;
+    }
+
+    rank = (pct * count + 99) / 100;
+    if (rank == 0) {
+        rank = 1;
+    }
+
+    return sorted[rank - 1];
+}
+
+/* Print one summary row: sum, mean and percentiles */
+static VOID PrintSummaryRow(STRPTR name, ULONG *values, ULONG count)
+{
+    ULONG sum = 0;
+    ULONG i;
+
+    for (i = 0; i < count; i++) {
+        sum += values[i];
+    }
+    qsort(values, count, sizeof(ULONG), CompareMicros);
+
+    Printf("  %-10s ", name);
+    PrintMillis(sum);
+    Printf("  ");
+    PrintMillis(sum / count);
+    Printf("  ");
+    PrintMillis(Percentile(values, count, 50));
+    Printf("  ");
+    PrintMillis(Percentile(values, count, 90));
+    Printf("  ");
+    PrintMillis(Percentile(values, count, 99));
+    Printf("  ");
+    PrintMillis(values[count - 1]);
+    Printf("\n");
+}
+
+/* Print the batch summary with percentiles over all files */
+VOID PrintBatchStats(struct DTContext *ctx)
+{
+    ULONG *values;
+    ULONG i;
+    UWORD phase;
+    ULONG locks = 0, opens = 0, reads = 0, bytes = 0, allocs = 0;
+    ULONG tested = 0, rank = 0, ranked = 0;
+    ULONG identified[IDBY_COUNT];
+    ULONG elapsed;
+
+    if (!ctx->dc_Stats || ctx->dc_StatsCount == 0) {
+        return;
+    }
+
+    values = (ULONG *)AllocVec(sizeof(ULONG) * ctx->dc_StatsCount, MEMF_ANY);
+    if (!values) {
+        return;
+    }
+
+    Printf("\nBatch summary: %lu file%s (times in ms)\n", ctx->dc_StatsCount, ctx->dc_StatsCount == 1 ? "" : "s");
+    Printf("  phase      total  mean  p50  p90  p99  max\n");
+
+    for (i = 0; i < ctx->dc_StatsCount; i++) {
+        values[i] = ctx->dc_Stats[i].qs_TotalMicros;
+    }
+    PrintSummaryRow((STRPTR)"query", values, ctx->dc_StatsCount);
+
+    for (phase = 0; phase < PHASE_COUNT; phase++) {
+        for (i = 0; i < ctx->dc_StatsCount; i++) {
+            values[i] = ctx->dc_Stats[i].qs_PhaseMicros[phase];
+        }
+        PrintSummaryRow(phaseNames[phase], values, ctx->dc_StatsCount);
+    }
+
+    memset(identified, 0, sizeof(identified));
+    for (i = 0; i < ctx->dc_StatsCount; i++) {
+        identified[ctx->dc_Stats[i].qs_IdentifiedBy]++;
+        locks += ctx->dc_Stats[i].qs_Locks;
+        opens += ctx->dc_Stats[i].qs_Opens;
+        reads += ctx->dc_Stats[i].qs_Reads;
+        bytes += ctx->dc_Stats[i].qs_Bytes;
+        allocs += ctx->dc_Stats[i].qs_Allocs;
+        if (ctx->dc_Stats[i].qs_RegistryRank > 0) {
+            tested += ctx->dc_Stats[i].qs_Tested;
+            rank += ctx->dc_Stats[i].qs_RegistryRank;
+            ranked++;
+        }
+    }
+    Printf("  locks %lu, opens %lu, reads %lu, bytes %lu, allocs %lu\n",
+           locks, opens, reads, bytes, allocs);
+
+    /* Library order is what every file cost before anything was learned */
+    if (ranked > 0) {
+        Printf("  descriptors per file %lu.%02lu, %lu.%02lu in library order\n",
+               tested / ranked, ((tested % ranked) * 100) / ranked,
+               rank / ranked, ((rank % ranked) * 100) / ranked);
+    }
+
+    /* FAST hit rate: files the extension decided, of those identified */
+    if (ctx->dc_Fast) {
+        ULONG total = identified[IDBY_EXTENSION] + identified[IDBY_LEARNED] + identified[IDBY_LIBRARY];
+
+        Printf("  identified by extension %lu, learned mask %lu, datatypes.library %lu",
+               identified[IDBY_EXTENSION], identified[IDBY_LEARNED], identified[IDBY_LIBRARY]);
+        if (total > 0) {
+            Printf(" (%lu%% by extension)", (identified[IDBY_EXTENSION] * 100) / total);
+        }
+        Printf("\n");
+    }
+
+    /* Files skipped as remembered unidentifiable */
+    if (identified[IDBY_UNKNOWN] > 0) {
+        Printf("  remembered as unknown %lu, not tried\n", identified[IDBY_UNKNOWN]);
+    }
+
+    /* Wall time of the whole batch, so ORDER=DISK and ORDER=ARGS compare */
+    elapsed = ElapsedMicros(&ctx->dc_StatsStart);
+    Printf("  batch ");
+    PrintMillis(elapsed);
+    if (elapsed >= 1000) {
+        Printf(" ms, %lu files/s\n", (ctx->dc_StatsCount * 1000) / (elapsed / 1000));
+    } else {
+        Printf(" ms\n");
+    }
+
+    FreeVec(values);
+}
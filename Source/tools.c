@@ -0,0 +1,335 @@
+/*
+ * DataType - tool resolution and DTYP descriptor parsing
+ *
+ * Copyright (c) 2025 amigazen project
+ * Licensed under BSD 2-Clause License
+ */
+
+#include "datatype.h"
+
+/* Get tool mode name */
+STRPTR GetToolModeName(UWORD toolWhich)
+{
+    switch (toolWhich) {
+        case TW_INFO:
+            return (STRPTR)"INFO";
+        case TW_BROWSE:
+            return (STRPTR)"VIEW";
+        case TW_EDIT:
+            return (STRPTR)"EDIT";
+        case TW_PRINT:
+            return (STRPTR)"PRINT";
+        case TW_MAIL:
+            return (STRPTR)"MAIL";
+        default:
+            return (STRPTR)"UNKNOWN";
+    }
+}
+
+/* Get launch type name */
+STRPTR GetLaunchTypeName(UWORD flags)
+{
+    UWORD launchType = flags & TF_LAUNCH_MASK;
+    
+    switch (launchType) {
+        case TF_SHELL:
+            return (STRPTR)"Shell";
+        case TF_WORKBENCH:
+            return (STRPTR)"Workbench";
+        case TF_RX:
+            return (STRPTR)"ARexx";
+        default:
+            return (STRPTR)"Unknown";
+    }
+}
+
+/* Find a tool node by type, or fall back to any available tool */
+struct ToolNode *FindToolByType(struct DTContext *ctx, struct DataType *dtn, UWORD toolType)
+{
+    struct ToolNode *tn = NULL;
+    struct List *toolList = NULL;
+    struct TagItem tags[2];
+    struct Tool fallbackTool;
+    BOOL fallbackSuccess = FALSE;
+    struct Node *node = NULL;
+    
+    if (!ctx || !dtn) {
+        return NULL;
+    }
+    
+    toolList = &dtn->dtn_ToolList;
+    
+    /* First try FindToolNodeA API for the preferred tool type */
+    if (!IsListEmpty(toolList)) {
+        tags[0].ti_Tag = TOOLA_Which;
+        tags[0].ti_Data = (ULONG)toolType;
+        tags[1].ti_Tag = TAG_DONE;
+        
+        tn = FindToolNodeA(toolList, tags);
+    }
+    
+    /* If API failed, fall back to parsing DTYP file directly */
+    if (!tn) {
+        fallbackSuccess = FindToolInDTYPFile(ctx, dtn, toolType, &fallbackTool);
+        if (fallbackSuccess && fallbackTool.tn_Program) {
+            /* Hand it out through the context's ToolNode, valid until the next call */
+            ctx->dc_ToolNode.tn_Tool = fallbackTool;
+            ctx->dc_ToolNode.tn_Node.ln_Succ = NULL;
+            ctx->dc_ToolNode.tn_Node.ln_Pred = NULL;
+            ctx->dc_ToolNode.tn_Length = sizeof(struct ToolNode);
+            tn = &ctx->dc_ToolNode;
+        }
+    }
+    
+    /* If preferred tool type not found, fall back to any available tool */
+    if (!tn && !IsListEmpty(toolList)) {
+        /* Iterate through tool list and return first available tool */
+        for (node = toolList->lh_Head; node->ln_Succ; node = node->ln_Succ) {
+            tn = (struct ToolNode *)node;
+            /* Check if this tool node has a valid program */
+            if (tn->tn_Tool.tn_Program && tn->tn_Tool.tn_Program[0] != '\0') {
+                /* Found an available tool - use it */
+                break;
+            }
+            tn = NULL;
+        }
+    }
+    
+    return tn;
+}
+
+/* Fill in the tools of a record in report order (INFO, VIEW, EDIT, PRINT, MAIL) */
+/* Each slot holds the tool FindToolByType() settles on, which may be a fallback */
+VOID GetRecordTools(struct DTContext *ctx, struct DataType *dtn, struct DTRecord *record)
+{
+    static const UWORD toolOrder[RECORD_TOOLS] = { TW_INFO, TW_BROWSE, TW_EDIT, TW_PRINT, TW_MAIL };
+    struct ToolNode *tn;
+    ULONG i;
+    
+    if (!dtn || !record) {
+        return;
+    }
+    
+    for (i = 0; i < RECORD_TOOLS; i++) {
+        record->dr_ToolWhich[i] = 0;
+        record->dr_ToolProgram[i][0] = '\0';
+        
+        tn = FindToolByType(ctx, dtn, toolOrder[i]);
+        if (tn && tn->tn_Tool.tn_Program) {
+            record->dr_ToolWhich[i] = tn->tn_Tool.tn_Which;
+            Strncpy(record->dr_ToolProgram[i], tn->tn_Tool.tn_Program, sizeof(record->dr_ToolProgram[i]));
+        }
+    }
+    
+    record->dr_Valid |= RECF_TOOLS;
+}
+
+/* Launch a tool for a file */
+VOID LaunchToolForFile(struct Tool *tool, STRPTR fileName)
+{
+    ULONG result = 0;
+    LONG errorCode = 0;
+    
+    if (!tool || !fileName) {
+        PrintFault(ERROR_BAD_NUMBER, "DataType");
+        return;
+    }
+    
+    /* Clear any previous error */
+    SetIoErr(0);
+    
+    /* Launch the tool using LaunchToolA */
+    /* The project parameter is the filename */
+    result = LaunchToolA(tool, fileName, NULL);
+    
+    errorCode = IoErr();
+    
+    if (result == 0 || errorCode != 0) {
+        Printf("Error: Failed to launch tool\n");
+        if (errorCode != 0) {
+            PrintFault(errorCode, "DataType");
+        } else {
+            Printf("LaunchToolA returned FALSE\n");
+        }
+    }
+}
+
+/* Find tool in DTYP file (fallback when FindToolNodeA fails) */
+/* toolOut->tn_Program points into the cache and must not be freed */
+BOOL FindToolInDTYPFile(struct DTContext *ctx, struct DataType *dtn, UWORD toolType, struct Tool *toolOut)
+{
+    struct CacheEntry *ce;
+    struct Tool parsed;
+    STRPTR baseName;
+    STRPTR dtypPath = NULL;
+    UBYTE key[64];
+    struct EClockVal clock;
+    
+    if (!dtn || !dtn->dtn_Header || !toolOut) {
+        return FALSE;
+    }
+    
+    baseName = dtn->dtn_Header->dth_BaseName;
+    if (!baseName) {
+        return FALSE;
+    }
+    
+    SNPrintf(key, sizeof(key), "%s/%lu", baseName, (ULONG)toolType);
+    ce = FindCacheEntry(ctx, CACHE_TOOL, (STRPTR)key);
+    if (!ce) {
+        BeginPhase(&clock);
+        
+        /* Find the DTYP file path using BaseName, remembering misses too */
+        ce = FindCacheEntry(ctx, CACHE_DTYPPATH, baseName);
+        if (ce) {
+            dtypPath = ce->ce_Data;
+        } else {
+            dtypPath = FindDTYPFilePath(baseName);
+            ce = AddCacheEntry(ctx, CACHE_DTYPPATH, baseName, 0, dtypPath);
+            OSFreeMem(dtypPath);
+            dtypPath = ce ? ce->ce_Data : NULL;
+        }
+        
+        /* Parse the DTYP file to find the tool */
+        parsed.tn_Program = NULL;
+        if (dtypPath && ParseToolFromDTYP(dtypPath, toolType, &parsed)) {
+            ce = AddCacheEntry(ctx, CACHE_TOOL, (STRPTR)key, ((ULONG)parsed.tn_Which << 16) | parsed.tn_Flags, parsed.tn_Program);
+            OSFreeMem(parsed.tn_Program);
+        } else {
+            ce = AddCacheEntry(ctx, CACHE_TOOL, (STRPTR)key, 0, NULL);
+        }
+        
+        EndPhase(PHASE_DTYPSCAN, &clock);
+    }
+    
+    if (!ce || !ce->ce_Data) {
+        return FALSE;
+    }
+    
+    toolOut->tn_Which = (UWORD)(ce->ce_Value >> 16);
+    toolOut->tn_Flags = (UWORD)(ce->ce_Value & 0xFFFF);
+    toolOut->tn_Program = ce->ce_Data;
+    
+    return TRUE;
+}
+
+/* Find DTYP file path for a given BaseName */
+/* Returns an OSAllocMem()'d path, or NULL if no descriptor matches */
+STRPTR FindDTYPFilePath(STRPTR baseName)
+{
+    struct OSDir *dir = NULL;
+    struct OSDirEntry entry;
+    STRPTR datatypesPath = "DEVS:Datatypes";
+    STRPTR resultPath = NULL;
+    LONG baseLen;
+    
+    if (!baseName) {
+        return NULL;
+    }
+    
+    /* Open the datatypes directory; the filesystem leaves out the icons */
+    dir = OSOpenDir(datatypesPath, OSDIRF_NOINFO, NULL);
+    if (!dir) {
+        return NULL;
+    }
+    
+    baseLen = strlen(baseName);
+    
+    /* Scan directory for matching file */
+    while (OSNextDirEntry(dir, &entry)) {
+        STRPTR fileName = entry.ode_Name;
+        LONG nameLen = strlen(fileName);
+        
+        /* Skip directories - all other files are datatype descriptors */
+        if (entry.ode_Type >= 0 || nameLen == 0) {
+            continue;
+        }
+        
+        /* Check if the filename starts with BaseName (case-insensitive) */
+        if (baseLen <= nameLen && Strnicmp(fileName, baseName, baseLen) == 0) {
+            /* Found matching file - build full path */
+            LONG pathLen = strlen(datatypesPath) + 1 + nameLen + 1;
+            
+            resultPath = (STRPTR)OSAllocMem(pathLen);
+            if (resultPath) {
+                Strncpy(resultPath, datatypesPath, pathLen);
+                AddPart(resultPath, fileName, pathLen);
+            }
+            break;
+        }
+    }
+    
+    /* Cleanup */
+    OSCloseDir(dir);
+    
+    return resultPath;
+}
+
+/* Parse tool from DTYP file */
+/* The descriptor is loaded with a single read and its chunks are walked in memory */
+BOOL ParseToolFromDTYP(STRPTR dtypPath, UWORD toolType, struct Tool *toolOut)
+{
+    UBYTE *buffer = NULL;
+    ULONG bufferSize = 0;
+    struct IFFView view;
+    struct IFFChunk chunk;
+    BOOL result = FALSE;
+    
+    if (!dtypPath || !toolOut) {
+        return FALSE;
+    }
+    
+    /* Load the whole descriptor */
+    buffer = OSLoadFile(dtypPath, DTYP_MAX_SIZE, &bufferSize);
+    if (!buffer) {
+        return FALSE;
+    }
+    
+    if (InitIFFView(&view, buffer, bufferSize) && view.iv_Type == ID_DTYP) {
+        /* Look at each DTTL chunk; each one holds a struct Tool followed by strings */
+        while (FindIFFChunk(&view, ID_DTTL, &chunk)) {
+            UWORD toolWhich;
+            ULONG programOffset;
+            
+            if (chunk.ic_Size < DTTL_TOOL_SIZE) {
+                continue;
+            }
+            
+            /* Check if this is the tool type we're looking for */
+            toolWhich = GetIFFWord(chunk.ic_Data);
+            if (toolWhich != toolType) {
+                continue;
+            }
+            
+            /* Extract program name from offset, bounded by the chunk */
+            programOffset = GetIFFLong(chunk.ic_Data + 4);
+            if (programOffset >= DTTL_TOOL_SIZE && programOffset < chunk.ic_Size) {
+                STRPTR programName = (STRPTR)(chunk.ic_Data + programOffset);
+                ULONG maxLen = chunk.ic_Size - programOffset;
+                ULONG progLen = 0;
+                STRPTR progCopy;
+                
+                while (progLen < maxLen && programName[progLen] != '\0') {
+                    progLen++;
+                }
+                
+                /* Copy the name out, since the buffer is freed below */
+                progCopy = (STRPTR)OSAllocMem(progLen + 1);
+                if (progCopy) {
+                    CopyMem(programName, progCopy, progLen);
+                    progCopy[progLen] = '\0';
+                    toolOut->tn_Which = toolWhich;
+                    toolOut->tn_Flags = GetIFFWord(chunk.ic_Data + 2);
+                    toolOut->tn_Program = progCopy;
+                    result = TRUE;
+                }
+            }
+            break;
+        }
+    }
+    
+    /* Cleanup */
+    OSFreeMem(buffer);
+    
+    return result;
+}
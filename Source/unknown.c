@@ -0,0 +1,369 @@
+/*
+ * DataType - remembered unidentifiable files
+ *
+ * Copyright (c) 2025 amigazen project
+ * Licensed under BSD 2-Clause License
+ */
+
+#include "datatype.h"
+
+/*
+ * A file no descriptor recognises is the dearest to identify, because
+ * ObtainDataTypeA() tries every one of them before giving up, and it is
+ * tried again on every run. Such files are remembered in UNKNOWN_FILE by
+ * full path, size and datestamp, and are reported as unidentified
+ * without asking the library while all three still match.
+ *
+ * The first line of the file is the DEVS:Datatypes datestamp the entries
+ * were made under. Installing or removing a descriptor changes it, and
+ * then every entry is dropped, since the new descriptor may recognise
+ * them. Entries are kept sorted by a hash of the file name alone, so a
+ * file is only looked up by its full path if one with the same name,
+ * size and date is remembered.
+ */
+
+/* Hash of a file name, ignoring case as the filing systems do */
+static ULONG HashName(STRPTR name)
+{
+    ULONG hash = 2166136261UL;
+
+    while (*name) {
+        hash ^= ToLower((ULONG)(UBYTE)*name++);
+        hash *= 16777619UL;
+    }
+
+    return hash;
+}
+
+/* First entry whose hash is not below hash */
+static ULONG FirstWithHash(struct DTContext *ctx, ULONG hash)
+{
+    ULONG low = 0;
+    ULONG high = ctx->dc_UnknownCount;
+
+    while (low < high) {
+        ULONG middle = (low + high) / 2;
+
+        if (ctx->dc_Unknown[middle].uf_Hash < hash) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+
+    return low;
+}
+
+/* Add an entry in hash order; path is taken over, not copied */
+static BOOL InsertUnknown(struct DTContext *ctx, STRPTR path, BOOL allocated, ULONG size, struct DateStamp *date)
+{
+    struct UnknownFile *uf;
+    ULONG hash = HashName(FilePart(path));
+    ULONG index;
+
+    /* Room for twice as many when full */
+    if (ctx->dc_UnknownCount == ctx->dc_UnknownMax) {
+        ULONG max = ctx->dc_UnknownMax ? ctx->dc_UnknownMax * 2 : 64;
+        struct UnknownFile *table = (struct UnknownFile *)OSAllocMem(sizeof(struct UnknownFile) * max);
+
+        if (!table) {
+            return FALSE;
+        }
+        if (ctx->dc_Unknown) {
+            CopyMem(ctx->dc_Unknown, table, sizeof(struct UnknownFile) * ctx->dc_UnknownCount);
+            OSFreeMem(ctx->dc_Unknown);
+        }
+        ctx->dc_Unknown = table;
+        ctx->dc_UnknownMax = max;
+    }
+
+    index = FirstWithHash(ctx, hash);
+    memmove(&ctx->dc_Unknown[index + 1], &ctx->dc_Unknown[index],
+            sizeof(struct UnknownFile) * (ctx->dc_UnknownCount - index));
+    ctx->dc_UnknownCount++;
+
+    uf = &ctx->dc_Unknown[index];
+    uf->uf_Hash = hash;
+    uf->uf_Size = size;
+    uf->uf_Date = *date;
+    uf->uf_Path = path;
+    uf->uf_Allocated = allocated;
+
+    return TRUE;
+}
+
+/* Read the next number of a line; NULL if there is none */
+static UBYTE *ParseNumber(UBYTE *p, LONG *value)
+{
+    LONG used = StrToLong(p, value);
+
+    if (used <= 0) {
+        return NULL;
+    }
+    p += used;
+    while (*p == ' ') {
+        p++;
+    }
+
+    return p;
+}
+
+/* Load UNKNOWN_FILE, unless DEVS:Datatypes has changed since it was written */
+static VOID LoadUnknownFiles(struct DTContext *ctx)
+{
+    struct OSFileInfo info;
+    struct DateStamp date;
+    UBYTE *text;
+    UBYTE *line;
+    UBYTE *next;
+    UBYTE *p;
+    ULONG size;
+    LONG value;
+    LONG fileSize;
+
+    ctx->dc_UnknownLoaded = TRUE;
+
+    if (!OSExamine((STRPTR)"DEVS:Datatypes", &info)) {
+        return;
+    }
+    ctx->dc_UnknownStamp = info.ofi_Date;
+
+    text = OSLoadFile((STRPTR)UNKNOWN_FILE, UNKNOWN_MAX_SIZE, &size);
+    if (!text) {
+        return;
+    }
+
+    for (line = text; *line; line = next) {
+        for (next = line; *next && *next != '\n'; next++) {
+        }
+        if (*next) {
+            *next++ = '\0';
+        }
+
+        /* The first line is the DEVS:Datatypes datestamp */
+        if (line == text) {
+            if (!(p = ParseNumber(line, &value)) || value != ctx->dc_UnknownStamp.ds_Days ||
+                !(p = ParseNumber(p, &value)) || value != ctx->dc_UnknownStamp.ds_Minute ||
+                !(p = ParseNumber(p, &value)) || value != ctx->dc_UnknownStamp.ds_Tick) {
+                /* Written under other descriptors: rewrite it empty */
+                ctx->dc_UnknownDirty = TRUE;
+                break;
+            }
+            continue;
+        }
+
+        /* Then "size days minute tick path" per file */
+        if (!(p = ParseNumber(line, &fileSize)) ||
+            !(p = ParseNumber(p, &value))) {
+            continue;
+        }
+        date.ds_Days = value;
+        if (!(p = ParseNumber(p, &value))) {
+            continue;
+        }
+        date.ds_Minute = value;
+        if (!(p = ParseNumber(p, &value)) || !*p) {
+            continue;
+        }
+        date.ds_Tick = value;
+
+        InsertUnknown(ctx, (STRPTR)p, FALSE, (ULONG)fileSize, &date);
+    }
+
+    /* Loaded entries point into the text */
+    if (ctx->dc_UnknownCount > 0) {
+        ctx->dc_UnknownText = text;
+    } else {
+        OSFreeMem(text);
+    }
+}
+
+/* Index of the entry for the file, or -1; with unchanged, only if its */
+/* size and date are the same. path is filled in from the lock the first */
+/* time it is needed */
+static LONG FindUnknown(struct FileQuery *fq, BOOL unchanged, UBYTE *path, BOOL *havePath)
+{
+    struct DTContext *ctx = fq->fq_Context;
+    ULONG hash = HashName(FilePart(fq->fq_Name));
+    ULONG i;
+
+    for (i = FirstWithHash(ctx, hash); i < ctx->dc_UnknownCount && ctx->dc_Unknown[i].uf_Hash == hash; i++) {
+        struct UnknownFile *uf = &ctx->dc_Unknown[i];
+
+        if (unchanged && (uf->uf_Size != fq->fq_Info.ofi_Size ||
+                          CompareDates(&uf->uf_Date, &fq->fq_Info.ofi_Date) != 0)) {
+            continue;
+        }
+        if (!*havePath) {
+            if (!OSNameFromLock(fq->fq_Lock, (STRPTR)path, UNKNOWN_PATH_SIZE)) {
+                return -1;
+            }
+            *havePath = TRUE;
+        }
+        if (Stricmp(uf->uf_Path, (STRPTR)path) == 0) {
+            return (LONG)i;
+        }
+    }
+
+    return -1;
+}
+
+/* Whether the file is remembered as unidentifiable, unchanged since */
+BOOL IsUnknownFile(struct FileQuery *fq)
+{
+    struct DTContext *ctx = fq->fq_Context;
+    UBYTE path[UNKNOWN_PATH_SIZE];
+    BOOL havePath = FALSE;
+
+    if (!ctx->dc_UnknownLoaded) {
+        LoadUnknownFiles(ctx);
+    }
+    if (ctx->dc_UnknownCount == 0) {
+        return FALSE;
+    }
+
+    return (BOOL)(FindUnknown(fq, TRUE, path, &havePath) >= 0);
+}
+
+/* Remember a file that could not be identified, or forget one that now was */
+VOID NoteUnknownFile(struct FileQuery *fq, BOOL unknown)
+{
+    struct DTContext *ctx = fq->fq_Context;
+    UBYTE path[UNKNOWN_PATH_SIZE];
+    BOOL havePath = FALSE;
+    LONG index;
+
+    if (!ctx->dc_UnknownLoaded) {
+        LoadUnknownFiles(ctx);
+    }
+    if (!unknown && ctx->dc_UnknownCount == 0) {
+        return;
+    }
+
+    index = FindUnknown(fq, FALSE, path, &havePath);
+
+    if (index >= 0) {
+        struct UnknownFile *uf = &ctx->dc_Unknown[index];
+
+        if (unknown) {
+            /* Changed, and still not identified */
+            uf->uf_Size = fq->fq_Info.ofi_Size;
+            uf->uf_Date = fq->fq_Info.ofi_Date;
+        } else {
+            if (uf->uf_Allocated) {
+                OSFreeMem(uf->uf_Path);
+            }
+            ctx->dc_UnknownCount--;
+            memmove(uf, uf + 1, sizeof(struct UnknownFile) * (ctx->dc_UnknownCount - (ULONG)index));
+        }
+        ctx->dc_UnknownDirty = TRUE;
+        return;
+    }
+
+    if (!unknown) {
+        return;
+    }
+
+    if (!havePath && !OSNameFromLock(fq->fq_Lock, (STRPTR)path, sizeof(path))) {
+        return;
+    }
+
+    /* One path per line in UNKNOWN_FILE */
+    if (!strchr((char *)path, '\n')) {
+        ULONG length = strlen((char *)path) + 1;
+        STRPTR copy = (STRPTR)OSAllocMem(length);
+
+        if (copy) {
+            CopyMem(path, copy, length);
+            if (InsertUnknown(ctx, copy, TRUE, fq->fq_Info.ofi_Size, &fq->fq_Info.ofi_Date)) {
+                ctx->dc_UnknownDirty = TRUE;
+            } else {
+                OSFreeMem(copy);
+            }
+        }
+    }
+}
+
+/* Drop every entry if DEVS:Datatypes has changed since they were made */
+/* Entries not loaded yet are checked when they are */
+VOID ForgetUnknownFiles(struct DTContext *ctx)
+{
+    struct OSFileInfo info;
+
+    if (!ctx || !ctx->dc_UnknownLoaded || !OSExamine((STRPTR)"DEVS:Datatypes", &info) ||
+        CompareDates(&info.ofi_Date, &ctx->dc_UnknownStamp) == 0) {
+        return;
+    }
+
+    FreeUnknownFiles(ctx);
+    ctx->dc_UnknownStamp = info.ofi_Date;
+    ctx->dc_UnknownLoaded = TRUE;
+    ctx->dc_UnknownDirty = TRUE;
+}
+
+/* Write the entries back to UNKNOWN_FILE if they have changed */
+/* As with the hit counters, a temporary file is renamed over it, so a */
+/* failed write keeps the old list and leaves it to be saved another time */
+VOID SaveUnknownFiles(struct DTContext *ctx)
+{
+    UBYTE tempName[TEMP_NAME_SIZE];
+    BOOL result = FALSE;
+    BPTR fh;
+    ULONG i;
+
+    if (!ctx || !ctx->dc_UnknownDirty) {
+        return;
+    }
+
+    /* ENVARC:DataType may not exist yet */
+    if (!OSCreateDir((STRPTR)HITS_DIR)) {
+        return;
+    }
+
+    fh = OSCreateTemp((STRPTR)UNKNOWN_FILE, tempName, sizeof(tempName), 0);
+    if (!fh) {
+        return;
+    }
+
+    FPrintf(fh, "%ld %ld %ld\n", ctx->dc_UnknownStamp.ds_Days, ctx->dc_UnknownStamp.ds_Minute,
+            ctx->dc_UnknownStamp.ds_Tick);
+    for (i = 0; i < ctx->dc_UnknownCount; i++) {
+        struct UnknownFile *uf = &ctx->dc_Unknown[i];
+
+        FPrintf(fh, "%lu %ld %ld %ld %s\n", uf->uf_Size, uf->uf_Date.ds_Days, uf->uf_Date.ds_Minute,
+                uf->uf_Date.ds_Tick, uf->uf_Path);
+    }
+
+    if (OSClose(fh)) {
+        result = OSCommitTemp((STRPTR)tempName, (STRPTR)UNKNOWN_FILE);
+    }
+    if (result) {
+        ctx->dc_UnknownDirty = FALSE;
+    } else {
+        OSDelete((STRPTR)tempName);
+    }
+}
+
+/* Release the entries without saving them */
+VOID FreeUnknownFiles(struct DTContext *ctx)
+{
+    ULONG i;
+
+    if (!ctx) {
+        return;
+    }
+
+    for (i = 0; i < ctx->dc_UnknownCount; i++) {
+        if (ctx->dc_Unknown[i].uf_Allocated) {
+            OSFreeMem(ctx->dc_Unknown[i].uf_Path);
+        }
+    }
+
+    OSFreeMem(ctx->dc_Unknown);
+    OSFreeMem(ctx->dc_UnknownText);
+    ctx->dc_Unknown = NULL;
+    ctx->dc_UnknownText = NULL;
+    ctx->dc_UnknownCount = 0;
+    ctx->dc_UnknownMax = 0;
+    ctx->dc_UnknownLoaded = FALSE;
+}
@@ -0,0 +1,1038 @@
+/*
+ * DataType - watched directories and their result index
+ *
+ * Copyright (c) 2025 amigazen project
+ * Licensed under BSD 2-Clause License
+ */
+
+#include "datatype.h"
+
+/*
+ * WATCH keeps an index of what every file below some directories is,
+ * and keeps it current for as long as it runs. The first scan walks the
+ * trees, but only identifies files the index does not already hold at
+ * their present size and datestamp. After that each directory has a DOS
+ * notification, and a change makes the filesystem send a message naming
+ * the directory, not the file; that directory alone is read again and
+ * compared with the index. Messages are let settle for
+ * WATCH_SETTLE_TICKS so a copy of many files is one scan, not one per
+ * file, so the work follows what changed rather than the size of the
+ * trees.
+ *
+ * The index file is a journal: a line per file identified, "+ size days
+ * minute tick group width height depth frames rate length basename path",
+ * and "- path" for one removed, so an update only ever appends. A later
+ * line for a path replaces an earlier one. The first line is the
+ * DEVS:Datatypes datestamp, as for UNKNOWN_FILE; under other descriptors
+ * everything is identified again. Once the journal holds more than two
+ * lines per file it is rewritten with one.
+ *
+ * The index and a CATALOG may be inside a watched tree. Writing them
+ * would then notify their directory, and identifying them again would
+ * write them again, for ever, so they and the temporary and backup files
+ * OSCreateTemp() and OSCommitTemp() make beside them are left out.
+ * Without a name the index is only held in memory, for a run that writes
+ * a CATALOG alone.
+ */
+
+/* Read the next number of a line; NULL if there is none */
+static UBYTE *ParseNumber(UBYTE *p, LONG *value)
+{
+    LONG used = StrToLong(p, value);
+
+    if (used <= 0) {
+        return NULL;
+    }
+    p += used;
+    while (*p == ' ') {
+        p++;
+    }
+
+    return p;
+}
+
+/* The part of path below dir, or NULL if it is not below it */
+static STRPTR PathBelow(STRPTR dir, ULONG dirLen, STRPTR path)
+{
+    STRPTR rest;
+
+    if (Strnicmp(path, dir, dirLen) != 0) {
+        return NULL;
+    }
+
+    if (dirLen > 0 && (dir[dirLen - 1] == ':' || dir[dirLen - 1] == '/')) {
+        rest = path + dirLen;
+    } else if (path[dirLen] == '/') {
+        rest = path + dirLen + 1;
+    } else {
+        return NULL;
+    }
+
+    return *rest ? rest : NULL;
+}
+
+/* Order of entries: by path, then by journal line */
+static int CompareEntries(const void *a, const void *b)
+{
+    const struct IndexEntry *ea = (const struct IndexEntry *)a;
+    const struct IndexEntry *eb = (const struct IndexEntry *)b;
+    LONG order = Stricmp(ea->ie_Path, eb->ie_Path);
+
+    if (order != 0) {
+        return (order < 0) ? -1 : 1;
+    }
+    if (ea->ie_Sequence != eb->ie_Sequence) {
+        return (ea->ie_Sequence < eb->ie_Sequence) ? -1 : 1;
+    }
+    return 0;
+}
+
+/* First sorted entry whose path is not below path in order */
+static ULONG FirstEntryFrom(struct WatchIndex *wi, STRPTR path)
+{
+    ULONG low = 0;
+    ULONG high = wi->wi_Sorted;
+
+    while (low < high) {
+        ULONG middle = (low + high) / 2;
+
+        if (Stricmp(wi->wi_Entries[middle].ie_Path, path) < 0) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+
+    return low;
+}
+
+/* Add an entry for path at index, or after all the others if defer */
+/* Deferred entries are left out of lookups until SortEntries() */
+static struct IndexEntry *AddEntry(struct WatchIndex *wi, STRPTR path, ULONG index, BOOL defer)
+{
+    struct IndexEntry *ie;
+    ULONG length = strlen(path) + 1;
+    STRPTR copy;
+
+    /* Room for twice as many when full */
+    if (wi->wi_Count == wi->wi_Max) {
+        ULONG max = wi->wi_Max ? wi->wi_Max * 2 : 256;
+        struct IndexEntry *table = (struct IndexEntry *)OSAllocMem(sizeof(struct IndexEntry) * max);
+
+        if (!table) {
+            return NULL;
+        }
+        if (wi->wi_Entries) {
+            CopyMem(wi->wi_Entries, table, sizeof(struct IndexEntry) * wi->wi_Count);
+            OSFreeMem(wi->wi_Entries);
+        }
+        wi->wi_Entries = table;
+        wi->wi_Max = max;
+    }
+
+    copy = (STRPTR)OSAllocMem(length);
+    if (!copy) {
+        return NULL;
+    }
+    CopyMem(path, copy, length);
+
+    if (defer) {
+        index = wi->wi_Count;
+    } else {
+        memmove(&wi->wi_Entries[index + 1], &wi->wi_Entries[index],
+                sizeof(struct IndexEntry) * (wi->wi_Count - index));
+        wi->wi_Sorted++;
+    }
+    wi->wi_Count++;
+
+    ie = &wi->wi_Entries[index];
+    memset(ie, 0, sizeof(struct IndexEntry));
+    ie->ie_Path = copy;
+
+    return ie;
+}
+
+/* Take an entry out, noting it in the journal if journal */
+static VOID RemoveEntry(struct WatchIndex *wi, ULONG index, BOOL journal)
+{
+    struct IndexEntry *ie = &wi->wi_Entries[index];
+
+    if (journal && wi->wi_Journal) {
+        FPrintf(wi->wi_Journal, "- %s\n", ie->ie_Path);
+        wi->wi_JournalLines++;
+        wi->wi_Removed++;
+    }
+
+    OSFreeMem(ie->ie_Path);
+    wi->wi_Count--;
+    if (index < wi->wi_Sorted) {
+        wi->wi_Sorted--;
+    }
+    memmove(ie, ie + 1, sizeof(struct IndexEntry) * (wi->wi_Count - index));
+}
+
+/* Bring deferred entries into order: sort them, then merge them in from */
+/* the end, so a few new ones do not cost a sort of the whole index */
+static VOID SortEntries(struct WatchIndex *wi)
+{
+    struct IndexEntry *entries = wi->wi_Entries;
+    struct IndexEntry *tail;
+    ULONG tailCount = wi->wi_Count - wi->wi_Sorted;
+    ULONG i;
+    ULONG j;
+    ULONG k;
+
+    if (tailCount == 0) {
+        return;
+    }
+
+    qsort(&entries[wi->wi_Sorted], tailCount, sizeof(struct IndexEntry), CompareEntries);
+
+    if (wi->wi_Sorted > 0) {
+        tail = (struct IndexEntry *)OSAllocMem(sizeof(struct IndexEntry) * tailCount);
+        if (tail) {
+            CopyMem(&entries[wi->wi_Sorted], tail, sizeof(struct IndexEntry) * tailCount);
+            i = wi->wi_Sorted;
+            j = tailCount;
+            k = wi->wi_Count;
+            while (j > 0) {
+                if (i > 0 && CompareEntries(&entries[i - 1], &tail[j - 1]) > 0) {
+                    entries[--k] = entries[--i];
+                } else {
+                    entries[--k] = tail[--j];
+                }
+            }
+            OSFreeMem(tail);
+        } else {
+            qsort(entries, wi->wi_Count, sizeof(struct IndexEntry), CompareEntries);
+        }
+    }
+
+    wi->wi_Sorted = wi->wi_Count;
+}
+
+/* Over the entries below dir, or only those directly in it: clear their */
+/* seen flags, or remove those not seen since */
+static VOID SweepEntries(struct WatchIndex *wi, STRPTR dir, BOOL childrenOnly, BOOL remove)
+{
+    ULONG dirLen = strlen(dir);
+    ULONG i = FirstEntryFrom(wi, dir);
+    STRPTR rest;
+
+    /* Everything starting with dir is together in the sorted entries */
+    while (i < wi->wi_Sorted && Strnicmp(wi->wi_Entries[i].ie_Path, dir, dirLen) == 0) {
+        struct IndexEntry *ie = &wi->wi_Entries[i];
+
+        rest = PathBelow(dir, dirLen, ie->ie_Path);
+        if (rest && (!childrenOnly || !strchr((char *)rest, '/'))) {
+            if (!remove) {
+                ie->ie_Seen = FALSE;
+            } else if (!ie->ie_Seen) {
+                RemoveEntry(wi, i, TRUE);
+                continue;
+            }
+        }
+        i++;
+    }
+}
+
+/* Note an entry in the journal */
+static VOID JournalEntry(struct WatchIndex *wi, struct IndexEntry *ie)
+{
+    if (!wi->wi_Journal) {
+        return;
+    }
+
+    FPrintf(wi->wi_Journal, "+ %lu %ld %ld %ld %lu %lu %lu %lu %lu %lu %lu %s %s\n",
+            ie->ie_Size, ie->ie_Date.ds_Days, ie->ie_Date.ds_Minute, ie->ie_Date.ds_Tick,
+            ie->ie_GroupID, ie->ie_Width, ie->ie_Height, ie->ie_Depth, ie->ie_Frames,
+            ie->ie_SamplesPerSec, ie->ie_SampleLength,
+            ie->ie_BaseName[0] ? (STRPTR)ie->ie_BaseName : (STRPTR)"-", ie->ie_Path);
+    wi->wi_JournalLines++;
+}
+
+/* Note the DEVS:Datatypes datestamp as the journal's first line */
+static VOID JournalStamp(struct WatchIndex *wi)
+{
+    FPrintf(wi->wi_Journal, "# %ld %ld %ld\n", wi->wi_Stamp.ds_Days, wi->wi_Stamp.ds_Minute,
+            wi->wi_Stamp.ds_Tick);
+    wi->wi_JournalLines++;
+}
+
+/* Read an entry line of the journal after its "+ " */
+static BOOL ParseEntry(struct WatchIndex *wi, UBYTE *p, ULONG sequence)
+{
+    struct IndexEntry *ie;
+    LONG values[11];
+    UBYTE *baseName;
+    ULONG i;
+
+    for (i = 0; i < 11; i++) {
+        if (!(p = ParseNumber(p, &values[i]))) {
+            return FALSE;
+        }
+    }
+
+    /* Then the BaseName and the path, which may have spaces */
+    baseName = p;
+    while (*p && *p != ' ') {
+        p++;
+    }
+    if (*p != ' ' || !p[1]) {
+        return FALSE;
+    }
+    *p++ = '\0';
+
+    ie = AddEntry(wi, (STRPTR)p, 0, TRUE);
+    if (!ie) {
+        return FALSE;
+    }
+    ie->ie_Size = (ULONG)values[0];
+    ie->ie_Date.ds_Days = values[1];
+    ie->ie_Date.ds_Minute = values[2];
+    ie->ie_Date.ds_Tick = values[3];
+    ie->ie_GroupID = (ULONG)values[4];
+    ie->ie_Width = (ULONG)values[5];
+    ie->ie_Height = (ULONG)values[6];
+    ie->ie_Depth = (ULONG)values[7];
+    ie->ie_Frames = (ULONG)values[8];
+    ie->ie_SamplesPerSec = (ULONG)values[9];
+    ie->ie_SampleLength = (ULONG)values[10];
+    if (strcmp((char *)baseName, "-") != 0) {
+        Strncpy(ie->ie_BaseName, (STRPTR)baseName, sizeof(ie->ie_BaseName));
+    }
+    ie->ie_Sequence = sequence;
+
+    return TRUE;
+}
+
+/* Load the journal, keeping the last line for each path */
+static VOID LoadWatchIndex(struct WatchIndex *wi)
+{
+    UBYTE *line;
+    UBYTE *p;
+    BPTR fh;
+    LONG value;
+    ULONG sequence = 0;
+    ULONG i;
+    ULONG kept;
+
+    fh = OSOpen(wi->wi_Name);
+    if (!fh) {
+        return;
+    }
+
+    line = (UBYTE *)OSAllocMem(WATCH_LINE_SIZE);
+    if (!line) {
+        OSClose(fh);
+        return;
+    }
+
+    while (FGets(fh, (STRPTR)line, WATCH_LINE_SIZE)) {
+        for (p = line; *p && *p != '\n'; p++) {
+        }
+        *p = '\0';
+
+        /* The first line is the DEVS:Datatypes datestamp */
+        if (wi->wi_JournalLines++ == 0) {
+            if (line[0] != '#' ||
+                !(p = ParseNumber(line + 1, &value)) || value != wi->wi_Stamp.ds_Days ||
+                !(p = ParseNumber(p, &value)) || value != wi->wi_Stamp.ds_Minute ||
+                !ParseNumber(p, &value) || value != wi->wi_Stamp.ds_Tick) {
+                /* Made under other descriptors: start again */
+                wi->wi_Compact = TRUE;
+                break;
+            }
+            continue;
+        }
+
+        if (line[0] == '+' && line[1] == ' ') {
+            ParseEntry(wi, line + 2, sequence++);
+        } else if (line[0] == '-' && line[1] == ' ' && line[2]) {
+            struct IndexEntry *ie = AddEntry(wi, (STRPTR)line + 2, 0, TRUE);
+
+            if (ie) {
+                ie->ie_Removed = TRUE;
+                ie->ie_Sequence = sequence++;
+            }
+        }
+    }
+
+    OSFreeMem(line);
+    OSClose(fh);
+
+    /* Each path's lines are now together, oldest first */
+    SortEntries(wi);
+    kept = 0;
+    for (i = 0; i < wi->wi_Count; i++) {
+        struct IndexEntry *ie = &wi->wi_Entries[i];
+
+        if ((i + 1 < wi->wi_Count && Stricmp(ie->ie_Path, ie[1].ie_Path) == 0) || ie->ie_Removed) {
+            OSFreeMem(ie->ie_Path);
+            continue;
+        }
+        ie->ie_Sequence = 0;
+        wi->wi_Entries[kept++] = *ie;
+    }
+    wi->wi_Count = kept;
+    wi->wi_Sorted = kept;
+}
+
+/* Rewrite the journal with one line per file */
+static BOOL CompactWatchIndex(struct WatchIndex *wi)
+{
+    UBYTE tempName[WALK_PATH_SIZE];
+    ULONG lines = wi->wi_JournalLines;
+    BOOL result = FALSE;
+    BPTR fh;
+    ULONG i;
+
+    OSClose(wi->wi_Journal);
+    wi->wi_Journal = NULL;
+
+    fh = OSCreateTemp(wi->wi_Name, tempName, sizeof(tempName), WATCH_BUFFER_SIZE);
+    if (fh) {
+        wi->wi_Journal = fh;
+        wi->wi_JournalLines = 0;
+        JournalStamp(wi);
+        for (i = 0; i < wi->wi_Count; i++) {
+            JournalEntry(wi, &wi->wi_Entries[i]);
+        }
+        wi->wi_Journal = NULL;
+
+        if (OSClose(fh)) {
+            result = OSCommitTemp((STRPTR)tempName, wi->wi_Name);
+        } else {
+            OSDelete((STRPTR)tempName);
+        }
+    }
+
+    if (result) {
+        wi->wi_Compact = FALSE;
+    } else {
+        wi->wi_JournalLines = lines;
+    }
+
+    /* Carry on appending, to the new file or the old */
+    wi->wi_Journal = OSAppend(wi->wi_Name);
+    if (wi->wi_Journal) {
+        SetVBuf(wi->wi_Journal, NULL, BUF_FULL, WATCH_BUFFER_SIZE);
+    }
+
+    return (BOOL)(result && wi->wi_Journal);
+}
+
+/* Find a watched directory by path */
+static struct WatchDir *FindWatchDir(struct WatchIndex *wi, STRPTR path)
+{
+    struct WatchDir *wd;
+
+    for (wd = (struct WatchDir *)wi->wi_Dirs.mlh_Head;
+         wd->wd_Node.mln_Succ;
+         wd = (struct WatchDir *)wd->wd_Node.mln_Succ) {
+        if (Stricmp(wd->wd_Path, path) == 0) {
+            return wd;
+        }
+    }
+
+    return NULL;
+}
+
+/* Start watching a directory; it counts as seen by its parent's scan */
+static struct WatchDir *AddWatchDir(struct WatchIndex *wi, STRPTR path)
+{
+    struct WatchDir *wd;
+    ULONG length = strlen(path) + 1;
+
+    /* The path lives in the same allocation as the directory */
+    wd = (struct WatchDir *)OSAllocMem(sizeof(struct WatchDir) + length);
+    if (!wd) {
+        return NULL;
+    }
+    wd->wd_Path = (STRPTR)(wd + 1);
+    CopyMem(path, wd->wd_Path, length);
+    wd->wd_Seen = TRUE;
+
+    AddTail((struct List *)&wi->wi_Dirs, (struct Node *)&wd->wd_Node);
+
+    /* Without notification the directory is still scanned at startup */
+    if (wi->wi_Port) {
+        if (OSStartNotify(&wd->wd_Notify, wd->wd_Path, wi->wi_Port, (ULONG)wd)) {
+            wd->wd_Notified = TRUE;
+        } else {
+            wi->wi_Unnotified++;
+        }
+    }
+
+    return wd;
+}
+
+/* Stop watching a directory */
+static VOID RemoveWatchDir(struct WatchDir *wd)
+{
+    Remove((struct Node *)&wd->wd_Node);
+    if (wd->wd_Notified) {
+        OSEndNotify(&wd->wd_Notify);
+    }
+    OSFreeMem(wd);
+}
+
+/* Stop watching the directories below path, and path itself unless belowOnly */
+static VOID RemoveWatchDirs(struct WatchIndex *wi, STRPTR path, BOOL belowOnly)
+{
+    struct WatchDir *wd;
+    struct WatchDir *next;
+    ULONG length = strlen(path);
+
+    for (wd = (struct WatchDir *)wi->wi_Dirs.mlh_Head;
+         (next = (struct WatchDir *)wd->wd_Node.mln_Succ) != NULL;
+         wd = next) {
+        if ((!belowOnly && Stricmp(wd->wd_Path, path) == 0) || PathBelow(path, length, wd->wd_Path)) {
+            RemoveWatchDir(wd);
+        }
+    }
+}
+
+/* Forget a directory that has gone, and everything that was in it */
+static VOID ForgetTree(struct WatchIndex *wi, STRPTR tree)
+{
+    UBYTE path[WALK_PATH_SIZE];
+
+    /* tree may belong to a directory about to be freed */
+    Strncpy(path, tree, sizeof(path));
+
+    RemoveWatchDirs(wi, (STRPTR)path, FALSE);
+    SweepEntries(wi, (STRPTR)path, FALSE, FALSE);
+    SweepEntries(wi, (STRPTR)path, FALSE, TRUE);
+}
+
+/* Work out what a new or changed file is */
+static VOID IdentifyEntry(struct WatchIndex *wi, struct IndexEntry *ie)
+{
+    struct DTContext *ctx = wi->wi_Context;
+    struct DTRecord *record = wi->wi_Record;
+    ULONG fields = ctx->dc_Fields;
+
+    ie->ie_GroupID = 0;
+    ie->ie_BaseName[0] = '\0';
+    ie->ie_Width = 0;
+    ie->ie_Height = 0;
+    ie->ie_Depth = 0;
+    ie->ie_Frames = 0;
+    ie->ie_SamplesPerSec = 0;
+    ie->ie_SampleLength = 0;
+
+    /* Only what the index holds, and of that only what FIELDS= asks for */
+    ctx->dc_Fields = fields & WATCH_FIELDS;
+    if (DTIdentify(ctx, ie->ie_Path, record)) {
+        ie->ie_GroupID = record->dr_GroupID;
+        Strncpy(ie->ie_BaseName, record->dr_BaseName, sizeof(ie->ie_BaseName));
+        if (record->dr_Valid & RECF_DIMS) {
+            ie->ie_Width = record->dr_Width;
+            ie->ie_Height = record->dr_Height;
+            ie->ie_Depth = record->dr_Depth;
+        }
+        if (record->dr_Valid & RECF_FRAMES) {
+            ie->ie_Frames = record->dr_Frames;
+        }
+        if (record->dr_Valid & RECF_AUDIO) {
+            ie->ie_SamplesPerSec = record->dr_SamplesPerSec;
+            ie->ie_SampleLength = record->dr_SampleLength;
+        }
+    }
+    ctx->dc_Fields = fields;
+
+    wi->wi_Identified++;
+}
+
+/* Whether a file is one the watch writes, or a temporary or backup */
+/* file written beside one: "DTxxxxxxxx.tmp" or "DTxxxxxxxx.bak" */
+static BOOL IsOwnFile(struct WatchIndex *wi, STRPTR path)
+{
+    STRPTR name = FilePart(path);
+    ULONG dirLen = PathPart(path) - path;
+    ULONG length = strlen(name);
+    ULONG i;
+
+    for (i = 0; i < wi->wi_OwnCount; i++) {
+        STRPTR own = (STRPTR)wi->wi_Own[i];
+
+        if (Stricmp(own, path) == 0) {
+            return TRUE;
+        }
+        if ((ULONG)(PathPart(own) - own) == dirLen && Strnicmp(own, path, (LONG)dirLen) == 0 &&
+            length == 14 && Strnicmp(name, (STRPTR)"DT", 2) == 0 &&
+            (Stricmp(name + 10, (STRPTR)".tmp") == 0 || Stricmp(name + 10, (STRPTR)".bak") == 0)) {
+            return TRUE;
+        }
+    }
+
+    return FALSE;
+}
+
+/* Compare a file found by a scan with the index, identifying it again */
+/* only if it is new or its size or date have changed */
+static VOID CheckFile(struct WatchIndex *wi, STRPTR path, ULONG size, struct DateStamp *date, BOOL defer)
+{
+    struct IndexEntry *ie;
+    ULONG index;
+
+    /* Left unseen, so an entry from before is dropped */
+    if (IsOwnFile(wi, path)) {
+        return;
+    }
+
+    index = FirstEntryFrom(wi, path);
+    wi->wi_Checked++;
+
+    if (index < wi->wi_Sorted && Stricmp(wi->wi_Entries[index].ie_Path, path) == 0) {
+        ie = &wi->wi_Entries[index];
+        ie->ie_Seen = TRUE;
+        if (ie->ie_Size == size && CompareDates(&ie->ie_Date, date) == 0) {
+            return;
+        }
+    } else {
+        /* One path per journal line */
+        if (strchr((char *)path, '\n')) {
+            return;
+        }
+        ie = AddEntry(wi, path, index, defer);
+        if (!ie) {
+            return;
+        }
+        ie->ie_Seen = TRUE;
+    }
+
+    ie->ie_Size = size;
+    ie->ie_Date = *date;
+    IdentifyEntry(wi, ie);
+    JournalEntry(wi, ie);
+}
+
+/* Read a directory that changed again, and bring its entries up to date */
+static VOID RescanDirectory(struct WatchIndex *wi, struct WatchDir *wd)
+{
+    UBYTE path[WALK_PATH_SIZE];
+    struct OSDir *dir;
+    struct OSDirEntry entry;
+    struct WatchDir *child;
+    STRPTR rest;
+    ULONG dirLen = strlen(wd->wd_Path);
+    BOOL again;
+
+    dir = OSOpenDir(wd->wd_Path, OSDIRF_NOINFO, NULL);
+    if (!dir) {
+        /* Deleted or renamed; its parent's scan finds any new name */
+        ForgetTree(wi, wd->wd_Path);
+        return;
+    }
+
+    SweepEntries(wi, wd->wd_Path, TRUE, FALSE);
+    for (child = (struct WatchDir *)wi->wi_Dirs.mlh_Head;
+         child->wd_Node.mln_Succ;
+         child = (struct WatchDir *)child->wd_Node.mln_Succ) {
+        rest = PathBelow(wd->wd_Path, dirLen, child->wd_Path);
+        if (rest && !strchr((char *)rest, '/')) {
+            child->wd_Seen = FALSE;
+        }
+    }
+
+    while (OSNextDirEntry(dir, &entry)) {
+        Strncpy(path, wd->wd_Path, sizeof(path));
+        if (!AddPart(path, entry.ode_Name, sizeof(path))) {
+            continue;
+        }
+
+        if (entry.ode_Type == ST_USERDIR) {
+            child = FindWatchDir(wi, (STRPTR)path);
+            if (child) {
+                child->wd_Seen = TRUE;
+            } else {
+                WatchTree(wi, (STRPTR)path);
+            }
+        } else if (entry.ode_Type < 0) {
+            CheckFile(wi, (STRPTR)path, entry.ode_Size, &entry.ode_Date, FALSE);
+        }
+    }
+    OSCloseDir(dir);
+
+    SweepEntries(wi, wd->wd_Path, TRUE, TRUE);
+
+    /* Subdirectories that have gone take their trees with them */
+    do {
+        again = FALSE;
+        for (child = (struct WatchDir *)wi->wi_Dirs.mlh_Head;
+             child->wd_Node.mln_Succ;
+             child = (struct WatchDir *)child->wd_Node.mln_Succ) {
+            rest = PathBelow(wd->wd_Path, dirLen, child->wd_Path);
+            if (rest && !strchr((char *)rest, '/') && !child->wd_Seen) {
+                ForgetTree(wi, child->wd_Path);
+                again = TRUE;
+                break;
+            }
+        }
+    } while (again);
+}
+
+/* Take the notifications off the port, marking their directories */
+static ULONG DrainWatchPort(struct WatchIndex *wi)
+{
+    struct NotifyMessage *nm;
+    ULONG count = 0;
+
+    while ((nm = (struct NotifyMessage *)GetMsg(wi->wi_Port)) != NULL) {
+        ((struct WatchDir *)nm->nm_NReq->nr_UserData)->wd_Dirty = TRUE;
+        ReplyMsg((struct Message *)nm);
+        count++;
+    }
+
+    return count;
+}
+
+/* Open an index file, or start a new one, or with no name one kept in */
+/* memory; with notify, directories given to WatchTree() are watched for */
+/* changes as well */
+struct WatchIndex *OpenWatchIndex(struct DTContext *ctx, STRPTR name, BOOL notify)
+{
+    struct WatchIndex *wi;
+    struct OSFileInfo info;
+    ULONG length;
+
+    if (!ctx) {
+        SetIoErr(ERROR_REQUIRED_ARG_MISSING);
+        return NULL;
+    }
+
+    length = name ? strlen(name) + 1 : 0;
+    wi = (struct WatchIndex *)OSAllocMem(sizeof(struct WatchIndex) + length);
+    if (!wi) {
+        SetIoErr(ERROR_NO_FREE_STORE);
+        return NULL;
+    }
+    wi->wi_Context = ctx;
+    if (name) {
+        wi->wi_Name = (STRPTR)(wi + 1);
+        CopyMem(name, wi->wi_Name, length);
+    }
+    NewList((struct List *)&wi->wi_Dirs);
+
+    wi->wi_Record = (struct DTRecord *)OSAllocMem(sizeof(struct DTRecord));
+    if (notify) {
+        wi->wi_Port = CreateMsgPort();
+    }
+    if (!wi->wi_Record || (notify && !wi->wi_Port)) {
+        CloseWatchIndex(wi);
+        SetIoErr(ERROR_NO_FREE_STORE);
+        return NULL;
+    }
+
+    if (OSExamine((STRPTR)"DEVS:Datatypes", &info)) {
+        wi->wi_Stamp = info.ofi_Date;
+    }
+
+    if (!name) {
+        return wi;
+    }
+    IgnoreWatchFile(wi, name);
+
+    LoadWatchIndex(wi);
+
+    wi->wi_Journal = OSAppend(wi->wi_Name);
+    if (!wi->wi_Journal) {
+        LONG error = IoErr();
+
+        CloseWatchIndex(wi);
+        SetIoErr(error);
+        return NULL;
+    }
+    SetVBuf(wi->wi_Journal, NULL, BUF_FULL, WATCH_BUFFER_SIZE);
+
+    if (wi->wi_JournalLines == 0) {
+        JournalStamp(wi);
+    }
+
+    return wi;
+}
+
+/* Leave a file the caller writes out of the index, should it be inside */
+/* a watched tree; the file need not exist yet, but its directory must */
+BOOL IgnoreWatchFile(struct WatchIndex *wi, STRPTR name)
+{
+    UBYTE dir[WALK_PATH_SIZE];
+    UBYTE *own;
+    BPTR lock;
+    BOOL named;
+
+    if (!wi || !name) {
+        SetIoErr(ERROR_REQUIRED_ARG_MISSING);
+        return FALSE;
+    }
+    if (wi->wi_OwnCount == WATCH_OWN_FILES) {
+        SetIoErr(ERROR_NO_FREE_STORE);
+        return FALSE;
+    }
+
+    /* Paths in the index start from the volume, so this one must too */
+    Strncpy(dir, name, sizeof(dir));
+    *PathPart(dir) = '\0';
+    lock = OSLock((STRPTR)dir);
+    if (!lock) {
+        return FALSE;
+    }
+    own = wi->wi_Own[wi->wi_OwnCount];
+    named = OSNameFromLock(lock, (STRPTR)own, WALK_PATH_SIZE);
+    OSUnLock(lock);
+    if (!named || !AddPart(own, FilePart(name), WALK_PATH_SIZE)) {
+        return FALSE;
+    }
+
+    wi->wi_OwnCount++;
+    return TRUE;
+}
+
+/* Bring the index up to date with a directory tree, identifying only */
+/* files that are new or changed, and start watching its directories */
+BOOL WatchTree(struct WatchIndex *wi, STRPTR root)
+{
+    UBYTE path[WALK_PATH_SIZE];
+    struct OSFileInfo info;
+    struct OSWalk *walk;
+    struct OSWalkEntry entry;
+    BPTR lock;
+    BOOL named;
+
+    if (!wi || !root) {
+        SetIoErr(ERROR_REQUIRED_ARG_MISSING);
+        return FALSE;
+    }
+
+    /* Paths in the index start from the volume */
+    lock = OSLock(root);
+    if (!lock) {
+        return FALSE;
+    }
+    if (!OSExamineLock(lock, &info) || info.ofi_Type < 0) {
+        OSUnLock(lock);
+        SetIoErr(ERROR_OBJECT_WRONG_TYPE);
+        return FALSE;
+    }
+    named = OSNameFromLock(lock, (STRPTR)path, sizeof(path));
+    OSUnLock(lock);
+    if (!named) {
+        return FALSE;
+    }
+
+    /* Inside a tree already watched */
+    if (FindWatchDir(wi, (STRPTR)path)) {
+        return TRUE;
+    }
+
+    walk = OSOpenWalk((STRPTR)path, OSDIRF_NOINFO, NULL);
+    if (!walk) {
+        return FALSE;
+    }
+
+    /* Trees named before that are inside this one are watched again with it */
+    RemoveWatchDirs(wi, (STRPTR)path, TRUE);
+    if (!AddWatchDir(wi, (STRPTR)path)) {
+        OSCloseWalk(walk);
+        SetIoErr(ERROR_NO_FREE_STORE);
+        return FALSE;
+    }
+
+    /* New files wait at the end, to be sorted in once */
+    SweepEntries(wi, (STRPTR)path, FALSE, FALSE);
+    while (OSNextWalkEntry(walk, &entry)) {
+        if (entry.owe_Type == ST_USERDIR) {
+            AddWatchDir(wi, entry.owe_Path);
+        } else if (entry.owe_Type < 0) {
+            CheckFile(wi, entry.owe_Path, entry.owe_Size, &entry.owe_Date, TRUE);
+        }
+    }
+    OSCloseWalk(walk);
+
+    SortEntries(wi);
+    SweepEntries(wi, (STRPTR)path, FALSE, TRUE);
+
+    return TRUE;
+}
+
+/* Let a burst of notifications settle, then scan the directories they */
+/* were for. Returns the files identified or removed. */
+ULONG UpdateWatchIndex(struct WatchIndex *wi)
+{
+    struct WatchDir *wd;
+    ULONG before;
+    ULONG waited = 0;
+    BOOL again;
+
+    if (!wi || !wi->wi_Port) {
+        return 0;
+    }
+
+    /* Scan once no more messages come for WATCH_SETTLE_TICKS, or after */
+    /* WATCH_MAX_TICKS of steady changes */
+    while (DrainWatchPort(wi) > 0 && waited < WATCH_MAX_TICKS) {
+        if (SetSignal(0, 0) & SIGBREAKF_CTRL_C) {
+            return 0;
+        }
+        Delay(WATCH_SETTLE_TICKS);
+        waited += WATCH_SETTLE_TICKS;
+    }
+
+    before = wi->wi_Identified + wi->wi_Removed;
+
+    /* A scan may add and remove directories, so start over after each */
+    do {
+        again = FALSE;
+        for (wd = (struct WatchDir *)wi->wi_Dirs.mlh_Head;
+             wd->wd_Node.mln_Succ;
+             wd = (struct WatchDir *)wd->wd_Node.mln_Succ) {
+            if (wd->wd_Dirty) {
+                wd->wd_Dirty = FALSE;
+                RescanDirectory(wi, wd);
+                again = TRUE;
+                break;
+            }
+        }
+    } while (again);
+
+    FlushWatchIndex(wi);
+
+    return wi->wi_Identified + wi->wi_Removed - before;
+}
+
+/* Write out what the journal holds, compacting it if it has grown */
+BOOL FlushWatchIndex(struct WatchIndex *wi)
+{
+    if (!wi) {
+        return FALSE;
+    }
+    if (!wi->wi_Name) {
+        return TRUE;
+    }
+    if (!wi->wi_Journal) {
+        return FALSE;
+    }
+
+    if (wi->wi_Compact || wi->wi_JournalLines > wi->wi_Count * 2 + WATCH_COMPACT_SLACK) {
+        return CompactWatchIndex(wi);
+    }
+
+    return (BOOL)(Flush(wi->wi_Journal) != 0);
+}
+
+/* Stop watching, write out the index and free it */
+VOID CloseWatchIndex(struct WatchIndex *wi)
+{
+    struct WatchDir *wd;
+    ULONG i;
+
+    if (!wi) {
+        return;
+    }
+
+    /* Queued messages point at their directories, so they go first */
+    if (wi->wi_Port) {
+        DrainWatchPort(wi);
+    }
+    while ((wd = (struct WatchDir *)wi->wi_Dirs.mlh_Head)->wd_Node.mln_Succ) {
+        RemoveWatchDir(wd);
+    }
+    if (wi->wi_Port) {
+        DeleteMsgPort(wi->wi_Port);
+    }
+
+    if (wi->wi_Journal) {
+        FlushWatchIndex(wi);
+        OSClose(wi->wi_Journal);
+    }
+
+    for (i = 0; i < wi->wi_Count; i++) {
+        OSFreeMem(wi->wi_Entries[i].ie_Path);
+    }
+    OSFreeMem(wi->wi_Entries);
+    OSFreeMem(wi->wi_Record);
+    OSFreeMem(wi);
+}
+
+/* Write the catalogue of what the index holds, reporting a failure */
+static BOOL UpdateCatalog(struct WatchIndex *wi, STRPTR catalogName)
+{
+    if (!WriteCatalog(catalogName, wi->wi_Entries, wi->wi_Count)) {
+        PrintFault(IoErr(), catalogName);
+        return FALSE;
+    }
+    return TRUE;
+}
+
+/* WATCH: index the trees, then keep the index current until CTRL-C */
+/* With CATALOG=, write a catalogue of them as well, and again after */
+/* each change; without WATCH, write it once and return */
+LONG RunWatch(struct DTContext *ctx, STRPTR *roots, ULONG count, STRPTR indexName, STRPTR catalogName, BOOL watch)
+{
+    struct WatchIndex *wi;
+    LONG result = RETURN_OK;
+    ULONG signals;
+    ULONG changed;
+    ULONG i;
+
+    wi = OpenWatchIndex(ctx, indexName, watch);
+    if (!wi) {
+        PrintFault(IoErr(), indexName);
+        return RETURN_FAIL;
+    }
+    if (catalogName && !IgnoreWatchFile(wi, catalogName)) {
+        PrintFault(IoErr(), catalogName);
+        CloseWatchIndex(wi);
+        return RETURN_FAIL;
+    }
+
+    for (i = 0; i < count; i++) {
+        if (!WatchTree(wi, roots[i])) {
+            PrintFault(IoErr(), roots[i]);
+            result = RETURN_WARN;
+        }
+    }
+    if (!FlushWatchIndex(wi)) {
+        PrintFault(IoErr(), indexName);
+        result = RETURN_WARN;
+    }
+    if (catalogName && !UpdateCatalog(wi, catalogName)) {
+        result = RETURN_FAIL;
+    }
+
+    Printf("Indexed %lu files (%lu identified, %lu removed)", wi->wi_Count, wi->wi_Identified, wi->wi_Removed);
+    if (wi->wi_Unnotified > 0) {
+        Printf("; %lu directories cannot be watched", wi->wi_Unnotified);
+    }
+    Printf("\n");
+
+    if (!watch || result == RETURN_FAIL) {
+        CloseWatchIndex(wi);
+        return result;
+    }
+    Printf("Watching for changes (CTRL-C to stop)\n");
+
+    for (;;) {
+        signals = Wait((1L << wi->wi_Port->mp_SigBit) | SIGBREAKF_CTRL_C);
+        if (signals & SIGBREAKF_CTRL_C) {
+            break;
+        }
+
+        wi->wi_Identified = 0;
+        wi->wi_Removed = 0;
+        changed = UpdateWatchIndex(wi);
+        if (changed > 0) {
+            Printf("Updated %lu files (%lu identified, %lu removed), %lu indexed\n",
+                   changed, wi->wi_Identified, wi->wi_Removed, wi->wi_Count);
+            if (catalogName && !UpdateCatalog(wi, catalogName)) {
+                result = RETURN_WARN;
+            }
+        }
+    }
+
+    CloseWatchIndex(wi);
+
+    return result;
+}